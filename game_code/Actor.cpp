@@ -3,8 +3,11 @@
 #include <cstdlib>
 
 #include "Actor.h"
-#include "Weapon.h"
+#include "Combat.h"
 #include "Dungeon.h"
+#include "UndoLog.h"
+#include "GameState.h"
+#include "Rules.h"
 #include "utilities.h"
 
 using namespace std;
@@ -14,12 +17,12 @@ using namespace std;
 ////////////////////////////////////////////////////////////////////
 
 /////////////////////////////////////////////////////////////////
-// Constructor and Destructor 
+// Constructor 
 
 Actor::Actor(int row, int col, Dungeon* dungeon,int hitPts, 
 		int armorPts, int strengthPts, int dexterityPts, 
-		int sleepPts, Weapon* weapon)
-	: m_dungeon(dungeon), m_weapon(weapon)
+		int sleepPts, const WeaponItem& weapon)
+	: m_dungeon(dungeon), m_energy(0), m_weapon(weapon), m_key(0)
 {
 	// Verifying and setting position
 	if (!setPos(row, col))
@@ -41,11 +44,6 @@ Actor::Actor(int row, int col, Dungeon* dungeon,int hitPts,
 	}
 }
 
-Actor::~Actor()
-{
-	delete m_weapon;
-}
-
 /////////////////////////////////////////////////////////////////
 // Setters
 
@@ -54,11 +52,21 @@ bool Actor::setPos(int row, int col)
 {
 	if(row < 0 || col < 0) 
 		return false;
+	if(isLogged()) dungeon()->undoLog()->moved(this, m_row, m_col);
 	m_row = row;
 	m_col = col;
+	rekey();
 	return true;
 }
 
+// Weapon
+void Actor::setWeapon(const WeaponItem& weapon)
+{
+	if(isLogged()) dungeon()->undoLog()->weaponChanged(this, m_weapon);
+	m_weapon = weapon;
+	rekey();
+}
+
 /////////////////////////////////////////////////////////////////
 // Helper Functions
 
@@ -69,7 +77,9 @@ bool Actor::takeDamage(int damage)
 	if(damage < 0) return false;
 
 	// Reduce hit points by damage taken
+	if(isLogged()) logStat(STATHIT, m_hit);
 	m_hit -= damage;
+	rekey();
 	return true;
 }
 
@@ -78,34 +88,98 @@ bool Actor::takeDamage(int damage)
 
 string Actor::attemptAttack(Actor* defender)
 	// Try to attack the defender with weapon 
+	// (a batch of one attack)
+{
+	CombatBatch batch;
+	queueAttack(batch, defender);
+	batch.resolve(dungeon()->rng());
+	return applyAttack(defender, batch.hit(0), batch.damage(0));
+}
+
+int Actor::queueAttack(CombatBatch& batch, const Actor* defender) const
+{
+	ActorState attacker, defending;
+	captureActor(*this, attacker);
+	captureActor(*defender, defending);
+	return addAttack(batch, attacker, defending);
+}
+
+string Actor::applyAttack(Actor* defender, bool hit, int damagePts)
+	// Carry out an attack resolved in a batch
 {
 	// Indicating attempt to attack with weapon
 	string result = this->name() + " " + 
-					this->weapon()->action() + " " +
+					this->weapon().action() + " " +
 					defender->name();
 
-	int attackerPts = this->dexterityPts() 
-					  + this->weapon()->dexterityBns();
-	int defenderPts = defender->dexterityPts() + defender->armorPts();	
-	if(randInt(1, attackerPts) >= randInt(1, defenderPts))
+	if(hit)
 		// Attacker hits defender with weapon
 	{
-		// Calucate the damage done
-		int damagePts = randInt(0, this->strengthPts() 
-								+ weapon()->damageAmt() - 1); 
-		// Do the damage
-		defender->takeDamage(damagePts);
+		// Do the damage, and the weapon's special move if any
+		ActorState attacker, before, after;
+		captureActor(*this, attacker);
+		captureActor(*defender, before);
+		after = before;
+		bool slept = landHit(attacker, after, damagePts, dungeon()->rng());
+		updateActor(before, after, *defender);
 		if(defender->isDead())
 		{
 			// Indicating defender is dead
 			return result + " dealing a final blow.";  
 		}
 
-		// Do weapon special moves, if any
-		result +=" and hits" + weapon()->specialMove(this, defender);
-		
-		return result;
+		if(slept)
+			return result + " and hits, putting " + defender->name() + " to sleep.";
+		return result + " and hits.";
 	}
 	// Attacker misses
 	return result  + " and misses.";
-}
\ No newline at end of file
+}
+
+/////////////////////////////////////////////////////////////////
+// Undo
+
+void Actor::logStat(ActorStat stat, int value)
+{
+	dungeon()->undoLog()->statChanged(this, stat, value);
+}
+
+void Actor::undo(const UndoRecord& record, UndoLog& log)
+	// Members are set directly: the values put back were held once,
+	// hit points below zero included
+{
+	switch(record.op)
+	{
+		case UndoRecord::MOVE:
+			m_row = record.a;
+			m_col = record.b;
+			break;
+		case UndoRecord::WEAPON:
+			m_weapon = log.popWeapon();
+			break;
+		case UndoRecord::STAT:
+			switch(record.stat)
+			{
+				case STATHIT:       m_hit = record.a; break;
+				case STATARMOR:     m_armor = record.a; break;
+				case STATSTRENGTH:  m_strength = record.a; break;
+				case STATDEXTERITY: m_dexterity = record.a; break;
+				case STATSLEEP:     m_sleep = record.a; break;
+				case STATENERGY:    m_energy = record.a; break;
+			}
+			break;
+	}
+	rekey();
+}
+
+/////////////////////////////////////////////////////////////////
+// Key
+
+void Actor::rekey()
+{
+	uint64_t key = workOutKey();
+	if(key == m_key) return;
+	uint64_t change = key ^ m_key;
+	m_key = key;
+	keyChanged(change);
+}
@@ -4,6 +4,11 @@
 #define ACTOR_INCLUDED
 
 #include <string>
+#include <cstdint>
+
+#include "Item.h"
+#include "Dungeon.h"
+#include "SlotMap.h"
 
 const int MAXHIT = 99;
 const int MAXARMOR = 99;
@@ -11,9 +16,23 @@ const int MAXSTRENGTH = 99;
 const int MAXDEXTERITY = 99;
 const int MAXSLEEP = 9;
 
-class Weapon;
-class GameObject;
-class Dungeon;
+// Real-time games: every tick an actor gains its speed in energy and
+// acts once it has ACTIONENERGY, so speed NORMALSPEED acts once in
+// ACTIONENERGY/NORMALSPEED ticks
+const int NORMALSPEED = 10;
+const int MAXSPEED = 100;
+const int ACTIONENERGY = 100;
+
+class CombatBatch;
+class UndoLog;
+struct UndoRecord;
+
+// Stats of an actor, as an undo log records them (see UndoLog.h)
+enum ActorStat
+{
+	STATHIT, STATARMOR, STATSTRENGTH, STATDEXTERITY, STATSLEEP,
+	STATENERGY, STATMAXHIT, STATKILLEDBY
+};
 
 ////////////////////////////////////////////////////////////////////
 // Base Actor Class Declarations
@@ -26,9 +45,10 @@ class Actor
 	// Constructor and Destructor
 
 	Actor(int row, int col, Dungeon* dungeon, int hitPts, 
-		int armorPts, int strengthPts, int dexterityPts, int sleepPts, Weapon* weapon);
+		int armorPts, int strengthPts, int dexterityPts, int sleepPts,
+		const WeaponItem& weapon);
 
-	virtual ~Actor();
+	virtual ~Actor() {}
 	
 	/////////////////////////////////////////////////////////////////
 	// Accessors
@@ -46,13 +66,22 @@ class Actor
 	int strengthPts() const  {return m_strength;}
 	int dexterityPts() const {return m_dexterity;}
 	int sleepPts() const     {return m_sleep;}
+	int energy() const       {return m_energy;}
 
 	// Weapon
-	Weapon* weapon() const   {return m_weapon;}
+	const WeaponItem& weapon() const {return m_weapon;}
 
 	// Name and symbol (Unique for each Actor)
 	virtual std::string name() const = 0;
 	virtual char symbol() const = 0;
+
+	// Handle of the actor in its Dungeon (see SlotMap.h), which
+	// players have none of
+	virtual SlotHandle handle() const {return SlotHandle();}
+
+	// Zobrist key of the actor as a GameState hashes it (see
+	// GameState.h), kept up to date as it changes
+	uint64_t key() const {return m_key;}
 	
 	/////////////////////////////////////////////////////////////////
 	// Setters
@@ -66,12 +95,13 @@ class Actor
 	bool setStrengthPts(int strengthPts);
 	bool setDexterityPts(int dexterityPts);
 	bool setSleepPts(int sleepPts);
+	void setEnergy(int energy);
 
 	// Dungeon
 	void setDungeon(Dungeon* dungeon) {m_dungeon = dungeon;}
 
 	// Weapon
-	void setWeapon(Weapon* weapon) {m_weapon = weapon;}
+	void setWeapon(const WeaponItem& weapon);
 
 	/////////////////////////////////////////////////////////////////
 	// Helper Functions
@@ -79,13 +109,48 @@ class Actor
 	bool isDead() const {return m_hit <= 0;}
 	bool isAsleep() const {return m_sleep > 0;}
 	bool takeDamage(int damage);
-	void reduceSleep() {if(isAsleep()) m_sleep--;}
+	void reduceSleep() {if(isAsleep()) setSleepPts(m_sleep - 1);}
+
+	// Real-time games: gain speed energy for a tick (an actor waiting
+	// to act banks no more than one action), and whether there is
+	// enough to act, spending it if so
+	void gainEnergy(int speed);
+	bool spendEnergy();
 
 	/////////////////////////////////////////////////////////////////
 	// Game Functions
 
 	std::string attemptAttack(Actor* defender);
 
+	// Attacks resolved together (see Combat.h): queue an attack on
+	// defender in batch (returning its index, -1 if the batch is
+	// full), then carry it out once resolved, returning the message
+	int queueAttack(CombatBatch& batch, const Actor* defender) const;
+	std::string applyAttack(Actor* defender, bool hit, int damage);
+
+	// Take back the change of record, made to this actor (see
+	// UndoLog.h)
+	virtual void undo(const UndoRecord& record, UndoLog& log);
+
+  protected:
+	/////////////////////////////////////////////////////////////////
+	// Recording changes while the level keeps an undo log
+
+	bool isLogged() const {return m_dungeon && m_dungeon->undoLog();}
+	void logStat(ActorStat stat, int value); // value before the change
+
+	/////////////////////////////////////////////////////////////////
+	// Keeping the key up to date
+
+	// Work the key out again after a change to what it covers,
+	// passing the change on (actors made call it once they are)
+	void rekey();
+	// The key worked out from scratch (none for a plain Actor, as
+	// while it is being made)
+	virtual uint64_t workOutKey() const {return 0;}
+	// The key changed by change (XOR)
+	virtual void keyChanged(uint64_t /*change*/) {}
+
   private:
 	/////////////////////////////////////////////////////////////////
 
@@ -102,9 +167,12 @@ class Actor
 	int m_strength;
 	int m_dexterity;
 	int m_sleep;
+	int m_energy; // Real-time games only
 
 	// Weapon
-	Weapon* m_weapon;
+	WeaponItem m_weapon;
+
+	uint64_t m_key; // Zobrist key
 
 	/////////////////////////////////////////////////////////////////
 };
@@ -117,35 +185,66 @@ inline
 bool Actor::setHitPts(int hitPts)
 {
 	if(hitPts < 0 || hitPts > MAXHIT) return false;
-	m_hit = hitPts; return true;
+	if(isLogged()) logStat(STATHIT, m_hit);
+	m_hit = hitPts; rekey(); return true;
 }
 
 inline
 bool Actor::setArmorPts(int armorPts)
 {
 	if(armorPts < 0 || armorPts > MAXARMOR) return false;
-	m_armor = armorPts; return true;	
+	if(isLogged()) logStat(STATARMOR, m_armor);
+	m_armor = armorPts; rekey(); return true;	
 }
 
 inline
 bool Actor::setStrengthPts(int strengthPts)
 {
 	if(strengthPts < 0 || strengthPts > MAXSTRENGTH) return false;
-	m_strength = strengthPts; return true;	
+	if(isLogged()) logStat(STATSTRENGTH, m_strength);
+	m_strength = strengthPts; rekey(); return true;	
 }
 
 inline
 bool Actor::setDexterityPts(int dexterityPts)
 {
 	if(dexterityPts < 0 || dexterityPts > MAXDEXTERITY) return false;
-	m_dexterity = dexterityPts; return true;	
+	if(isLogged()) logStat(STATDEXTERITY, m_dexterity);
+	m_dexterity = dexterityPts; rekey(); return true;	
 }
 
 inline
 bool Actor::setSleepPts(int sleepPts)
 {
 	if(sleepPts < 0 || sleepPts > MAXSLEEP) return false;
-	m_sleep = sleepPts; return true;	
+	if(isLogged()) logStat(STATSLEEP, m_sleep);
+	m_sleep = sleepPts; rekey(); return true;	
+}
+
+// Real-time energy
+inline
+void Actor::setEnergy(int energy)
+{
+	if(isLogged()) logStat(STATENERGY, m_energy);
+	m_energy = energy;
+}
+
+inline
+void Actor::gainEnergy(int speed)
+{
+	// Never more than an actor acting as soon as it can would have
+	if(isLogged()) logStat(STATENERGY, m_energy);
+	m_energy += speed;
+	if(m_energy > ACTIONENERGY - 1 + speed) m_energy = ACTIONENERGY - 1 + speed;
+}
+
+inline
+bool Actor::spendEnergy()
+{
+	if(m_energy < ACTIONENERGY) return false;
+	if(isLogged()) logStat(STATENERGY, m_energy);
+	m_energy -= ACTIONENERGY;
+	return true;
 }
 
 #endif // ACTOR_INCLUDED
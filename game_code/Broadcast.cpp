@@ -0,0 +1,172 @@
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Broadcast.h"
+
+using namespace std;
+
+static const char BROADCASTMAGIC[8] = {'M', 'R', 'B', 'C', 'A', 'S', 'T', '1'};
+
+static_assert(atomic<uint64_t>::is_always_lock_free,
+	"Shared memory counters must be lock free");
+
+////////////////////////////////////////////////////////////////////
+// Broadcaster Class Implementation
+////////////////////////////////////////////////////////////////////
+
+Broadcaster::Broadcaster(const string& name)
+	: m_name(name), m_published(0)
+{
+	int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+	if(fd < 0 || ftruncate(fd, sizeof(BroadcastRing)) != 0)
+	{
+		cerr << "Error: Can't create broadcast " << name << endl;
+		exit(1);
+	}
+	void* data = mmap(nullptr, sizeof(BroadcastRing), PROT_READ | PROT_WRITE,
+		MAP_SHARED, fd, 0);
+	close(fd);
+	if(data == MAP_FAILED)
+	{
+		cerr << "Error: Can't map broadcast " << name << endl;
+		exit(1);
+	}
+
+	// Starting an empty ring (the magic last, so viewers attaching
+	// meanwhile see an unfinished ring)
+	m_ring = static_cast<BroadcastRing*>(data);
+	memset(m_ring->magic, 0, sizeof(m_ring->magic));
+	m_ring->numSlots = BROADCASTSLOTS;
+	m_ring->frameBytes = sizeof(Frame);
+	new (&m_ring->published) atomic<uint64_t>(0);
+	new (&m_ring->closed) atomic<uint32_t>(0);
+	for(int s = 0; s < BROADCASTSLOTS; s++)
+		new (&m_ring->slots[s].sequence) atomic<uint64_t>(0);
+	atomic_thread_fence(memory_order_release);
+	memcpy(m_ring->magic, BROADCASTMAGIC, sizeof(BROADCASTMAGIC));
+}
+
+Broadcaster::~Broadcaster()
+{
+	m_ring->closed.store(1, memory_order_release);
+	munmap(m_ring, sizeof(BroadcastRing));
+	shm_unlink(m_name.c_str()); // Viewers keep their mapping until they detach
+}
+
+void Broadcaster::publish(const Frame& frame)
+{
+	BroadcastSlot& slot = m_ring->slots[m_published % BROADCASTSLOTS];
+
+	// Odd while writing, then even again with the frame's number
+	slot.sequence.store(2 * m_published + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	memcpy(&slot.frame, &frame, sizeof(Frame));
+	slot.sequence.store(2 * m_published + 2, memory_order_release);
+
+	m_published++;
+	m_ring->published.store(m_published, memory_order_release);
+}
+
+////////////////////////////////////////////////////////////////////
+// BroadcastViewer Class Implementation
+////////////////////////////////////////////////////////////////////
+
+BroadcastViewer::BroadcastViewer(const string& name)
+	: m_next(0), m_read(0), m_missed(0)
+{
+	int fd = shm_open(name.c_str(), O_RDONLY, 0);
+	struct stat info;
+	if(fd < 0 || fstat(fd, &info) != 0 || size_t(info.st_size) < sizeof(BroadcastRing))
+	{
+		cerr << "Error: No broadcast called " << name << endl;
+		exit(1);
+	}
+	void* data = mmap(nullptr, sizeof(BroadcastRing), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(data == MAP_FAILED)
+	{
+		cerr << "Error: Can't map broadcast " << name << endl;
+		exit(1);
+	}
+
+	m_ring = static_cast<const BroadcastRing*>(data);
+	if(memcmp(m_ring->magic, BROADCASTMAGIC, sizeof(BROADCASTMAGIC)) != 0
+		|| m_ring->numSlots != BROADCASTSLOTS || m_ring->frameBytes != sizeof(Frame))
+	{
+		cerr << "Error: " << name << " is not a broadcast of this version" << endl;
+		exit(1);
+	}
+	atomic_thread_fence(memory_order_acquire);
+}
+
+BroadcastViewer::~BroadcastViewer()
+{
+	munmap(const_cast<BroadcastRing*>(m_ring), sizeof(BroadcastRing));
+}
+
+bool BroadcastViewer::isClosed() const
+{
+	return m_ring->closed.load(memory_order_acquire) != 0;
+}
+
+bool BroadcastViewer::readFrame(uint64_t number, Frame& frame) const
+	// Copy frame number from its slot; false if it was overwritten
+{
+	const BroadcastSlot& slot = m_ring->slots[number % BROADCASTSLOTS];
+	uint64_t before = slot.sequence.load(memory_order_acquire);
+	if(before != 2 * number + 2)
+		return false;
+	memcpy(&frame, &slot.frame, sizeof(Frame));
+	atomic_thread_fence(memory_order_acquire);
+	return slot.sequence.load(memory_order_relaxed) == before;
+}
+
+bool BroadcastViewer::readLatest(Frame& frame)
+{
+	for(;;)
+	{
+		uint64_t published = m_ring->published.load(memory_order_acquire);
+		if(published <= m_next)
+			return false;
+		if(readFrame(published - 1, frame))
+		{
+			m_missed += published - 1 - m_next;
+			m_next = published;
+			m_read++;
+			return true;
+		}
+		// Overwritten while copying: the writer lapped us, try the newer one
+	}
+}
+
+bool BroadcastViewer::readNext(Frame& frame)
+{
+	for(;;)
+	{
+		uint64_t published = m_ring->published.load(memory_order_acquire);
+		if(published <= m_next)
+			return false;
+
+		// Too far behind: skipping to the oldest frame still in the ring
+		if(published - m_next > BROADCASTSLOTS)
+		{
+			m_missed += published - BROADCASTSLOTS - m_next;
+			m_next = published - BROADCASTSLOTS;
+		}
+		if(readFrame(m_next, frame))
+		{
+			m_next++;
+			m_read++;
+			return true;
+		}
+		m_missed++; // Overwritten while copying
+		m_next++;
+	}
+}
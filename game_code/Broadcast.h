@@ -0,0 +1,109 @@
+// Broadcast.h
+
+#ifndef BROADCAST_INCLUDED
+#define BROADCAST_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <atomic>
+
+#include "Spectator.h"
+
+const int BROADCASTSLOTS = 64; // Frames kept in the ring
+
+////////////////////////////////////////////////////////////////////
+// Frame Broadcast
+//
+// A game publishes its frames into a ring of BROADCASTSLOTS slots in
+// POSIX shared memory (shm_open name, e.g. "/minirouge"), and any
+// number of viewer processes map the ring read-only and follow it.
+//
+// There is a single writer and no locks. Every slot has a sequence
+// number that is odd while the slot is being written, so readers
+// copy a frame and then check that the sequence didn't move (a
+// seqlock). Readers never write to the shared memory, so they can't
+// slow the game down, and a reader that falls more than a ring
+// behind skips to the newest frame.
+////////////////////////////////////////////////////////////////////
+
+struct BroadcastSlot
+{
+	std::atomic<uint64_t> sequence; // 2*frame+1 while writing, 2*frame+2 once written
+	Frame frame;
+};
+
+struct BroadcastRing
+{
+	char magic[8];                  // "MRBCAST1"
+	uint32_t numSlots;
+	uint32_t frameBytes;            // sizeof(Frame) of the writer
+	std::atomic<uint64_t> published; // Frames published so far
+	std::atomic<uint32_t> closed;    // Writer has finished
+	BroadcastSlot slots[BROADCASTSLOTS];
+};
+
+////////////////////////////////////////////////////////////////////
+// Broadcaster: the game's side (a FrameSink, so it can be fed by
+// a Spectator or directly)
+////////////////////////////////////////////////////////////////////
+
+class Broadcaster : public FrameSink
+{
+  public:
+	// Creates (or takes over) the shared memory called name
+	Broadcaster(const std::string& name);
+	~Broadcaster(); // Marks the ring closed and unlinks the name
+
+	// Publish a frame (never waits)
+	void publish(const Frame& frame);
+	virtual void write(const Frame& frame) {publish(frame);}
+
+  private:
+	std::string m_name;
+	BroadcastRing* m_ring;
+	uint64_t m_published;
+
+	// Broadcasters own a mapping, so they are not copied
+	Broadcaster(const Broadcaster&);
+	Broadcaster& operator=(const Broadcaster&);
+};
+
+////////////////////////////////////////////////////////////////////
+// BroadcastViewer: a viewer's side
+////////////////////////////////////////////////////////////////////
+
+class BroadcastViewer
+{
+  public:
+	// Maps the shared memory called name read-only
+	BroadcastViewer(const std::string& name);
+	~BroadcastViewer();
+
+	// Copy the newest frame not read yet into frame. Returns false
+	// if there is none (yet).
+	bool readLatest(Frame& frame);
+
+	// Copy the next frame in order into frame, skipping ahead when
+	// frames were overwritten before being read. Returns false if
+	// there is none (yet).
+	bool readNext(Frame& frame);
+
+	bool isClosed() const;           // Writer has finished
+	uint64_t framesRead() const {return m_read;}
+	uint64_t framesMissed() const {return m_missed;} // Overwritten unread
+
+  private:
+	const BroadcastRing* m_ring;
+	uint64_t m_next;   // Number of the next frame to read
+	uint64_t m_read;
+	uint64_t m_missed;
+
+	// Private Helper Functions
+	bool readFrame(uint64_t number, Frame& frame) const;
+
+	// Viewers own a mapping, so they are not copied
+	BroadcastViewer(const BroadcastViewer&);
+	BroadcastViewer& operator=(const BroadcastViewer&);
+};
+
+#endif // BROADCAST_INCLUDED
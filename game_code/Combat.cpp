@@ -0,0 +1,60 @@
+#include "Combat.h"
+
+using namespace std;
+
+static inline int scaleDraw(uint32_t draw, int lowest, int highest)
+	// Rng::randInt(lowest, highest) from a draw already made
+{
+	int low = (lowest < highest) ? lowest : highest;
+	int high = (lowest < highest) ? highest : lowest;
+	uint64_t range = uint64_t(int64_t(high) - low + 1);
+	return int(low + int64_t((uint64_t(draw) * range) >> 32));
+}
+
+////////////////////////////////////////////////////////////////////
+// CombatBatch Class Implementation
+////////////////////////////////////////////////////////////////////
+
+int CombatBatch::add(int attackPts, int defensePts, int damageRange)
+{
+	if(isFull()) return -1;
+	m_attackPts[m_size] = attackPts;
+	m_defensePts[m_size] = defensePts;
+	m_damageRange[m_size] = damageRange;
+	return m_size++;
+}
+
+void CombatBatch::resolve(Rng& rng)
+{
+	int n = m_size;
+
+	// All the draws first, attack by attack
+	for(int i = 0; i < n; i++)
+	{
+		m_attackDraw[i] = rng.next();
+		m_defenseDraw[i] = rng.next();
+		m_damageDraw[i] = rng.next();
+	}
+
+	// Padding the last block with harmless attacks, so every block is
+	// full and its loop has a fixed count the compiler can vectorize
+	// even at -O2
+	int padded = (n + COMBATBLOCK - 1) / COMBATBLOCK * COMBATBLOCK;
+	for(int i = n; i < padded; i++)
+	{
+		m_attackPts[i] = m_defensePts[i] = m_damageRange[i] = 1;
+		m_attackDraw[i] = m_defenseDraw[i] = m_damageDraw[i] = 0;
+	}
+
+	// Then every attack at once
+	for(int block = 0; block < padded; block += COMBATBLOCK)
+		for(int i = block; i < block + COMBATBLOCK; i++)
+		{
+			int attackRoll = scaleDraw(m_attackDraw[i], 1, m_attackPts[i]);
+			int defenseRoll = scaleDraw(m_defenseDraw[i], 1, m_defensePts[i]);
+			int damageRoll = scaleDraw(m_damageDraw[i], 0, m_damageRange[i] - 1);
+			int hit = attackRoll >= defenseRoll;
+			m_hit[i] = hit;
+			m_damage[i] = hit ? damageRoll : 0;
+		}
+}
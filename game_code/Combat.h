@@ -0,0 +1,75 @@
+// Combat.h
+
+#ifndef COMBAT_INCLUDED
+#define COMBAT_INCLUDED
+
+#include <cstdint>
+
+#include "Rng.h"
+
+const int MAXBATCHATTACKS = 128; // Attacks resolved in one pass
+const int COMBATBLOCK = 8;       // Attacks resolved by one vector loop
+
+////////////////////////////////////////////////////////////////////
+// Combat Resolution
+//
+// The attacks of a phase of a turn (the player's attack, then every
+// attack the monsters make) are gathered into a CombatBatch and
+// resolved together. For each attack the batch keeps, in arrays of
+// their own:
+//
+//   attack points   attacker's dexterity + weapon's dexterity bonus
+//   defense points  defender's dexterity + armor
+//   damage range    attacker's strength + weapon's damage
+//
+// resolve draws three random numbers for every attack in one go
+// (attack roll, defense roll, damage roll; the damage is drawn even
+// for a miss, so the draws don't depend on the outcome), then works
+// out every hit and its damage in a single branch-free pass over the
+// arrays that the compiler can vectorize. Rolls are scaled the same
+// way as Rng::randInt: an attack hits when a roll from 1 to the
+// attack points is at least a roll from 1 to the defense points, and
+// does 0 to damage range - 1 damage.
+//
+// Applying the results is left to the caller, in the order the
+// attacks were added: damage, deaths and the sleep of magic fangs
+// (which draws its own numbers, so it comes after the batch).
+////////////////////////////////////////////////////////////////////
+
+class CombatBatch
+{
+  public:
+	CombatBatch() : m_size(0) {}
+
+	// Queue an attack, returns its index (-1 if the batch is full)
+	int add(int attackPts, int defensePts, int damageRange);
+	// Draw for and resolve every attack queued
+	void resolve(Rng& rng);
+	// Forget the attacks, to start another batch
+	void clear() {m_size = 0;}
+
+	int size() const {return m_size;}
+	bool isFull() const {return m_size == MAXBATCHATTACKS;}
+	// Results of attack i (after resolve)
+	bool hit(int i) const {return m_hit[i] != 0;}
+	int damage(int i) const {return m_damage[i];}
+
+  private:
+	int m_size;
+
+	// Inputs
+	alignas(32) int m_attackPts[MAXBATCHATTACKS];
+	alignas(32) int m_defensePts[MAXBATCHATTACKS];
+	alignas(32) int m_damageRange[MAXBATCHATTACKS];
+
+	// Random draws
+	alignas(32) uint32_t m_attackDraw[MAXBATCHATTACKS];
+	alignas(32) uint32_t m_defenseDraw[MAXBATCHATTACKS];
+	alignas(32) uint32_t m_damageDraw[MAXBATCHATTACKS];
+
+	// Results (0 damage for a miss)
+	alignas(32) int m_hit[MAXBATCHATTACKS];
+	alignas(32) int m_damage[MAXBATCHATTACKS];
+};
+
+#endif // COMBAT_INCLUDED
@@ -0,0 +1,623 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <iomanip>
+#include <cmath>
+#include <vector>
+
+#include "Definitions.h"
+#include "Actor.h"
+#include "Dungeon.h"
+#include "LevelGenerator.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////
+// Identifiers used in definitions files
+////////////////////////////////////////////////////////////////////
+
+static const char* const MONSTERIDS[NUMMONSTERKINDS] =
+	{"goblin", "snakewoman", "bogeyman", "dragon"};
+static const char* const WEAPONIDS[NUMWEAPONKINDS] =
+	{"shortsword", "longsword", "mace", "magicaxe", "sleepfangs"};
+static const char* const SCROLLIDS[NUMSCROLLKINDS] =
+	{"teleportscroll", "armorscroll", "strengthscroll", "healthscroll",
+	 "dexterityscroll"};
+
+static int findId(const char* const ids[], int count, const string& id)
+	// Index of id in ids, -1 if it isn't there
+{
+	for(int i = 0; i < count; i++)
+		if(id == ids[i])
+			return i;
+	return -1;
+}
+
+static bool itemFromId(const string& id, Item& item)
+{
+	int kind;
+	if((kind = findId(WEAPONIDS, NUMWEAPONKINDS, id)) != -1)
+		item = makeItem(WeaponItem{(unsigned char)kind, 0, 0});
+	else if((kind = findId(SCROLLIDS, NUMSCROLLKINDS, id)) != -1)
+		item = makeItem(makeScroll(ScrollKind(kind)));
+	else
+		return false;
+	return true;
+}
+
+static const char* itemId(const Item& item)
+{
+	return item.isWeapon() ? WEAPONIDS[item.weapon.kind] : SCROLLIDS[item.scroll.kind];
+}
+
+////////////////////////////////////////////////////////////////////
+// Built-in Definitions (the original game)
+////////////////////////////////////////////////////////////////////
+
+static void setText(char* text, const char* value)
+{
+	strncpy(text, value, MAXDEFNAMELEN);
+	text[MAXDEFNAMELEN] = '\0';
+}
+
+static void setMonster(MonsterDef& def, const char* name, char symbol,
+	int minHit, int maxHit, int armor, int minStrength, int maxStrength,
+	int minDexterity, int maxDexterity, WeaponKind weapon, int minLevel,
+	double dropChance, const char* drops)
+{
+	setText(def.name, name);
+	def.symbol = symbol;
+	def.minHit = minHit; def.maxHit = maxHit;
+	def.armor = armor;
+	def.minStrength = minStrength; def.maxStrength = maxStrength;
+	def.minDexterity = minDexterity; def.maxDexterity = maxDexterity;
+	def.weapon = weapon;
+	def.minLevel = minLevel;
+	def.dropChance = dropChance;
+
+	// Drops listed by id, separated by spaces
+	istringstream ids(drops);
+	string id;
+	def.numDrops = 0;
+	while(ids >> id)
+		itemFromId(id, def.drops[def.numDrops++]);
+}
+
+static Definitions builtInDefinitions()
+{
+	Definitions defs;
+	memset(&defs, 0, sizeof(defs));
+
+	setMonster(defs.monsters[GOBLIN], "the Goblin", 'G', 15, 20, 1, 3, 3, 1, 1,
+		SHORTSWORD, 0, 1.0/3.0, "magicaxe sleepfangs");
+	setMonster(defs.monsters[SNAKEWOMAN], "the Snakewoman", 'S', 3, 6, 3, 2, 2, 3, 3,
+		SLEEPFANGS, 0, 1.0/3.0, "sleepfangs");
+	setMonster(defs.monsters[BOGEYMAN], "the Bogeyman", 'B', 5, 10, 2, 2, 3, 2, 3,
+		SHORTSWORD, 2, 1.0/10.0, "magicaxe");
+	setMonster(defs.monsters[DRAGON], "the Dragon", 'D', 20, 25, 4, 4, 4, 4, 4,
+		LONGSWORD, 3, 1.0, "armorscroll strengthscroll healthscroll dexterityscroll teleportscroll");
+
+	// Only real-time games go by speed: snakewomen are quick on their
+	// feet, bogeymen lumber
+	defs.monsters[GOBLIN].speed = NORMALSPEED;
+	defs.monsters[SNAKEWOMAN].speed = NORMALSPEED + NORMALSPEED/5;
+	defs.monsters[BOGEYMAN].speed = NORMALSPEED - NORMALSPEED/5;
+	defs.monsters[DRAGON].speed = NORMALSPEED;
+
+	static const struct
+	{
+		const char* name;
+		const char* action;
+		int damage;
+		int dexterityBonus;
+	} WEAPONS[NUMWEAPONKINDS] =
+	{
+		{"short sword",          "slashes short sword at", 2, 0}, // SHORTSWORD
+		{"long sword",           "swings long sword at",   4, 2}, // LONGSWORD
+		{"mace",                 "swings mace",            2, 0}, // MACE
+		{"magic axe",            "chops magic axe at",     5, 5}, // MAGICAXE
+		{"magic fangs of sleep", "strikes magic fangs at", 3, 3}, // SLEEPFANGS
+	};
+	for(int k = 0; k < NUMWEAPONKINDS; k++)
+	{
+		setText(defs.weapons[k].name, WEAPONS[k].name);
+		setText(defs.weapons[k].action, WEAPONS[k].action);
+		defs.weapons[k].damage = WEAPONS[k].damage;
+		defs.weapons[k].dexterityBonus = WEAPONS[k].dexterityBonus;
+	}
+
+	static const char* const SCROLLS[NUMSCROLLKINDS][2] =
+	{
+		{"scroll of teleportation",
+			"You feel your body wrenched in space and time."}, // TELEPORTSCROLL
+		{"scroll of improve armor",
+			"Your armor glows blue."},                         // ARMORSCROLL
+		{"scroll of raise strength",
+			"Your muscles bulge."},                            // STRENGTHSCROLL
+		{"scroll of enhance health",
+			"You feel your heart beating stronger."},          // HEALTHSCROLL
+		{"scroll of enhance dexterity",
+			"You feel like less of a klutz."},                 // DEXTERITYSCROLL
+	};
+	for(int k = 0; k < NUMSCROLLKINDS; k++)
+	{
+		setText(defs.scrolls[k].name, SCROLLS[k][0]);
+		setText(defs.scrolls[k].effect, SCROLLS[k][1]);
+	}
+
+	defs.regenChance = 1.0/10.0;
+	defs.playerSpeed = NORMALSPEED;
+
+	// 2 to 5*(level + 1) + 1 monsters, 2 or 3 objects (weapons twice
+	// as likely as each scroll)
+	defs.minMonsters = 2;
+	defs.maxMonsters = 6;
+	defs.monstersPerLevel = 5;
+	defs.minObjects = 2;
+	defs.maxObjects = 3;
+	static const char* const BAG[] =
+	{
+		"shortsword", "longsword", "mace", "armorscroll", "strengthscroll",
+		"healthscroll", "dexterityscroll", "shortsword", "longsword", "mace"
+	};
+	defs.numObjectBag = sizeof(BAG) / sizeof(BAG[0]);
+	for(int i = 0; i < defs.numObjectBag; i++)
+		itemFromId(BAG[i], defs.objectBag[i]);
+	return defs;
+}
+
+////////////////////////////////////////////////////////////////////
+// Reading Definitions Files
+////////////////////////////////////////////////////////////////////
+
+static string trim(const string& text)
+{
+	size_t first = text.find_first_not_of(" \t\r");
+	if(first == string::npos) return "";
+	size_t last = text.find_last_not_of(" \t\r");
+	return text.substr(first, last - first + 1);
+}
+
+static bool parseRange(const string& value, int& low, int& high)
+	// "a" or "a b"
+{
+	istringstream in(value);
+	if(!(in >> low)) return false;
+	if(!(in >> high)) high = low;
+	string rest;
+	return !(in >> rest);
+}
+
+static bool parseChance(const string& value, double& chance)
+	// "0.25" or "1/3"
+{
+	size_t slash = value.find('/');
+	char* end;
+	if(slash == string::npos)
+	{
+		chance = strtod(value.c_str(), &end);
+		return end != value.c_str() && trim(end).empty();
+	}
+	double num = strtod(value.substr(0, slash).c_str(), &end);
+	if(!trim(end).empty()) return false;
+	double den = strtod(value.c_str() + slash + 1, &end);
+	if(!trim(end).empty() || den == 0) return false;
+	chance = num / den;
+	return true;
+}
+
+static bool parseItems(const string& value, Item items[], int maxItems, int& count)
+	// Comma separated item ids
+{
+	istringstream in(value);
+	string id;
+	count = 0;
+	while(getline(in, id, ','))
+	{
+		if(count == maxItems || !itemFromId(trim(id), items[count]))
+			return false;
+		count++;
+	}
+	return true;
+}
+
+static bool parseText(const string& value, char* text)
+{
+	if(value.empty() || value.size() > size_t(MAXDEFNAMELEN)) return false;
+	setText(text, value.c_str());
+	return true;
+}
+
+static bool setMonsterKey(MonsterDef& def, const string& key, const string& value)
+{
+	int low, high;
+	if(key == "name") return parseText(value, def.name);
+	if(key == "symbol")
+	{
+		if(value.size() != 1) return false;
+		def.symbol = value[0];
+		return true;
+	}
+	if(key == "hit" || key == "strength" || key == "dexterity")
+	{
+		if(!parseRange(value, low, high)) return false;
+		short& min = (key == "hit") ? def.minHit : (key == "strength") ? def.minStrength : def.minDexterity;
+		short& max = (key == "hit") ? def.maxHit : (key == "strength") ? def.maxStrength : def.maxDexterity;
+		min = low; max = high;
+		return true;
+	}
+	if(key == "armor")
+	{
+		if(!parseRange(value, low, high) || low != high) return false;
+		def.armor = low;
+		return true;
+	}
+	if(key == "weapon")
+	{
+		int kind = findId(WEAPONIDS, NUMWEAPONKINDS, value);
+		if(kind == -1) return false;
+		def.weapon = kind;
+		return true;
+	}
+	if(key == "level")
+	{
+		if(!parseRange(value, low, high) || low != high || low < 0 || low > 255) return false;
+		def.minLevel = low;
+		return true;
+	}
+	if(key == "drop chance") return parseChance(value, def.dropChance);
+	if(key == "drops") return parseItems(value, def.drops, MAXDROPKINDS, def.numDrops);
+	if(key == "speed")
+	{
+		if(!parseRange(value, low, high) || low != high) return false;
+		def.speed = low;
+		return true;
+	}
+	return false;
+}
+
+static bool setWeaponKey(WeaponDef& def, const string& key, const string& value)
+{
+	int low, high;
+	if(key == "name") return parseText(value, def.name);
+	if(key == "action") return parseText(value, def.action);
+	if(key == "damage" || key == "dexterity bonus")
+	{
+		if(!parseRange(value, low, high) || low != high) return false;
+		(key == "damage" ? def.damage : def.dexterityBonus) = low;
+		return true;
+	}
+	return false;
+}
+
+static bool setScrollKey(ScrollDef& def, const string& key, const string& value)
+{
+	if(key == "name") return parseText(value, def.name);
+	if(key == "effect") return parseText(value, def.effect);
+	return false;
+}
+
+static bool setPlayerKey(Definitions& defs, const string& key, const string& value)
+{
+	int low, high;
+	if(key == "regen chance") return parseChance(value, defs.regenChance);
+	if(key == "speed")
+	{
+		if(!parseRange(value, low, high) || low != high) return false;
+		defs.playerSpeed = low;
+		return true;
+	}
+	return false;
+}
+
+static bool setLevelKey(Definitions& defs, const string& key, const string& value)
+{
+	int low, high;
+	if(key == "monsters" || key == "objects")
+	{
+		if(!parseRange(value, low, high)) return false;
+		(key == "monsters" ? defs.minMonsters : defs.minObjects) = low;
+		(key == "monsters" ? defs.maxMonsters : defs.maxObjects) = high;
+		return true;
+	}
+	if(key == "monsters per level")
+	{
+		if(!parseRange(value, low, high) || low != high) return false;
+		defs.monstersPerLevel = low;
+		return true;
+	}
+	if(key == "object bag")
+		return parseItems(value, defs.objectBag, MAXOBJECTBAG, defs.numObjectBag);
+	return false;
+}
+
+static void validate(const Definitions& defs, vector<string>& problems)
+	// Add a line to problems for every rule the tables break
+{
+	static const char RESERVEDSYMBOLS[] = {WALL, ' ', PLAYER, WEAPON, SCROLL, STAIR, UPSTAIR, IDOL, '\0'};
+
+	for(int k = 0; k < NUMMONSTERKINDS; k++)
+	{
+		const MonsterDef& def = defs.monsters[k];
+		string where = string("monster ") + MONSTERIDS[k] + ": ";
+		if(!isprint((unsigned char)def.symbol) || strchr(RESERVEDSYMBOLS, def.symbol))
+			problems.push_back(where + "symbol is taken or not printable");
+		if(def.minHit < 1 || def.minHit > def.maxHit || def.maxHit > MAXHIT)
+			problems.push_back(where + "hit must be a range within 1 to " + to_string(MAXHIT));
+		if(def.armor < 0 || def.armor > MAXARMOR)
+			problems.push_back(where + "armor must be within 0 to " + to_string(MAXARMOR));
+		if(def.minStrength < 0 || def.minStrength > def.maxStrength || def.maxStrength > MAXSTRENGTH)
+			problems.push_back(where + "strength must be a range within 0 to " + to_string(MAXSTRENGTH));
+		if(def.minDexterity < 0 || def.minDexterity > def.maxDexterity || def.maxDexterity > MAXDEXTERITY)
+			problems.push_back(where + "dexterity must be a range within 0 to " + to_string(MAXDEXTERITY));
+		if(def.dropChance < 0 || def.dropChance > 1)
+			problems.push_back(where + "drop chance must be within 0 to 1");
+		if(def.dropChance > 0 && def.numDrops == 0)
+			problems.push_back(where + "drops something but has nothing to drop");
+		if(def.speed < 1 || def.speed > MAXSPEED)
+			problems.push_back(where + "speed must be within 1 to " + to_string(MAXSPEED));
+		for(int j = 0; j < k; j++)
+			if(defs.monsters[j].symbol == def.symbol)
+				problems.push_back(where + "symbol is the same as " + MONSTERIDS[j] + "'s");
+	}
+
+	for(int k = 0; k < NUMWEAPONKINDS; k++)
+	{
+		const WeaponDef& def = defs.weapons[k];
+		string where = string("weapon ") + WEAPONIDS[k] + ": ";
+		if(def.damage < 1 || def.damage > 99)
+			problems.push_back(where + "damage must be within 1 to 99");
+		if(def.dexterityBonus < 0 || def.dexterityBonus > 99)
+			problems.push_back(where + "dexterity bonus must be within 0 to 99");
+	}
+
+	if(defs.regenChance < 0 || defs.regenChance > 1)
+		problems.push_back("player: regen chance must be within 0 to 1");
+	if(defs.playerSpeed < 1 || defs.playerSpeed > MAXSPEED)
+		problems.push_back("player: speed must be within 1 to " + to_string(MAXSPEED));
+	if(defs.minMonsters < 0 || defs.minMonsters > defs.maxMonsters || defs.monstersPerLevel < 0)
+		problems.push_back("level: monsters must be a range from 0 up, with monsters per level from 0 up");
+	if(defs.minObjects < 0 || defs.minObjects > defs.maxObjects || defs.maxObjects > MAXLEVELOBJECTS)
+		problems.push_back("level: objects must be a range within 0 to " + to_string(MAXLEVELOBJECTS));
+	if(defs.minMonsters > MAXSPAWNS - defs.maxObjects)
+		problems.push_back("level: more than " + to_string(MAXSPAWNS) + " monsters and objects");
+	if(defs.maxObjects > 0 && defs.numObjectBag == 0)
+		problems.push_back("level: object bag is empty");
+	bool shallowMonster = false;
+	for(int k = 0; k < NUMMONSTERKINDS; k++)
+		shallowMonster = shallowMonster || defs.monsters[k].minLevel == 0;
+	if(defs.maxMonsters > 0 && !shallowMonster)
+		problems.push_back("level: no monster appears on level 0");
+}
+
+static bool reportProblems(const Definitions& defs, vector<string>& problems)
+	// Validate defs, reporting every problem found so far or now
+{
+	validate(defs, problems);
+	for(size_t p = 0; p < problems.size(); p++)
+		cerr << "Error: " << problems[p] << endl;
+	return problems.empty();
+}
+
+static bool readDefinitions(const string& path, Definitions& defs)
+	// Change defs by the file at path, reporting any problems
+{
+	ifstream in(path.c_str());
+	if(!in)
+	{
+		cerr << "Error: Can't open definitions file " << path << endl;
+		return false;
+	}
+
+	vector<string> problems;
+	enum { NOSECTION, MONSTERSECTION, WEAPONSECTION, SCROLLSECTION, PLAYERSECTION,
+		   LEVELSECTION } section = NOSECTION;
+	int kind = -1;
+	string line;
+	for(int lineNum = 1; getline(in, line); lineNum++)
+	{
+		size_t hash = line.find('#');
+		if(hash != string::npos) line.erase(hash);
+		line = trim(line);
+		if(line.empty()) continue;
+		string where = path + ":" + to_string(lineNum) + ": ";
+
+		// Section header
+		if(line[0] == '[')
+		{
+			string header = (line[line.size() - 1] == ']') ? trim(line.substr(1, line.size() - 2)) : "";
+			string type = header.substr(0, header.find(' '));
+			string id = (header.find(' ') == string::npos) ? "" : trim(header.substr(header.find(' ')));
+			section = NOSECTION;
+			if(type == "monster" && (kind = findId(MONSTERIDS, NUMMONSTERKINDS, id)) != -1)
+				section = MONSTERSECTION;
+			else if(type == "weapon" && (kind = findId(WEAPONIDS, NUMWEAPONKINDS, id)) != -1)
+				section = WEAPONSECTION;
+			else if(type == "scroll" && (kind = findId(SCROLLIDS, NUMSCROLLKINDS, id)) != -1)
+				section = SCROLLSECTION;
+			else if(header == "player")
+				section = PLAYERSECTION;
+			else if(header == "level")
+				section = LEVELSECTION;
+			else
+				problems.push_back(where + "unknown section " + line);
+			continue;
+		}
+
+		// Key and value
+		size_t equals = line.find('=');
+		if(equals == string::npos)
+		{
+			problems.push_back(where + "expected key = value");
+			continue;
+		}
+		string key = trim(line.substr(0, equals));
+		string value = trim(line.substr(equals + 1));
+		bool ok = false;
+		switch(section)
+		{
+			case MONSTERSECTION: ok = setMonsterKey(defs.monsters[kind], key, value); break;
+			case WEAPONSECTION:  ok = setWeaponKey(defs.weapons[kind], key, value); break;
+			case SCROLLSECTION:  ok = setScrollKey(defs.scrolls[kind], key, value); break;
+			case PLAYERSECTION:  ok = setPlayerKey(defs, key, value); break;
+			case LEVELSECTION:   ok = setLevelKey(defs, key, value); break;
+			case NOSECTION:      break;
+		}
+		if(!ok)
+			problems.push_back(where + "bad or unknown " + key + " = " + value);
+	}
+
+	return reportProblems(defs, problems);
+}
+
+////////////////////////////////////////////////////////////////////
+// Tables in Use
+////////////////////////////////////////////////////////////////////
+
+static Definitions startupDefinitions()
+	// Built-in tables, changed by the file named in the environment
+{
+	Definitions defs = builtInDefinitions();
+	const char* path = getenv(DEFINITIONSENV);
+	if(path && *path && !readDefinitions(path, defs))
+		exit(1);
+	return defs;
+}
+
+static Definitions& currentDefinitions()
+{
+	static Definitions defs = startupDefinitions(); // On first use
+	return defs;
+}
+
+const Definitions& definitions()
+{
+	return currentDefinitions();
+}
+
+bool loadDefinitions(const string& path)
+{
+	Definitions defs = builtInDefinitions();
+	if(!readDefinitions(path, defs))
+		return false;
+	currentDefinitions() = defs;
+	return true;
+}
+
+static string rangeText(int low, int high)
+{
+	return (low == high) ? to_string(low) : to_string(low) + " " + to_string(high);
+}
+
+static string chanceText(double chance)
+	// Shortest text reading back as exactly chance ("1/3" if it is
+	// one in something)
+{
+	if(chance > 0 && chance < 1)
+	{
+		double in = floor(1 / chance + 0.5);
+		if(1 / in == chance)
+			return "1/" + to_string(int(in));
+	}
+	for(int precision = 6; ; precision++)
+	{
+		ostringstream text;
+		text << setprecision(precision) << chance;
+		if(strtod(text.str().c_str(), nullptr) == chance || precision == 17)
+			return text.str();
+	}
+}
+
+bool setDefinitions(const Definitions& defs)
+{
+	vector<string> problems;
+	if(!reportProblems(defs, problems))
+		return false;
+	currentDefinitions() = defs;
+	return true;
+}
+
+void writeDefinitions(ostream& out)
+{
+	const Definitions& defs = definitions();
+	out << "# miniRouge definitions (format in Definitions.h)\n";
+
+	for(int k = 0; k < NUMMONSTERKINDS; k++)
+	{
+		const MonsterDef& def = defs.monsters[k];
+		out << "\n[monster " << MONSTERIDS[k] << "]\n"
+			<< "name = " << def.name << '\n'
+			<< "symbol = " << def.symbol << '\n'
+			<< "hit = " << rangeText(def.minHit, def.maxHit) << '\n'
+			<< "armor = " << def.armor << '\n'
+			<< "strength = " << rangeText(def.minStrength, def.maxStrength) << '\n'
+			<< "dexterity = " << rangeText(def.minDexterity, def.maxDexterity) << '\n'
+			<< "weapon = " << WEAPONIDS[def.weapon] << '\n'
+			<< "level = " << int(def.minLevel) << '\n'
+			<< "drop chance = " << chanceText(def.dropChance) << '\n'
+			<< "drops = ";
+		for(int d = 0; d < def.numDrops; d++)
+			out << (d ? ", " : "") << itemId(def.drops[d]);
+		out << '\n'
+			<< "speed = " << def.speed << '\n';
+	}
+
+	for(int k = 0; k < NUMWEAPONKINDS; k++)
+		out << "\n[weapon " << WEAPONIDS[k] << "]\n"
+			<< "name = " << defs.weapons[k].name << '\n'
+			<< "action = " << defs.weapons[k].action << '\n'
+			<< "damage = " << defs.weapons[k].damage << '\n'
+			<< "dexterity bonus = " << defs.weapons[k].dexterityBonus << '\n';
+
+	for(int k = 0; k < NUMSCROLLKINDS; k++)
+		out << "\n[scroll " << SCROLLIDS[k] << "]\n"
+			<< "name = " << defs.scrolls[k].name << '\n'
+			<< "effect = " << defs.scrolls[k].effect << '\n';
+
+	out << "\n[player]\n"
+		<< "regen chance = " << chanceText(defs.regenChance) << '\n'
+		<< "speed = " << defs.playerSpeed << '\n';
+
+	out << "\n[level]\n"
+		<< "monsters = " << rangeText(defs.minMonsters, defs.maxMonsters) << '\n'
+		<< "monsters per level = " << defs.monstersPerLevel << '\n'
+		<< "objects = " << rangeText(defs.minObjects, defs.maxObjects) << '\n'
+		<< "object bag = ";
+	for(int i = 0; i < defs.numObjectBag; i++)
+		out << (i ? ", " : "") << itemId(defs.objectBag[i]);
+	out << endl;
+}
+
+////////////////////////////////////////////////////////////////////
+// Random Draws
+////////////////////////////////////////////////////////////////////
+
+void rollMonsterStats(int kind, Rng& rng, int& hit, int& strength, int& dexterity)
+{
+	const MonsterDef& def = definitions().monsters[kind];
+	hit = (def.minHit == def.maxHit) ? def.minHit : rng.randInt(def.minHit, def.maxHit);
+	strength = (def.minStrength == def.maxStrength)
+		? def.minStrength : rng.randInt(def.minStrength, def.maxStrength);
+	dexterity = (def.minDexterity == def.maxDexterity)
+		? def.minDexterity : rng.randInt(def.minDexterity, def.maxDexterity);
+}
+
+bool rollDropChance(int kind, Rng& rng)
+{
+	double chance = definitions().monsters[kind].dropChance;
+	if(chance >= 1) return true; // Certain drops draw nothing
+	if(chance <= 0) return false;
+	return rng.trueWithProbability(chance);
+}
+
+Item rollDrop(int kind, Rng& rng)
+{
+	const MonsterDef& def = definitions().monsters[kind];
+	Item item = def.drops[(def.numDrops == 1) ? 0 : rng.randInt(0, def.numDrops - 1)];
+	if(item.isWeapon())
+		item.weapon = makeWeapon(WeaponKind(item.weapon.kind)); // Current stats
+	return item;
+}
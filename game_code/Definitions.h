@@ -0,0 +1,146 @@
+// Definitions.h
+
+#ifndef DEFINITIONS_INCLUDED
+#define DEFINITIONS_INCLUDED
+
+#include <iostream>
+#include <string>
+
+#include "Item.h"
+#include "Monster.h"
+#include "Rng.h"
+
+const int MAXDEFNAMELEN = 63;   // Longest name, action or effect text
+const int MAXDROPKINDS = 8;     // Items a monster chooses its drop from
+const int MAXOBJECTBAG = 32;    // Entries in the bag of level objects
+const int MAXLEVELOBJECTS = 8;  // Most objects placed in a fresh level
+
+// Environment variable naming a definitions file to load at startup
+const char DEFINITIONSENV[] = "MINIROUGE_DEFS";
+
+////////////////////////////////////////////////////////////////////
+// Game Definitions
+//
+// The stats of every kind of monster, weapon and scroll, what
+// monsters drop and what a fresh level is stocked with, kept in
+// flat tables indexed by kind. The built-in tables are the original
+// game. A definitions file can replace any part of them without
+// recompiling; it is read and validated once, before any game
+// starts (from the file named by MINIROUGE_DEFS, or by a tool
+// calling loadDefinitions), and the tables never change during
+// play, so reading them needs no locks.
+//
+// File format: sections of "key = value" lines, "#" comments.
+//
+//   [monster goblin]            (goblin, snakewoman, bogeyman, dragon)
+//   name = the Goblin
+//   symbol = G
+//   hit = 15 20                 (a range, drawn when the monster is made)
+//   armor = 1
+//   strength = 3                (a single value draws nothing)
+//   dexterity = 1
+//   weapon = shortsword
+//   level = 0                   (shallowest level it appears on)
+//   drop chance = 1/3
+//   drops = magicaxe, sleepfangs  (one of these, at random)
+//   speed = 10                  (real-time games: energy gained a tick)
+//
+//   [weapon magicaxe]           (shortsword, longsword, mace, magicaxe, sleepfangs)
+//   name = magic axe
+//   action = chops magic axe at
+//   damage = 5
+//   dexterity bonus = 5
+//
+//   [scroll armorscroll]        (teleportscroll, armorscroll, strengthscroll,
+//   name = scroll of improve armor   healthscroll, dexterityscroll)
+//   effect = Your armor glows blue.
+//
+//   [player]
+//   regen chance = 1/10         (of getting a hit point back each turn)
+//   speed = 10
+//
+//   [level]
+//   monsters = 2 6              (range on level 0)
+//   monsters per level = 5      (added to the top of the range per level)
+//   objects = 2 3
+//   object bag = shortsword, longsword, ...  (repeats make items likelier)
+////////////////////////////////////////////////////////////////////
+
+struct MonsterDef
+{
+	char name[MAXDEFNAMELEN + 1];
+	char symbol;
+	short minHit, maxHit;
+	short armor;
+	short minStrength, maxStrength;
+	short minDexterity, maxDexterity;
+	unsigned char weapon;   // WeaponKind
+	unsigned char minLevel; // Shallowest level it appears on
+	double dropChance;
+	int numDrops;
+	Item drops[MAXDROPKINDS];
+	short speed;            // Energy gained a tick in real-time games
+};
+
+struct WeaponDef
+{
+	char name[MAXDEFNAMELEN + 1];
+	char action[MAXDEFNAMELEN + 1];
+	int damage;
+	int dexterityBonus;
+};
+
+struct ScrollDef
+{
+	char name[MAXDEFNAMELEN + 1];
+	char effect[MAXDEFNAMELEN + 1];
+};
+
+struct Definitions
+{
+	MonsterDef monsters[NUMMONSTERKINDS];
+	WeaponDef weapons[NUMWEAPONKINDS];
+	ScrollDef scrolls[NUMSCROLLKINDS];
+	double regenChance;           // Player's chance of healing a turn
+	int playerSpeed;              // Energy gained a tick in real-time games
+
+	// Stocking a fresh level
+	int minMonsters, maxMonsters; // On level 0
+	int monstersPerLevel;         // Added to maxMonsters per level
+	int minObjects, maxObjects;
+	int numObjectBag;
+	Item objectBag[MAXOBJECTBAG]; // Objects are drawn from these
+};
+
+// Tables in use
+const Definitions& definitions();
+
+// Replace the tables in use with the built-in ones changed by the
+// file at path. Nothing changes if the file can't be read or isn't
+// valid, in which case the problems are reported on cerr and false
+// is returned. Not to be called while games are being played.
+bool loadDefinitions(const std::string& path);
+
+// Replace the tables in use with defs if they are valid (problems
+// are reported on cerr and false returned otherwise). Not to be
+// called while games are being played.
+bool setDefinitions(const Definitions& defs);
+
+// Write the tables in use in the format of a definitions file
+void writeDefinitions(std::ostream& out);
+
+////////////////////////////////////////////////////////////////////
+// Random draws from the tables (shared by the Game classes and
+// GameState, so both draw the same numbers in the same order)
+////////////////////////////////////////////////////////////////////
+
+// Stats of a new monster of kind: hit points, then strength, then
+// dexterity, drawing only for ranges
+void rollMonsterStats(int kind, Rng& rng, int& hit, int& strength, int& dexterity);
+
+// Whether a dying monster of kind drops something (drawn before
+// looking at the spot), then what it drops
+bool rollDropChance(int kind, Rng& rng);
+Item rollDrop(int kind, Rng& rng);
+
+#endif // DEFINITIONS_INCLUDED
@@ -0,0 +1,54 @@
+#include <cstring>
+
+#include "DistanceTable.h"
+
+using namespace std;
+
+void DistanceTable::build(const Dungeon& dungeon)
+{
+	static const int DR[4] = {-1, 1, 0, 0};
+	static const int DC[4] = {0, 0, -1, 1};
+
+	// Numbering the open cells
+	memset(m_index, -1, sizeof(m_index));
+	short cells[MAXROWS * MAXCOLS][2];
+	m_numCells = 0;
+	for(int i = 0; i < dungeon.rows(); i++)
+		for(int j = 0; j < dungeon.cols(); j++)
+			if(!dungeon.isWall(i, j))
+			{
+				cells[m_numCells][0] = i;
+				cells[m_numCells][1] = j;
+				m_index[i][j] = m_numCells++;
+			}
+	m_steps.assign(size_t(m_numCells) * m_numCells, FARSTEPS);
+
+	// A breadth first search from every open cell, writing its row of
+	// the table (cells past FARSTEPS are left at it)
+	short queue[MAXROWS * MAXCOLS];
+	short steps[MAXROWS * MAXCOLS];
+	for(int from = 0; from < m_numCells; from++)
+	{
+		unsigned char* row = &m_steps[size_t(from) * m_numCells];
+		for(int k = 0; k < m_numCells; k++)
+			steps[k] = -1;
+		int head = 0, tail = 0;
+		steps[from] = 0;
+		queue[tail++] = from;
+		while(head < tail)
+		{
+			int cell = queue[head++];
+			if(steps[cell] >= FARSTEPS) break;
+			row[cell] = steps[cell];
+			for(int d = 0; d < 4; d++)
+			{
+				int r = cells[cell][0] + DR[d], c = cells[cell][1] + DC[d];
+				if(dungeon.isWall(r, c)) continue;
+				int next = m_index[r][c];
+				if(steps[next] != -1) continue;
+				steps[next] = steps[cell] + 1;
+				queue[tail++] = next;
+			}
+		}
+	}
+}
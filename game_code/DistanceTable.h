@@ -0,0 +1,52 @@
+// DistanceTable.h
+
+#ifndef DISTANCETABLE_INCLUDED
+#define DISTANCETABLE_INCLUDED
+
+#include <vector>
+
+#include "Dungeon.h"
+
+const int FARSTEPS = 255; // Steps stored for 255 or more, or no way
+
+////////////////////////////////////////////////////////////////////
+// Distance Table
+//
+// Steps around walls between every two open cells of a level, one
+// byte each: a search from every open cell, done once for the level
+// (its terrain never changes), and then any distance is a lookup.
+// A full level has at most MAXROWS x MAXCOLS open cells, so the
+// table is at most about 1.6 MB, and the searches take a few
+// milliseconds: Dungeon builds it on a worker thread (see
+// Dungeon::startDistanceTable) and hands it out once it is ready.
+//
+// Monsters step out of each other's way, so the table leaves them
+// out: it gives the steps on an empty level, never more than the
+// steps a monster really needs.
+////////////////////////////////////////////////////////////////////
+
+class DistanceTable
+{
+  public:
+	// Search from every open cell of dungeon
+	void build(const Dungeon& dungeon);
+
+	// Steps from (r1, c1) to (r2, c2), FARSTEPS if there are that many
+	// or more, or no way, or either cell is a wall
+	int steps(int r1, int c1, int r2, int c2) const
+	{
+		int from = m_index[r1][c1], to = m_index[r2][c2];
+		if(from == -1 || to == -1) return FARSTEPS;
+		return m_steps[from * m_numCells + to];
+	}
+
+	int numCells() const {return m_numCells;} // Open cells
+	size_t bytes() const {return m_steps.size();}
+
+  private:
+	short m_index[MAXROWS][MAXCOLS]; // Of each open cell, -1 for walls
+	int m_numCells;
+	std::vector<unsigned char> m_steps; // From cell i to j at i*m_numCells+j
+};
+
+#endif // DISTANCETABLE_INCLUDED
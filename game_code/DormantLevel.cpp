@@ -0,0 +1,90 @@
+#include <cmath>
+#include <cstring>
+
+#include "DormantLevel.h"
+#include "GameState.h"
+#include "Monster.h"
+#include "Definitions.h"
+
+using namespace std;
+
+static int healDrawn(int turns, double chance, Rng& rng)
+	// Hit points healed over turns turns (a binomial draw)
+{
+	if(turns <= 0 || chance <= 0) return 0;
+	if(turns <= EXACTHEALTURNS)
+	{
+		int healed = 0;
+		for(int t = 0; t < turns; t++)
+			healed += rng.trueWithProbability(chance);
+		return healed;
+	}
+
+	// Normal approximation (Box-Muller from two uniform draws)
+	double u1 = (rng.next() + 1.0) * (1.0/4294967297.0);
+	double u2 = rng.next() * (1.0/4294967296.0);
+	double normal = sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+	double mean = turns * chance;
+	double healed = floor(mean + normal * sqrt(mean * (1 - chance)) + 0.5);
+	return (healed < 0) ? 0 : (healed > turns) ? turns : int(healed);
+}
+
+void simulateDormant(GameState& state, int turns, int playerRow, int playerCol,
+	Rng& rng)
+{
+	static const int DR[4] = {-1, 1, 0, 0};
+	static const int DC[4] = {0, 0, -1, 1};
+
+	if(turns <= 0) return;
+	const Definitions& defs = definitions();
+
+	// Cells monsters can't step on: other monsters and where the
+	// player comes back
+	bool taken[MAXROWS][MAXCOLS];
+	memset(taken, 0, sizeof(taken));
+	for(int m = 0; m < state.numMonsters; m++)
+		taken[state.monsters[m].row][state.monsters[m].col] = true;
+	taken[playerRow][playerCol] = true;
+
+	for(int m = 0; m < state.numMonsters; m++)
+	{
+		ActorState& monster = state.monsters[m];
+		int awake = (turns > monster.sleep) ? turns - monster.sleep : 0;
+		monster.sleep = (turns > monster.sleep) ? 0 : monster.sleep - turns;
+
+		// Healing, up to the hit points the monster spawned with
+		if(monster.hit < monster.maxHit)
+		{
+			int healed = monster.hit + healDrawn(turns, defs.regenChance, rng);
+			monster.hit = (healed > monster.maxHit) ? monster.maxHit : healed;
+		}
+
+		// Wandering
+		if(monster.kind == DRAGON || awake == 0) continue;
+		int row = monster.row, col = monster.col;
+		taken[row][col] = false;
+		if(awake >= MIXINGSTEPS)
+		{
+			do{
+				row = rng.randInt(state.rows);
+				col = rng.randInt(state.cols);
+			}while(state.isWall(row, col) || taken[row][col]);
+		}
+		else
+		{
+			for(int step = 0; step < awake; step++)
+			{
+				int d = rng.randInt(4);
+				int r = row + DR[d], c = col + DC[d];
+				if(!state.isWall(r, c) && !taken[r][c])
+				{
+					row = r;
+					col = c;
+				}
+			}
+		}
+		monster.row = row;
+		monster.col = col;
+		taken[row][col] = true;
+	}
+}
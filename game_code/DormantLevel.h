@@ -0,0 +1,43 @@
+// DormantLevel.h
+
+#ifndef DORMANTLEVEL_INCLUDED
+#define DORMANTLEVEL_INCLUDED
+
+#include "Rng.h"
+
+struct GameState;
+
+// Random steps after which a wandering monster is taken to be
+// anywhere on the level with equal chance
+const int MIXINGSTEPS = 256;
+
+// Turns of healing drawn one by one; longer spells draw the total
+// from the normal approximation of the binomial
+const int EXACTHEALTURNS = 64;
+
+////////////////////////////////////////////////////////////////////
+// Dormant Levels
+//
+// The monsters of a level the player has left carry on living, but
+// nothing is simulated while the player is away: when they come
+// back, all the turns they were gone are applied to the level in
+// one coarse step. Each monster, in the order they move,
+//
+//  - sleeps off as much of its sleep as the time away allows,
+//  - heals one hit point a turn with the player's regen chance, up
+//    to the hit points it spawned with (the total drawn at once),
+//  - wanders about for the turns it was awake, unless it's a dragon:
+//    a random walk of that many steps, or for MIXINGSTEPS or more, a
+//    random free spot anywhere on the level.
+//
+// So a level costs nothing while it waits, and catching it up costs
+// the same however long the player was away. Monsters never end up
+// on the cell the player comes back to.
+////////////////////////////////////////////////////////////////////
+
+// Apply turns turns away to the monsters of the level stored in
+// state, with the player coming back at (playerRow, playerCol)
+void simulateDormant(GameState& state, int turns, int playerRow, int playerCol,
+	Rng& rng);
+
+#endif // DORMANTLEVEL_INCLUDED
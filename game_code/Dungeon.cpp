@@ -4,6 +4,7 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 
 #include "Dungeon.h"
 #include "Actor.h"
@@ -12,12 +13,35 @@
 #include "GameObject.h"
 #include "Scroll.h"
 #include "Weapon.h"
+#include "LevelGenerator.h"
+#include "FieldOfView.h"
+#include "Spectator.h"
+#include "GameState.h"
+#include "Rules.h"
+#include "DormantLevel.h"
+#include "Definitions.h"
+#include "Combat.h"
+#include "TargetField.h"
+#include "RoomGraph.h"
+#include "DistanceTable.h"
+#include "UndoLog.h"
+#include "Rng.h"
 #include "utilities.h"
 
 using namespace std;
 
 class Player;
 
+// Zobrist key of an object (see GameState.h)
+static uint64_t objectKey(const GameObject& object)
+{
+	ObjectState state;
+	state.row = object.row();
+	state.col = object.col();
+	state.item = object.item();
+	return zobristObject(state);
+}
+
 ////////////////////////////////////////////////////////////////////
 // Dungeon Class Implementation
 ////////////////////////////////////////////////////////////////////
@@ -25,8 +49,11 @@ class Player;
 //////////////////////////////////////////////////////////////////
 // Constructor and Destructor
 
-Dungeon::Dungeon(int level, Player* player, int goblinSmellDist, int rows , int cols )
-	: m_rows(rows), m_cols(cols), m_level(level), m_goblinSmellDist(goblinSmellDist)
+Dungeon::Dungeon(int level, Player* player, int goblinSmellDist, Rng& rng,
+	int rows , int cols , LevelStyle style, bool endless)
+	: m_rows(rows), m_cols(cols), m_level(level), m_rng(&rng), m_targets(nullptr),
+	  m_roomGraph(new RoomGraph), m_distances(nullptr), m_distancesReady(false),
+	  m_undo(nullptr), m_goblinSmellDist(goblinSmellDist)
 {
 	if(rows < 0 || rows > MAXROWS || cols < 0 || cols > MAXCOLS)
 	{
@@ -34,30 +61,72 @@ Dungeon::Dungeon(int level, Player* player, int goblinSmellDist, int rows , int
 		exit(1);
 	}
 
-	// Generating rooms
-	generateRooms();
-	
-	// Generating monsters
-	int monsterNum = randInt(2, 5*(level + 1) + 1); // No. of monsters to add
-	for (int i = 0; i < monsterNum; i++)
+	// Generating the level's terrain and what to place on it
+	uint64_t seed = uint64_t(rng.next()) << 32;
+	seed |= rng.next();
+	Level plan;
+	levelGenerator(style).generate(seed, level, plan, rows, cols, endless);
+	m_rows = plan.rows; // Too small a size is clamped to the style's least
+	m_cols = plan.cols;
+
+	// Copying terrain (including the stair or idol) to base grid
+	for(int i = 0; i < m_rows; i++)
+		for(int j = 0; j < m_cols; j++)
+			m_baseGrid[i][j] = plan.grid[i][j];
+	m_terrainKey = zobristTerrain(m_baseGrid, m_rows, m_cols);
+	m_key = m_terrainKey ^ zobristLevel(m_level);
+	m_roomGraph->build(*this);
+
+	// Generating monsters and objects
+	for(int i = 0; i < plan.numSpawns; i++)
 	{
-		addNewMonster();  // Add new monster to the dungeon
+		addSpawn(plan.spawns[i]);
 	}
 
-	// Adding stair or idol to base grid depending on level
-	int newRow, newCol;
-	produceOpenPos(newRow, newCol);
-	m_baseGrid[newRow][newCol] = (level == 4)? IDOL : STAIR; 
+	// Placing Player on its planned position
+	addPlayer(player, plan.playerRow, plan.playerCol);
 
-	// Generating objects
-	int objectNum = randInt(2,3); // Number of GameObjects to add
-	for (int i = 0; i < objectNum; i++)
+	// Nothing seen yet but what is around the player
+	memset(m_seen, 0, sizeof(m_seen));
+	updateFieldOfView();
+}
+
+Dungeon::Dungeon(const GameState& state, Player* player, Rng& rng)
+	: m_rows(state.rows), m_cols(state.cols), m_level(state.level), m_rng(&rng),
+	  m_targets(nullptr), m_roomGraph(new RoomGraph),
+	  m_distances(nullptr), m_distancesReady(false), m_undo(nullptr),
+	  m_goblinSmellDist(state.goblinSmellDist)
+{
+	memcpy(m_baseGrid, state.grid, sizeof(m_baseGrid));
+	memcpy(m_seen, state.seen, sizeof(m_seen));
+	m_terrainKey = zobristTerrain(m_baseGrid, m_rows, m_cols);
+	m_key = m_terrainKey ^ zobristLevel(m_level);
+	m_roomGraph->build(*this);
+
+	// Making the monsters the usual way, with a spare generator so
+	// the game's random numbers are left alone, then giving them
+	// their stored stats
+	Rng spare;
+	m_rng = &spare;
+	for(int i = 0; i < state.numMonsters; i++)
 	{
-		addNewObject();  // Add new object to the dungeon
+		const ActorState& stored = state.monsters[i];
+		Spawn spawn = {Spawn::MONSTERSPAWN, stored.kind, stored.row, stored.col};
+		addSpawn(spawn);
+		restoreActor(stored, *m_monsters[m_monsters.size() - 1]);
+		m_monsters[m_monsters.size() - 1]->setMaxHitPts(stored.maxHit);
 	}
+	m_rng = &rng;
 
-	// Placing Player on a random position
-	addPlayer(player);
+	// Making the objects
+	for(int i = 0; i < state.numObjects; i++)
+	{
+		const ObjectState& stored = state.objects[i];
+		addObject(makeObject(stored.item, stored.row, stored.col));
+	}
+
+	addPlayer(player, state.player.row, state.player.col);
+	updateFieldOfView();
 }
 
 Dungeon::~Dungeon()
@@ -72,6 +141,11 @@ Dungeon::~Dungeon()
 	{
 		delete m_monsters[i]; 
 	}
+	delete m_targets;
+	delete m_roomGraph;
+	if(m_distanceWorker.joinable())
+		m_distanceWorker.join();
+	delete m_distances;
 }
 
 /////////////////////////////////////////////////////////////////
@@ -81,14 +155,8 @@ void Dungeon::produceOpenPos(int& row, int& col) const
 	// Produce a random position in the Dungeon that the player 
 	// can occupy. Can be location of an object
 {
-	int newRow, newCol;
-	// Keep producing new positions until a free position is found
-	do{
-		newRow = randInt(rows());
-		newCol = randInt(cols());
-	}while(!canPlayerOccupy(newRow, newCol));
-	row = newRow;
-	col = newCol;
+	randomOpenCell(rows(), cols(),
+		[this](int r, int c) {return canPlayerOccupy(r, c);}, rng(), row, col);
 }
 
 void Dungeon::produceEmptyPos(int& row, int& col) const
@@ -98,8 +166,8 @@ void Dungeon::produceEmptyPos(int& row, int& col) const
 	int newRow, newCol;
 	// Keep producing new positions until a free position is found
 	do{
-		newRow = randInt(rows());
-		newCol = randInt(cols());
+		newRow = rng().randInt(rows());
+		newCol = rng().randInt(cols());
 	}while(!(m_baseGrid[row][col] != ' ')
 			&& !monsterAt(row, col)
 			&& !objectAt(row, col));
@@ -123,6 +191,16 @@ Monster* Dungeon::monsterAt(int row, int col) const
 	return nullptr;
 }
 
+Player* Dungeon::playerAt(int row, int col) const
+	// Living player at (row, col), nullptr if none
+{
+	for(int i = 0; i < m_players.size(); i++)
+		if(!m_players[i]->isDead() && m_players[i]->row() == row
+			&& m_players[i]->col() == col)
+			return m_players[i];
+	return nullptr;
+}
+
 GameObject* Dungeon::objectAt(int row, int col) const
 	// If there is an object at (row, col), return a pointer to it
 	// If there isn't an object there, return nullptr
@@ -139,172 +217,91 @@ GameObject* Dungeon::objectAt(int row, int col) const
 	return nullptr;
 }
 
-/////////////////////////////////////////////////////////////////
-// Private Helper Functions
-
-void Dungeon::generateRooms()
-	// Set base grid to have randomly generated rooms and connect them
+Monster* Dungeon::monster(SlotHandle handle) const
 {
-	// Set everything on the grid to walls
-	for(int i = 0; i < rows(); i++)
-		for(int j = 0; j < cols(); j++)
-			m_baseGrid[i][j] = WALL;
-
-	// Find the number of rooms to be placed together 
-	// in horizontal direction
-	int numOfRoomsC = randInt(4,6);
-
-	// Finding max width
-	int maxDc = (cols() - 3 - numOfRoomsC)/numOfRoomsC;
-	// Fidning Max height
-	int maxDr = (rows() - 5);
-
-	Room prevRoom(0,0,0,0);
-
-	// Generate each room
-	for(int j = 0; j < numOfRoomsC; j++)
-	{	
-		Room thisRoom; // Generate a new room
-
-		thisRoom.m_dc = randInt(5, maxDc); // Deciding room width
-		thisRoom.m_dr = randInt(3, maxDr); // Deciding room height
-
-		// Deciding the top left corner depending on where the 
-		// previous room is and the dimensions of this room
-		int maxUpper = rows() - 1 - maxDr;
-		int prevLower = prevRoom.m_r + prevRoom.m_dr;
-
-		// Ensuring the new room shares a wall with the prev room
-		if(prevLower != 0 && prevLower <  maxUpper) 
-			maxUpper = prevLower - 1;
-		
-		thisRoom.m_r = randInt(2 ,maxUpper);
-		thisRoom.m_c =  randInt(1 + prevRoom.m_c + prevRoom.m_dc, 
-		 1 + prevRoom.m_c + prevRoom.m_dc + maxDc - thisRoom.m_dc);
-
-		// Clear this room
-		for(int i=thisRoom.m_r; i < thisRoom.m_r+thisRoom.m_dr; i++)
-			for(int j=thisRoom.m_c; j<thisRoom.m_c+thisRoom.m_dc; j++)
-				m_baseGrid[i][j] = ' ';
-
-		// Clear a path between this and the last room
-		if(prevRoom.m_dr != 0 && prevRoom.m_dc != 0)
-		{
-			// Determining bounds on corridor height
-
-			// Highest a corridor can be
-			int r1 = max(thisRoom.m_r, prevRoom.m_r);
-			// Lowest a corridor can be
-			int r2 = min(thisRoom.m_r + thisRoom.m_dr - 1, 
-						prevRoom.m_r + prevRoom.m_dr - 1);
-			
-			int cr = randInt(r1, r2);  // Corridor height
-
-			// Clear the corridor
-			for(int i = prevRoom.m_c + prevRoom.m_dc; i < thisRoom.m_c; i++)
-			{
-				m_baseGrid[cr][i] = ' ';
-			}	
-		}
-		prevRoom = thisRoom;
-	}	
+	Monster* const* monster = m_monsters.get(handle);
+	return monster ? *monster : nullptr;
 }
 
-GameObject* Dungeon::addNewObject()
-	// Adds a new dynamically allocated GameObject and drops 
-	// in the Dungeon. Does not produce an object that needs to 
-	// dropped by a monster's death
-	// Returns pointer to the newly added item
+GameObject* Dungeon::object(SlotHandle handle) const
 {
-	// Produce an open position to place the object in
-	int row, col;
-	produceOpenPos(row, col);
+	GameObject* const* object = m_objects.get(handle);
+	return object ? *object : nullptr;
+}
 
-	GameObject* object;
+/////////////////////////////////////////////////////////////////
+// Private Helper Functions
 
-	// Randomly selecting an item type
-	int selection = randInt(0,9);
+void Dungeon::addSpawn(const Spawn& spawn)
+	// Adds the dynamically allocated Monster or GameObject 
+	// planned by the level generator to the Dungeon
+{
+	int row = spawn.row;
+	int col = spawn.col;
 
-	switch(selection)
+	switch(spawn.type)
 	{
-		// Weapons (with additional cases to make weapon more likely)
-		case 0: // Short Sword
-		case 7:
-			object = new ShortSword(row, col, this); break;
-		case 1: // Long Sword
-		case 8:
-			object = new LongSword(row, col, this); break;
-		case 2: // Mace
-		case 9:
-			object = new Mace(row, col, this); break;
-		// Scrolls
-		case 3:  // scroll of improve armor
-			object = new ArmorScroll(row, col, this); break;
-		case 4: //  scroll of raise strength
-			object = new StrengthScroll(row, col, this); break;
-		case 5: // scroll of enhance health
-			object = new HealthScroll(row, col, this); break;
-		case 6: // scroll of enhance dexterit
-			object = new DexterityScroll (row, col, this); break;
+		case Spawn::MONSTERSPAWN:
+			// Pushing monster onto collection of monster
+			addMonster(makeMonster(spawn.kind, row, col));
+			break;
+		case Spawn::WEAPONSPAWN:
+			// Pushing item onto collection of objects
+			addObject(new Weapon(row, col, this, WeaponKind(spawn.kind)));
+			break;
+		case Spawn::SCROLLSPAWN:
+			addObject(new Scroll(row, col, this, ScrollKind(spawn.kind)));
+			break;
 	}
-
-	// Pushing item onto collection of objects
-	m_objects.push_back(object);
-
-	// returning pointer to the newly added item
-	return object;
 }
 
-Monster* Dungeon::addNewMonster()
-	// Adds a new dynamically allocated Monster and places it  
-	// in the Dungeon, depending on the level of the Dungeon
-	// Return pointer to the newly added monster
+Monster* Dungeon::makeMonster(int kind, int row, int col)
 {
-	// Produce an open position to place the monster in
-	int row, col;
-	produceOpenPos(row, col);
-
-	Monster* monster;
-
-	// Setting choices according to Dungeon level
-	int maxCase;
-	if(level() <= 1) maxCase = 1;      // Appear at level 0 or deeper
-	else if(level() <= 2) maxCase = 2; // Appear at level 2 or deeper
-	else maxCase = 3;                  // Appear at level 3 or deeper
-	
-	// Randomly selecting a monster type depending on Dungeon level
-	int selection = randInt(0,maxCase);
-
-	switch(selection)
+	switch(kind)
 	{
-		// Can appear at any level
-		case 0: monster = new Goblin(row, col, this, m_goblinSmellDist); break;
-		case 1: monster = new Snakewoman(row, col, this); break;
-		// Can appear at level 2 or deeper
-		case 2: monster = new Bogeyman(row, col, this); break;
-		// Can appear at level 3 or deeper
-		case 3: monster = new Dragon(row, col, this); break;		
+		case GOBLIN: 
+			return new Goblin(row, col, this, m_goblinSmellDist);
+		case SNAKEWOMAN: 
+			return new Snakewoman(row, col, this);
+		case BOGEYMAN: 
+			return new Bogeyman(row, col, this);
+		case DRAGON: 
+			return new Dragon(row, col, this);
 	}
+	return nullptr;
+}
+
+GameObject* Dungeon::makeObject(const Item& item, int row, int col)
+{
+	if(item.isWeapon())
+		return new Weapon(row, col, this, WeaponKind(item.weapon.kind));
+	return new Scroll(row, col, this, ScrollKind(item.scroll.kind));
+}
 
-	// Pushing monster onto collection of monster
-	m_monsters.push_back(monster);
+void Dungeon::addMonster(Monster* monster)
+{
+	monster->setHandle(m_monsters.insert(monster));
+	m_key ^= monster->key();
+}
 
-	// returning pointer to the newly added monster
-	return monster;
+void Dungeon::addObject(GameObject* object)
+{
+	object->setHandle(m_objects.insert(object));
+	m_key ^= objectKey(*object);
+	if(m_undo) m_undo->objectAdded(*object);
 }
 
-bool Dungeon::addPlayer(Player* p)
-	// Add player to valid random position on Dungeon
+bool Dungeon::addPlayer(Player* p, int row, int col)
+	// Add player to the given position on Dungeon
 {
 	if (p)
 	{
 		m_player = p;  // Attaching Player to Dungeon
 		m_player->setDungeon(this); // Attaching Dungeon to Player
+		m_players.assign(1, p); // The only player to start with
 
-		// Placing Player on valid position in Dungeon
-		int pRow, pCol;
-		produceOpenPos(pRow, pCol);
-		m_player->setPos(pRow, pCol);
+		// Placing Player on position in Dungeon
+		m_player->setPos(row, col);
 
 		return true;
 	}
@@ -317,122 +314,395 @@ bool Dungeon::addPlayer(Player* p)
 void Dungeon::display(string result) const
 	// Clear the screen and display the level
 {
-	// Making the display grid
-	char displayGrid[MAXROWS][MAXCOLS] ; 
+	Frame frame;
+	render(frame, result);
 
-	// copying the base grid
+	// Clearing screen
+	clearScreen();
+
+	// Printing the grid, stats and result
+	printFrame(cout, frame);
+}
+
+void Dungeon::render(Frame& frame, const string& result) const
+	// Fill frame with the level as the player sees it
+{
+	frame.level = level();
+	frame.rows = rows();
+	frame.cols = cols();
+
+	// copying the base grid where the player has been able to see
+	// (unexplored cells stay blank)
 	for(int i = 0; i < rows(); i++)
 		for(int j = 0; j < cols(); j++)
-			displayGrid[i][j] =  m_baseGrid[i][j];
+			frame.grid[i][j] = m_seen[i][j] ? m_baseGrid[i][j] : ' ';
 	
-	// Adding objects to the grid
+	// Adding objects in view to the grid
 	for(int i = 0; i < m_objects.size(); i++)
 	{
-		displayGrid[m_objects[i]->row()][m_objects[i]->col()] 
-			= m_objects[i]->symbol();
+		if(isVisible(m_objects[i]->row(), m_objects[i]->col()))
+			frame.grid[m_objects[i]->row()][m_objects[i]->col()] 
+				= m_objects[i]->symbol();
 	}
 
-	// Adding monsters to the grid
+	// Adding monsters in view to the grid
 	for(int i = 0; i < m_monsters.size(); i++)
 	{
-		displayGrid[m_monsters[i]->row()][m_monsters[i]->col()] 
-			= m_monsters[i]->symbol();
+		if(isVisible(m_monsters[i]->row(), m_monsters[i]->col()))
+			frame.grid[m_monsters[i]->row()][m_monsters[i]->col()] 
+				= m_monsters[i]->symbol();
 	}
 
-	// Adding player to the grid on top of everything else
-	displayGrid[m_player->row()][m_player->col()] 
-			= m_player->symbol();
-		
-	// Clearing screen
-	clearScreen();
-
-	// Printing the grid
-	for(int i = 0; i < rows(); i++)
+	// Adding co-op players in view
+	for(int i = 1; i < m_players.size(); i++)
 	{
-		for(int j = 0; j < cols(); j++)
-		{
-			cout << displayGrid[i][j];
-		}
-		cout << endl;
+		if(!m_players[i]->isDead() && isVisible(m_players[i]->row(), m_players[i]->col()))
+			frame.grid[m_players[i]->row()][m_players[i]->col()] 
+				= m_players[i]->symbol();
 	}
-	// Outputting the stats
-	cout << "Dungeon Level: " << level() << ", " 
-		 << "Hit Points: " << player()->hitPts()       << ", " 
-		 << "Armor: "      << player()->armorPts()     << ", " 
-		 << "Strength: "   << player()->strengthPts()  << ", " 
-		 << "Dexterity: "  << player()->dexterityPts() << endl;
-	
-	cout << endl;
 
-	// Outputtng the result of the previous move
-	cout << result << endl;
+	// Adding player to the grid on top of everything else
+	frame.grid[m_player->row()][m_player->col()] 
+			= m_player->symbol();
+
+	// Stats and the result of the previous move
+	frame.hitPts = player()->hitPts();
+	frame.armorPts = player()->armorPts();
+	frame.strengthPts = player()->strengthPts();
+	frame.dexterityPts = player()->dexterityPts();
+	size_t length = min(result.size(), size_t(MAXRESULTLEN));
+	memcpy(frame.result, result.data(), length);
+	frame.result[length] = '\0';
 }
 
-bool Dungeon::killMonster(Monster* monster)
+bool Dungeon::killMonster(SlotHandle handle)
 // Kill a monster and drop any items 
 {
-	// Find monster in Dungeon
-	vector<Monster*>::iterator toKill = 
-	find(m_monsters.begin(), m_monsters.end(), monster);
-	
-	if(toKill == m_monsters.end() // If no such monster found	
-		|| !(*toKill)->isDead())  // Or given monster not dead
+	Monster* monster = this->monster(handle);
+	if(!monster // If no such monster found
+		|| !monster->isDead())  // Or given monster not dead
 		return false;
 
 	// Get items from the monster
 	GameObject* object = monster->dropDead();
 	if(object) // If the monster dropped something
 	{
-		m_objects.push_back(object); // Add to dungeon
+		addObject(object); // Add to dungeon
 	}
 
-	m_monsters.erase(toKill); // Remove monster from Dungeon
+	if(m_undo) m_undo->monsterKilled(*monster, m_monsters.indexOf(handle));
+	m_key ^= monster->key();
+	m_monsters.erase(handle); // Remove monster from Dungeon
 	delete monster; // Kill the monster
 	return true;
 }
 
-bool Dungeon::removeObject(GameObject* object)
-	// Remove object from the dungeon
+bool Dungeon::removeObject(SlotHandle handle)
+	// Remove object from the dungeon and destroy it
+	// (whoever picks it up keeps a copy of its item record)
 {
-	// Find object in Dungeon
-	vector<GameObject*>::iterator toRemove = 
-	find(m_objects.begin(), m_objects.end(), object);
-
-	if(toRemove == m_objects.end()) // If no such object found
+	GameObject* object = this->object(handle);
+	if(!object) // If no such object found
 		return false;
 	 
-	m_objects.erase(toRemove);	 // Remove Object
+	if(m_undo) m_undo->objectRemoved(*object, m_objects.indexOf(handle));
+	m_key ^= objectKey(*object);
+	m_objects.erase(handle);	 // Remove Object
+	delete object; // Destroy Object
+	return true;
+}
+
+void Dungeon::updateFieldOfView()
+	// Find the cells the player sees (the first player still standing,
+	// in co-op) and remember them as seen
+{
+	const Player* viewer = m_player;
+	for(int i = 0; i < m_players.size(); i++)
+		if(!m_players[i]->isDead())
+		{
+			viewer = m_players[i];
+			break;
+		}
+	computeFieldOfView(m_baseGrid, rows(), cols(), viewer->row(),
+		viewer->col(), FOVRADIUS, m_visible);
+
+	for(int i = 0; i < rows(); i++)
+		for(int j = 0; j < cols(); j++)
+			if(m_visible[i][j] && !m_seen[i][j])
+			{
+				if(m_undo) m_undo->cellSeen(i, j);
+				m_seen[i][j] = true;
+			}
+}
+
+void Dungeon::enter(Player* player, int row, int col)
+{
+	addPlayer(player, row, col);
+	updateFieldOfView();
+}
+
+bool Dungeon::joinPlayer(Player* player)
+{
+	if(m_players.size() >= MAXPLAYERS) return false;
+
+	int row, col;
+	do{
+		row = rng().randInt(rows());
+		col = rng().randInt(cols());
+	}while(!canMonsterOccupy(row, col));
+
+	player->setDungeon(this);
+	player->setPos(row, col);
+	m_players.push_back(player);
+	if(!m_targets) m_targets = new TargetField;
 	return true;
 }
 
+void Dungeon::dropCoopPlayers()
+{
+	m_players.resize(1);
+}
+
+void Dungeon::simulateDormant(int turns)
+{
+	if(turns <= 0) return;
+	GameState state;
+	capture(state);
+	::simulateDormant(state, turns, m_player->row(), m_player->col(), rng());
+	for(int i = 0; i < m_monsters.size(); i++)
+		restoreActor(state.monsters[i], *m_monsters[i]);
+}
+
+void Dungeon::startDistanceTable()
+	// The terrain the worker reads never changes, and the table isn't
+	// handed out until the worker is done with it
+{
+	if(m_distances) return;
+	m_distances = new DistanceTable;
+	m_distanceWorker = thread([this] {
+		m_distances->build(*this);
+		m_distancesReady.store(true, memory_order_release);
+	});
+}
+
+void Dungeon::undo(const UndoRecord& record, UndoLog& log)
+{
+	switch(record.op)
+	{
+		case UndoRecord::MONSTERKILLED:
+		{
+			// Made again the usual way, with a spare generator as in
+			// a restored level, and given back what it had
+			ActorState killed = log.popMonster();
+			Rng spare;
+			Rng* rng = m_rng;
+			m_rng = &spare;
+			Monster* monster = makeMonster(killed.kind, killed.row, killed.col);
+			m_rng = rng;
+			restoreActor(killed, *monster);
+			monster->setMaxHitPts(killed.maxHit);
+			monster->setEnergy(record.a);
+			monster->setHandle(record.handle);
+			m_monsters.undoErase(record.handle, record.index, monster);
+			m_key ^= monster->key();
+			break;
+		}
+		case UndoRecord::OBJECTADDED:
+		{
+			GameObject* added = object(record.handle);
+			m_key ^= objectKey(*added);
+			delete added;
+			m_objects.undoInsert(record.handle);
+			break;
+		}
+		case UndoRecord::OBJECTREMOVED:
+		{
+			ObjectState removed = log.popObject();
+			GameObject* object = makeObject(removed.item, removed.row, removed.col);
+			object->setHandle(record.handle);
+			m_objects.undoErase(record.handle, record.index, object);
+			m_key ^= objectKey(*object);
+			break;
+		}
+		case UndoRecord::CELLSEEN:
+			m_seen[record.a][record.b] = false;
+			break;
+	}
+}
+
+void Dungeon::capture(GameState& state) const
+{
+	state.level = m_level;
+	state.rows = m_rows;
+	state.cols = m_cols;
+	state.playerKiller = m_player->killedBy();
+	memcpy(state.grid, m_baseGrid, sizeof(state.grid));
+	memcpy(state.seen, m_seen, sizeof(state.seen));
+	state.terrainKey = m_terrainKey;
+
+	state.numMonsters = m_monsters.size();
+	for(int i = 0; i < state.numMonsters; i++)
+	{
+		captureActor(*m_monsters[i], state.monsters[i]);
+		state.monsters[i].kind = m_monsters[i]->kind();
+		state.monsters[i].maxHit = m_monsters[i]->maxHitPts();
+	}
+
+	state.numObjects = m_objects.size();
+	for(int i = 0; i < state.numObjects; i++)
+	{
+		state.objects[i].row = m_objects[i]->row();
+		state.objects[i].col = m_objects[i]->col();
+		state.objects[i].item = m_objects[i]->item();
+	}
+}
+
 string Dungeon::attemptMoveMonsters()
 	// Attempt to move all monsters on the dungeon
 	// Attack player if monster is next to player
 	// Return result of moving monsters
 {
 	string result = ""; // Result is nothing by default
+	CombatBatch batch;  // Attacks, resolved once everyone has moved
+	Monster* attackers[MAXBATCHATTACKS];
+	Player* defenders[MAXBATCHATTACKS];
+
+	findTargets();
+	bool acted;
+	planMonsters(false, acted);
+	monstersAct(batch, attackers, defenders, result);
+	resolveAttacks(batch, attackers, defenders, result);
+	return result;
+}
 
-	for(int i = 0; i < m_monsters.size(); i++)
+string Dungeon::tickMonsters(bool& acted)
+{
+	string result = "";
+	CombatBatch batch;
+	Monster* attackers[MAXBATCHATTACKS];
+	Player* defenders[MAXBATCHATTACKS];
+
+	findTargets();
+	planMonsters(true, acted);
+	monstersAct(batch, attackers, defenders, result);
+	resolveAttacks(batch, attackers, defenders, result);
+	return result;
+}
+
+void Dungeon::planMonsters(bool ticking, bool& acted)
+	// Nothing a monster plans depends on the others: players stand
+	// still while monsters move, a monster's place is its own until
+	// its move, and attacks are only resolved once all have moved
+{
+	int numMonsters = m_monsters.size();
+	m_plans.resize(numMonsters);
+
+	// Listing the monsters kind by kind, each kind in order
+	int first[NUMMONSTERKINDS + 1] = {0};
+	for(int i = 0; i < numMonsters; i++)
+		first[m_monsters[i]->kind() + 1]++;
+	for(int k = 0; k < NUMMONSTERKINDS; k++)
+		first[k + 1] += first[k];
+	int next[NUMMONSTERKINDS];
+	for(int k = 0; k < NUMMONSTERKINDS; k++)
+		next[k] = first[k];
+	m_byKind.resize(numMonsters);
+	for(int i = 0; i < numMonsters; i++)
+		m_byKind[next[m_monsters[i]->kind()]++] = i;
+
+	acted = false;
+	planKind<Goblin>(first[GOBLIN], first[GOBLIN + 1], ticking, acted);
+	planKind<Snakewoman>(first[SNAKEWOMAN], first[SNAKEWOMAN + 1], ticking, acted);
+	planKind<Bogeyman>(first[BOGEYMAN], first[BOGEYMAN + 1], ticking, acted);
+	planKind<Dragon>(first[DRAGON], first[DRAGON + 1], ticking, acted);
+}
+
+template<typename Kind>
+void Dungeon::planKind(int begin, int end, bool ticking, bool& acted)
+{
+	int speed = definitions().monsters[Kind::KIND].speed;
+	for(int k = begin; k < end; k++)
 	{
-		// If monster asleep, do nothing and reduce sleep time
-		if(m_monsters[i]->isAsleep())
-		{
-			m_monsters[i]->reduceSleep();
-		}
-		// If monster next to player, attack
-		else if( abs(player()->row() - m_monsters[i]->row())
-			+ abs(player()->col() - m_monsters[i]->col())
-		 			== 1 )
+		int i = m_byKind[k];
+		Kind* monster = static_cast<Kind*>(m_monsters[i]);
+		MonsterPlan& plan = m_plans[i];
+		plan.action = RESTING;
+
+		// Real-time games: only monsters with the energy act
+		if(ticking)
 		{
-			if(result != "") result += "\n";
-			result += m_monsters[i]->attemptAttack(m_player);
+			monster->gainEnergy(speed);
+			if(!monster->spendEnergy())
+				continue;
+			acted = true;
 		}
-		else // Else execute the monter's move
+
+		// Asleep, sleeping a turn off; next to its target, attacking
+		// it (in the combat phase); else moving after it
+		plan.target = targetOf(monster);
+		int steps = plan.target ? abs(plan.target->row() - monster->row())
+			+ abs(plan.target->col() - monster->col()) : -1;
+		plan.action = planMonster(monster->sleepPts(), steps, Kind::MOVES);
+		if(plan.action == SLEEPING)
+			monster->reduceSleep();
+	}
+}
+
+void Dungeon::monstersAct(CombatBatch& batch, Monster* attackers[],
+	Player* defenders[], string& result)
+{
+	for(int i = 0; i < m_monsters.size(); i++)
+	{
+		const MonsterPlan& plan = m_plans[i];
+		if(plan.action == ATTACKING)
 		{
-			m_monsters[i]->move();
-			// No update to result string needed
+			if(batch.isFull())
+				resolveAttacks(batch, attackers, defenders, result);
+			int attack = m_monsters[i]->queueAttack(batch, plan.target);
+			attackers[attack] = m_monsters[i];
+			defenders[attack] = plan.target;
 		}
+		else if(plan.action == MOVING)
+			m_monsters[i]->move(plan.target);
 	}
-	return result;
+}
+
+void Dungeon::resolveAttacks(CombatBatch& batch, Monster* const attackers[],
+	Player* const defenders[], string& result)
+{
+	batch.resolve(*m_rng);
+	for(int i = 0; i < batch.size(); i++)
+	{
+		if(result != "") result += "\n";
+		result += attackers[i]->applyAttack(defenders[i], batch.hit(i), batch.damage(i));
+		// Remembering who dealt each player their final blow
+		if(defenders[i]->isDead() && defenders[i]->killedBy() == -1)
+			defenders[i]->setKilledBy(attackers[i]->kind());
+	}
+	batch.clear();
+}
+
+void Dungeon::findTargets()
+{
+	// Players stand still while the monsters move, so once a turn
+	// does (and with one player there is nothing to work out)
+	if(m_players.size() > 1)
+		m_targets->compute(*this, m_players);
+}
+
+Player* Dungeon::targetOf(const Monster* monster) const
+{
+	// Alone, the player is always the target, reachable or not
+	if(m_players.size() == 1)
+		return m_player;
+
+	int nearest = m_targets->nearest(monster->row(), monster->col());
+	if(nearest != -1)
+		return m_players[nearest];
+	// Walled off from everyone: the first living player, as if alone
+	for(int i = 0; i < m_players.size(); i++)
+		if(!m_players[i]->isDead())
+			return m_players[i];
+	return nullptr;
 }
 
@@ -3,18 +3,45 @@
 #ifndef DUNGEON_INCLUDED
 #define DUNGEON_INCLUDED
 
+#include <string>
 #include <vector>
+#include <atomic>
+#include <thread>
+
+#include "Rng.h"
+#include "SlotMap.h"
 
 const int MAXROWS = 18;
 const int MAXCOLS = 70;
+const int MAXPLAYERS = 64; // Players sharing one Dungeon
 
 const char WALL = '#';
 const char STAIR = '>';
+const char UPSTAIR = '<'; // Only in endless games
 const char IDOL = '&';
 
+// Styles of generated levels (see LevelGenerator.h)
+enum LevelStyle
+{
+	ROOMROW,  // Rooms in a row joined by horizontal corridors
+	BSPROOMS, // Rooms from a binary space partition
+	CAVES,    // Cellular automata caves
+	NUMLEVELSTYLES
+};
+
 class Player;
 class Monster;
 class GameObject;
+struct Spawn;
+struct GameState;
+struct Frame;
+class CombatBatch;
+class TargetField;
+class RoomGraph;
+class DistanceTable;
+class UndoLog;
+struct UndoRecord;
+struct Item;
 
 ////////////////////////////////////////////////////////////////////
 // Dungeon Class Declaration
@@ -25,7 +52,11 @@ class Dungeon
   public:
   	/////////////////////////////////////////////////////////////////
 	// Constructor and Destructor
-	Dungeon(int level, Player* player, int goblinSmellDist, int rows = MAXROWS, int cols = MAXCOLS);
+	Dungeon(int level, Player* player, int goblinSmellDist, Rng& rng,
+		int rows = MAXROWS, int cols = MAXCOLS, LevelStyle style = ROOMROW,
+		bool endless = false);
+	// Rebuild the level stored in a game state (see GameState.h)
+	Dungeon(const GameState& state, Player* player, Rng& rng);
 	~Dungeon();
 	
 	/////////////////////////////////////////////////////////////////
@@ -36,16 +67,55 @@ class Dungeon
 
 	int level() const {return m_level;}
 	Player* player() const {return m_player;}
+	// Every player on the level: the first player (whose view is
+	// shown) and any co-op players who joined after
+	int numPlayers() const {return m_players.size();}
+	Player* player(int i) const {return m_players[i];}
+	// Random numbers of the game the Dungeon belongs to
+	Rng& rng() const {return *m_rng;}
+	int goblinSmellDist() const {return m_goblinSmellDist;}
+	// Rooms and corridors of the level, for planning long walks
+	// (see RoomGraph.h)
+	const RoomGraph& roomGraph() const {return *m_roomGraph;}
+	// Steps between every two cells of the level (see
+	// DistanceTable.h), nullptr until startDistanceTable has been
+	// called and the worker thread building it is done
+	const DistanceTable* distanceTable() const;
+
+	// Monsters and objects on the level (monsters in the order they
+	// move)
+	const std::vector<Monster*>& monsters() const {return m_monsters.values();}
+	const std::vector<GameObject*>& objects() const {return m_objects.values();}
+	// Monster or object of a handle (see SlotMap.h), nullptr once it
+	// is killed or removed
+	Monster* monster(SlotHandle handle) const;
+	GameObject* object(SlotHandle handle) const;
+	// Log the changes to the level and everyone on it are recorded
+	// in (see UndoLog.h), nullptr if they aren't
+	UndoLog* undoLog() const {return m_undo;}
+	// Zobrist key of the level (see GameState.h): its terrain, depth,
+	// monsters and objects, kept up to date as they change (monsters
+	// pass on the changes of their keys)
+	uint64_t key() const {return m_key;}
+	void changeKey(uint64_t change) {m_key ^= change;}
 	
 	/////////////////////////////////////////////////////////////////
 	// Helper Functions
 
 	bool isWall(int row, int col) const;
 	bool isStair(int row, int col) const;
+	bool isUpStair(int row, int col) const;
 	bool isIdol(int row, int col) const;
 	bool canPlayerOccupy(int row, int col) const;
+	// Free for a monster: no monster nor living player there
+	bool canMonsterOccupy(int row, int col) const;
+
+	// Player can see the position now / has seen it on this level
+	bool isVisible(int row, int col) const;
+	bool isSeen(int row, int col) const;
 
 	Monster* monsterAt(int row, int col) const;
+	Player* playerAt(int row, int col) const; // Living players only
 	GameObject* objectAt(int row, int col) const;
 
 	void produceOpenPos(int& row, int& col) const; 
@@ -58,53 +128,113 @@ class Dungeon
 
 	// Display the grid with result printed out
 	void display(std::string result) const;
+	// Snapshot of what display shows (turn left for the caller)
+	void render(Frame& frame, const std::string& result) const;
 	// Kill monster and drop any items on tthe dungeon
-	bool killMonster(Monster* monster);
-	// Remove object from dungeon
-	bool removeObject(GameObject* object);
+	bool killMonster(SlotHandle monster);
+	// Remove object from dungeon and destroy it
+	bool removeObject(SlotHandle object);
 	// Move monsters on the dungeon
 	std::string attemptMoveMonsters();
+	// Real-time games: give every monster a tick of energy by the speed
+	// of its kind, moving those that have enough; acted is set if any
+	// did
+	std::string tickMonsters(bool& acted);
+	// Recompute what the player sees from where they stand
+	void updateFieldOfView();
+	// Store the level and everything on it into state
+	void capture(GameState& state) const;
+	// Bring player back onto a level kept while they were away
+	void enter(Player* player, int row, int col);
+	// Co-op: add player to the level at a random free spot (false if
+	// MAXPLAYERS are on it already). Monsters go after whichever
+	// living player is nearest (see TargetField.h).
+	bool joinPlayer(Player* player);
+	// Co-op: take every player but the first off the level
+	void dropCoopPlayers();
+	// Apply turns the player was away to the monsters in one coarse
+	// step (see DormantLevel.h)
+	void simulateDormant(int turns);
+	// Start building the distance table on a worker thread (does
+	// nothing if it is started already)
+	void startDistanceTable();
+	// Record changes in log from now on (nullptr to stop)
+	void setUndoLog(UndoLog* log) {m_undo = log;}
+	// Take back the change of record, made to the level itself
+	// (monsters killed, objects put down or picked up, cells seen)
+	void undo(const UndoRecord& record, UndoLog& log);
 
 	/////////////////////////////////////////////////////////////////
   private:
 	/////////////////////////////////////////////////////////////////
-	char m_baseGrid[MAXCOLS][MAXCOLS]; // Base grid 
+	char m_baseGrid[MAXROWS][MAXCOLS]; // Base grid 
+	bool m_visible[MAXROWS][MAXCOLS];  // Cells in the player's view
+	bool m_seen[MAXROWS][MAXCOLS];     // Cells ever in the player's view
 
 	int m_rows;  // Number of rows in Dungeon
 	int m_cols;  // Number of rows in Dungeon
 	
 	int m_level; // Level of Dungeon
 	Player* m_player;  // Pointer to player
+	std::vector<Player*> m_players; // m_player, then co-op players
+	Rng* m_rng;        // Game's random number generator
+	TargetField* m_targets; // Nearest player to each cell (co-op only)
+	RoomGraph* m_roomGraph; // Rooms, corridors and steps between them
+	DistanceTable* m_distances;         // Built by m_distanceWorker,
+	std::thread m_distanceWorker;       // handed out once
+	std::atomic<bool> m_distancesReady; // m_distancesReady is set
+	UndoLog* m_undo;   // Log of the changes made, if kept
+
+	uint64_t m_terrainKey; // Zobrist key of the terrain (see GameState.h)
+	uint64_t m_key;        // Of the terrain, depth, monsters and objects
 
 	int m_goblinSmellDist; // Goblin smell distance
 
-	std::vector<GameObject*> m_objects; // collection of GameObjects
-	std::vector<Monster*> m_monsters;   // collection of Monsters
+	SlotMap<GameObject*> m_objects; // collection of GameObjects
+	SlotMap<Monster*> m_monsters;   // collection of Monsters
+
+	// What each monster does this turn (see planMonsters)
+	struct MonsterPlan
+	{
+		unsigned char action; // MonsterAction (Rules.h)
+		Player* target;
+	};
+	std::vector<MonsterPlan> m_plans; // Indexed like m_monsters
+	std::vector<int> m_byKind;        // m_monsters indices, kind by kind
 
 	/////////////////////////////////////////////////////////////////
 	// Private Helper Functions
 	
-	// Generate empty rooms on the base grid and connect them
-	void generateRooms();
-	// Makes new objects to drop in the dungeon
-	GameObject* addNewObject(); 
-	// Makes new monsters to place in the dungeon
-	Monster* addNewMonster();
-	// Add player to valid random position on Dungeon
-	bool addPlayer(Player* p);
-
-	// Helper structure
-	struct Room
-	{
-		// Top left corner of room
-		int m_r, m_c;
-		// Height and Width of the room
-		int m_dr,m_dc;
-
-		Room(int r, int dr, int c, int dc) 
-		: m_r(r), m_c(c), m_dr(dr), m_dc(dc) {}
-		Room() {} 
-	};
+	// Makes the monster or object planned by the level generator
+	void addSpawn(const Spawn& spawn);
+	// A monster of kind, or an object of item, at (row, col)
+	Monster* makeMonster(int kind, int row, int col);
+	GameObject* makeObject(const Item& item, int row, int col);
+	// Put a new monster or object on the level
+	void addMonster(Monster* monster);
+	void addObject(GameObject* object);
+	// Add player to the given position on Dungeon
+	bool addPlayer(Player* p, int row, int col);
+	// A monster's turn goes in two passes. The first takes the
+	// monsters kind by kind, doing what depends on nobody else (a
+	// tick's energy, sleeping) and planning the rest: whom to go
+	// after, and whether to attack or move. acted is set if any
+	// monster has the energy to act (always, unless ticking).
+	void planMonsters(bool ticking, bool& acted);
+	template<typename Kind> void planKind(int begin, int end, bool ticking, bool& acted);
+	// The second carries the plans out in the order the monsters
+	// move, as each move sees where the monsters before it went.
+	// Attacks are queued in batch, with the attacker and the player
+	// attacked at the same index in attackers and defenders, for
+	// resolveAttacks to carry out, adding any message to result.
+	void monstersAct(CombatBatch& batch, Monster* attackers[],
+		Player* defenders[], std::string& result);
+	void resolveAttacks(CombatBatch& batch, Monster* const attackers[],
+		Player* const defenders[], std::string& result);
+	// Work out whom the monsters go after this turn, and the player a
+	// monster goes after (nullptr once every player is dead)
+	void findTargets();
+	Player* targetOf(const Monster* monster) const;
 
 	/////////////////////////////////////////////////////////////////
 };
@@ -132,6 +262,14 @@ bool Dungeon::isStair(int row, int col) const
 	return isStair;	
 }
 
+inline 
+bool Dungeon::isUpStair(int row, int col) const
+	// return true iff there are stairs up in the positon
+{
+	return row >= 0 && row < rows() && col >= 0 && col < cols()
+		&& m_baseGrid[row][col] == UPSTAIR;
+}
+
 inline 
 bool Dungeon::isIdol(int row, int col) const
 	// return true iff there is idol in the positon
@@ -148,4 +286,30 @@ bool Dungeon::canPlayerOccupy(int row, int col) const
 	return (!isWall(row, col) && !monsterAt(row, col));
 }
 
+inline
+bool Dungeon::canMonsterOccupy(int row, int col) const
+{
+	return canPlayerOccupy(row, col) && !playerAt(row, col);
+}
+
+inline
+const DistanceTable* Dungeon::distanceTable() const
+{
+	return m_distancesReady.load(std::memory_order_acquire) ? m_distances : nullptr;
+}
+
+inline
+bool Dungeon::isVisible(int row, int col) const
+{
+	return row >= 0 && row < rows() && col >= 0 && col < cols()
+		&& m_visible[row][col];
+}
+
+inline
+bool Dungeon::isSeen(int row, int col) const
+{
+	return row >= 0 && row < rows() && col >= 0 && col < cols()
+		&& m_seen[row][col];
+}
+
 #endif // DUNGEON_INCLUDED
\ No newline at end of file
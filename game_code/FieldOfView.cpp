@@ -0,0 +1,159 @@
+#include <cstring>
+
+#include "FieldOfView.h"
+#include "Dungeon.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////
+// Precomputed Tables
+////////////////////////////////////////////////////////////////////
+
+const int NUMOCTANTS = 8;
+
+// Cells of an octant up to MAXFOVRADIUS, row by row
+// (cell col of row depth is at depth*(depth+1)/2 + col)
+const int OCTANTCELLS = (MAXFOVRADIUS + 1) * (MAXFOVRADIUS + 2) / 2;
+
+// Octant transforms: position of cell (depth, col) of an octant
+// relative to the viewer
+static const int OCTANTTRANSFORM[NUMOCTANTS][4] =
+{
+	// row from depth, row from col, col from depth, col from col
+	{-1,  0,  0,  1}, {-1,  0,  0, -1}, // Up
+	{ 1,  0,  0,  1}, { 1,  0,  0, -1}, // Down
+	{ 0,  1,  1,  0}, { 0, -1,  1,  0}, // Right
+	{ 0,  1, -1,  0}, { 0, -1, -1,  0}  // Left
+};
+
+struct FovTables
+{
+	// Offset of each octant cell from the viewer
+	signed char rowOffset[NUMOCTANTS][OCTANTCELLS];
+	signed char colOffset[NUMOCTANTS][OCTANTCELLS];
+
+	// For each radius, last col of each row inside the circle
+	signed char lastCol[MAXFOVRADIUS + 1][MAXFOVRADIUS + 1];
+
+	FovTables();
+};
+
+FovTables::FovTables()
+{
+	for(int o = 0; o < NUMOCTANTS; o++)
+		for(int depth = 0; depth <= MAXFOVRADIUS; depth++)
+			for(int col = 0; col <= depth; col++)
+			{
+				int cell = depth * (depth + 1) / 2 + col;
+				const int* t = OCTANTTRANSFORM[o];
+				rowOffset[o][cell] = depth * t[0] + col * t[1];
+				colOffset[o][cell] = depth * t[2] + col * t[3];
+			}
+
+	// Cells within radius + 1/2 of the viewer count as inside
+	for(int radius = 0; radius <= MAXFOVRADIUS; radius++)
+		for(int depth = 0; depth <= MAXFOVRADIUS; depth++)
+		{
+			int last = -1;
+			for(int col = 0; col <= depth; col++)
+				if(col * col + depth * depth <= radius * radius + radius)
+					last = col;
+			lastCol[radius][depth] = last;
+		}
+}
+
+static const FovTables& fovTables()
+{
+	static const FovTables tables; // Built once, on first use
+	return tables;
+}
+
+////////////////////////////////////////////////////////////////////
+// Shadowcasting
+////////////////////////////////////////////////////////////////////
+
+// Row of an octant still to be scanned, with the sector of light
+// reaching it (slopes col/depth as fractions)
+struct ScanRow
+{
+	int depth;
+	int startNum, startDen;
+	int endNum, endDen;
+};
+
+static int ceilDiv(int num, int den)
+	// Rounds num/den up (den > 0)
+{
+	return (num >= 0) ? (num + den - 1) / den : -(-num / den);
+}
+
+void computeFieldOfView(const char grid[MAXROWS][MAXCOLS], int rows, int cols,
+	int row, int col, int radius, bool visible[MAXROWS][MAXCOLS])
+{
+	memset(visible, 0, sizeof(bool) * MAXROWS * MAXCOLS);
+	if(row < 0 || row >= rows || col < 0 || col >= cols)
+		return;
+	visible[row][col] = true; // Viewer sees its own cell
+	if(radius > MAXFOVRADIUS) radius = MAXFOVRADIUS;
+
+	const FovTables& tables = fovTables();
+	const signed char* lastCol = tables.lastCol[radius];
+
+	// Rows waiting to be scanned (each row adds at most one per
+	// two of its cells, so this bounds the pending rows)
+	ScanRow pending[MAXFOVRADIUS * MAXFOVRADIUS];
+
+	for(int o = 0; o < NUMOCTANTS; o++)
+	{
+		const signed char* rowOffset = tables.rowOffset[o];
+		const signed char* colOffset = tables.colOffset[o];
+
+		int numPending = 0;
+		if(radius >= 1)
+			pending[numPending++] = {1, 0, 1, 1, 1};
+
+		while(numPending > 0)
+		{
+			ScanRow curr = pending[--numPending];
+			int depth = curr.depth;
+
+			// Cells whose centers are in the sector (ties rounded
+			// towards the sector)
+			int firstCol = (2 * depth * curr.startNum + curr.startDen) / (2 * curr.startDen);
+			int endCol = ceilDiv(2 * depth * curr.endNum - curr.endDen, 2 * curr.endDen);
+			if(endCol > depth) endCol = depth;
+
+			int base = depth * (depth + 1) / 2;
+			int prevWall = -1; // Previous cell: -1 none, 0 floor, 1 wall
+			for(int c = firstCol; c <= endCol; c++)
+			{
+				int r = row + rowOffset[base + c];
+				int k = col + colOffset[base + c];
+				bool inGrid = (r >= 0 && r < rows && k >= 0 && k < cols);
+				bool wall = !inGrid || grid[r][k] == WALL;
+
+				// Walls are seen when lit at all, floors when their
+				// center is lit
+				if(inGrid && c <= lastCol[depth]
+					&& (wall || (c * curr.startDen >= depth * curr.startNum
+								 && c * curr.endDen <= depth * curr.endNum)))
+					visible[r][k] = true;
+
+				// Leaving a shadow: light restarts at this cell's edge
+				if(prevWall == 1 && !wall)
+				{
+					curr.startNum = 2 * c - 1;
+					curr.startDen = 2 * depth;
+				}
+				// Entering a shadow: light so far goes on to next row
+				if(prevWall == 0 && wall && depth < radius)
+					pending[numPending++] = {depth + 1, curr.startNum, curr.startDen,
+											 2 * c - 1, 2 * depth};
+				prevWall = wall ? 1 : 0;
+			}
+			if(prevWall == 0 && depth < radius)
+				pending[numPending++] = {depth + 1, curr.startNum, curr.startDen,
+										 curr.endNum, curr.endDen};
+		}
+	}
+}
@@ -0,0 +1,31 @@
+// FieldOfView.h
+
+#ifndef FIELDOFVIEW_INCLUDED
+#define FIELDOFVIEW_INCLUDED
+
+#include "Dungeon.h"
+
+const int FOVRADIUS = 8;     // How far the player sees
+const int MAXFOVRADIUS = 16; // Largest radius with precomputed tables
+
+////////////////////////////////////////////////////////////////////
+// Field of View
+//
+// Symmetric shadowcasting: a floor cell is visible when its center
+// lies in a sector of light that is not blocked, a wall cell when
+// any part of it does, so a cell seen from another sees it back.
+//
+// The area around the viewer is scanned as 8 octants, row by row
+// outwards. The cell offsets of every octant, and how far each row
+// reaches within the radius, are precomputed once per radius, so a
+// scan only touches the cells that end up lit and the walls
+// bordering them.
+////////////////////////////////////////////////////////////////////
+
+// Find the cells visible from (row, col) within radius, in a grid
+// of rows x cols cells where WALL cells block the view. visible is
+// cleared first; cells outside the grid are never visible.
+void computeFieldOfView(const char grid[MAXROWS][MAXCOLS], int rows, int cols,
+	int row, int col, int radius, bool visible[MAXROWS][MAXCOLS]);
+
+#endif // FIELDOFVIEW_INCLUDED
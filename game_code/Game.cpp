@@ -10,6 +10,12 @@
 #include "GameObject.h"
 #include "Weapon.h"
 #include "Scroll.h"
+#include "GameState.h"
+#include "Spectator.h"
+#include "Pipeline.h"
+#include "RealTime.h"
+#include "Definitions.h"
+#include "UndoLog.h"
 
 using namespace std;
 
@@ -18,182 +24,653 @@ using namespace std;
 ////////////////////////////////////////////////////////////////////
 
 Game::Game(int goblinSmellDistance)
-	: m_goblinSmellDist(goblinSmellDistance)
+	: Game(goblinSmellDistance,
+		   uint64_t(randInt(0, 0x7FFFFFFF)) << 31 | randInt(0, 0x7FFFFFFF))
+{}
+
+Game::Game(int goblinSmellDistance, uint64_t seed)
+	: m_player(nullptr), m_currDungeon(nullptr),
+	  m_goblinSmellDist(goblinSmellDistance), m_endless(false), m_distanceTables(false),
+	  m_levels(nullptr), m_undo(nullptr)
 {
-	// Creating a new player
-	m_player = new Player();
+	reset(seed);
+}
 
-	// Creating a first level Dungeon
-	m_currDungeon = new Dungeon(0, m_player, goblinSmellDistance);
+Game::Game(int goblinSmellDistance, uint64_t seed, const string& cachePath,
+	int hotLevels, int warmLevels)
+	: m_player(nullptr), m_currDungeon(nullptr),
+	  m_goblinSmellDist(goblinSmellDistance), m_endless(true), m_distanceTables(false),
+	  m_levels(new LevelCache(cachePath, hotLevels, warmLevels)), m_undo(nullptr)
+{
+	reset(seed);
+}
+
+Game::Game(const GameState& state)
+	: m_player(nullptr), m_currDungeon(nullptr), m_endless(false),
+	  m_distanceTables(false), m_levels(nullptr), m_undo(nullptr)
+{
+	restore(state);
 }
 
 Game::~Game()
 {
+	delete m_undo;
+	delete m_levels;
 	delete m_currDungeon;
 	delete m_player;
+	clearParty();
 }
 
 void Game::play()
 {
-	// Initializing variables 
-	int newRow, newCol;
-	Monster* monster;
-	GameObject* object;
-	string playerResult, monsterResult;
+	static TerminalKeySource keyboard; // Outlives a reader left waiting on it
+	TtyFrameSink screen;
+	play(keyboard, screen);
+}
 
-	bool hasWon = false;
+void Game::play(KeySource& keys, FrameSink& sink, QuantileSketch* latency,
+	bool threaded)
+{
+	InputReader input(keys, threaded);
+	Renderer renderer(sink, threaded);
+	TurnSnapshot shown;
+	shown.fromKey = false;
 
-	m_currDungeon->display(""); // Display the first level
+	showTurn(renderer, shown, ""); // Display the first level
 
-	char command = getCharacter(); // Get the first command
+	KeyEvent key = input.next(); // Get the first command
+	char command = key.key;
 
     while (command != 'q')    // While the player has not quit
 	{
-		playerResult = ""; // Result is set to nothing by default
+		char choice = 0; // Inventory key for wielding or reading
+		shown.fromKey = true;
+		shown.pressed = key.pressed;
 
-		// If player is sleeping, skipping executing command
-		if(m_player->isAsleep())
+		// Sleeping players can't look into their inventory
+		if(!m_player->isAsleep())
 		{
-			m_player->reduceSleep(); // Reducing sleep time
-			command = 's'; // Dummy command to skip command execution
+			//////////////////////////////////////////////////////
+			// Display Inventory Command
+			if(command == 'i')
+			{
+				showInventory(renderer, shown);
+				key = input.next(); // To exit inventory
+				shown.pressed = key.pressed;
+			}
+			//////////////////////////////////////////////////////
+			// Wield Weapon or Read Scroll Command
+			else if(command == 'w' || command == 'r')
+			{
+				showInventory(renderer, shown);
+				key = input.next(); // Item to wield or read
+				choice = key.key;
+				shown.pressed = key.pressed;
+			}
 		}
 
-		// 1 in 10 change the player recovers health
-		if(trueWithProbability(1.0/10.0))
-		{
-			m_player->attemptRegainHealth();
-		}
+		// Play the turn
+		string result = step(command, choice);
 		
 		//////////////////////////////////////////////////////
-		// Direction Command
-		if(commandToNewPos(command, newRow, newCol)) 
+		// Checking if game needs to be ended
+		if(isOver()) // Player has won or is dead
+		{ 
+			result += "\nPress q to exit game.";
+			showTurn(renderer, shown, result);
+			while(input.next().key != 'q'); // Wait till player quits
+			break; // End game
+		}
+
+		//////////////////////////////////////////////////////
+		// Display updated grid
+		showTurn(renderer, shown, result);
+
+		//////////////////////////////////////////////////////
+		// Take new command
+		key = input.next();
+		command = key.key;
+	}
+
+	renderer.finish();
+	if(latency) latency->merge(renderer.latency());
+}
+
+void Game::playRealTime(KeySource& keys, FrameSink& sink, TickStats* stats)
+{
+	InputReader input(keys); // Threaded, so keys can be polled
+	Renderer renderer(sink);
+	TickClock clock;
+	TurnSnapshot shown;
+	shown.fromKey = false;
+
+	showTurn(renderer, shown, ""); // Display the first level
+
+	char held = 0, heldChoice = 0; // Command waiting for the player
+	char looking = 0; // 'i', 'w' or 'r' while the inventory is shown
+	TimePoint heldPressed;
+	bool quit = false;
+	KeyEvent key;
+	string message; // Last message, and ticks it has been shown
+	int messageTicks = 0;
+
+	while(!quit && !isOver())
+	{
+		int due = clock.waitForTicks();
+		for(int t = 0; t < due && !quit && !isOver(); t++)
 		{
-			if(m_currDungeon->isWall(newRow, newCol))
-				; // Do nothing if player tires to walk into a wall
+			TimePoint start = chrono::steady_clock::now();
 
-			else if(
-				// If there is a monster at the new position
-				(monster = m_currDungeon->monsterAt(newRow, newCol)) != nullptr) 
+			//////////////////////////////////////////////////////
+			// Reading keys until one is held (never waiting)
+			while(!held && input.poll(key))
 			{
-				// Do attacking
-				playerResult = m_player->attemptAttack(monster);
-				if(monster->isDead()) // If player killed monster
+				if(looking) // Key closing the inventory
+				{
+					if(looking != 'i')
+					{
+						held = looking;
+						heldChoice = key.key; // Item to wield or read
+						heldPressed = key.pressed;
+					}
+					looking = 0;
+				}
+				else if(key.key == 'q')
+				{
+					quit = true;
+					break;
+				}
+				else if(m_player->isAsleep())
+					; // Sleeping players' keys are lost
+				else if(key.key == 'i' || key.key == 'w' || key.key == 'r')
 				{
-					// Remove monster from dungeon and drop any items
-					m_currDungeon->killMonster(monster); 
+					looking = key.key;
+					shown.fromKey = true;
+					shown.pressed = key.pressed;
+					showInventory(renderer, shown);
+				}
+				else
+				{
+					held = key.key;
+					heldChoice = 0;
+					heldPressed = key.pressed;
 				}
 			}
-			else // Player can move to the new position
+			if(quit) break;
+
+			//////////////////////////////////////////////////////
+			// Playing the tick, with the held command if the player
+			// is ready for it
+			char command = 0, choice = 0;
+			if(held && playerReady())
 			{
-				// Move player
-				m_player->setPos(newRow, newCol);
-				// No update to result string needed here 
+				command = held;
+				choice = heldChoice;
+				held = 0;
 			}
-		}
-
-		//////////////////////////////////////////////////////
-		// Pick up Command
-		else if(tolower(command) == 'g')
-		{
-			if(m_currDungeon->isIdol(m_player->row(),m_player->col()))
-			// If player is at idol
+			string result = tick(command, choice);
+			if(result != "")
 			{
-				// Game Won!
-				playerResult = "You pick up the golden idol\n";     
-				playerResult += "Congratulations, you won!";
-				hasWon = true; // Indicate game has been won
+				message = result;
+				messageTicks = 0;
 			}
-			
-			// Else if player is trying to pick some other obejet
-			else if( (object = m_currDungeon->objectAt(m_player->row(),m_player->col())) != nullptr )
-			// If there is an object at Player's pos
+			else if(message != "" && ++messageTicks >= MESSAGETICKS)
+				message = "";
+
+			// The level stays hidden while the inventory is shown
+			if(!looking || isOver())
 			{
-				playerResult = m_player->attemptPickUp(object);
+				shown.fromKey = command != 0;
+				shown.pressed = heldPressed;
+				showTurn(renderer, shown, message);
 			}
+			clock.ticked(start);
 		}
+	}
 
-		//////////////////////////////////////////////////////
-		// Display Inventory Command
-		else if(command == 'i')
+	//////////////////////////////////////////////////////
+	// Checking if game needs to be ended
+	if(isOver()) // Player has won or is dead
+	{
+		shown.fromKey = false;
+		showTurn(renderer, shown, message + "\nPress q to exit game.");
+		while(input.next().key != 'q'); // Wait till player quits
+	}
+
+	renderer.finish();
+	if(stats) stats->merge(clock.stats());
+}
+
+void Game::reset(uint64_t seed)
+{
+	// Clearing the previous game
+	if(m_levels) m_levels->clear();
+	if(m_undo) m_undo->clear();
+	delete m_currDungeon;
+	delete m_player;
+	clearParty();
+
+	m_rng.setSeed(seed);
+	m_turns = 0;
+	m_ticks = 0;
+	m_hasWon = false;
+	for(int k = 0; k < NUMWEAPONKINDS; k++)
+		m_damageDealt[k] = 0;
+	m_itemsCollected = 0;
+
+	// Creating a new player
+	m_player = new Player();
+
+	// Creating a first level Dungeon
+	m_currDungeon = new Dungeon(0, m_player, m_goblinSmellDist, m_rng,
+		MAXROWS, MAXCOLS, ROOMROW, m_endless);
+	if(m_distanceTables) m_currDungeon->startDistanceTable();
+	m_currDungeon->setUndoLog(m_undo);
+}
+
+GameState Game::fork() const
+{
+	GameState state;
+	state.rng = m_rng;
+	state.turns = m_turns;
+	state.goblinSmellDist = m_goblinSmellDist;
+	state.hasWon = m_hasWon;
+	state.endless = m_endless;
+	for(int k = 0; k < NUMWEAPONKINDS; k++)
+		state.damageDealt[k] = m_damageDealt[k];
+	state.itemsCollected = m_itemsCollected;
+
+	captureActor(*m_player, state.player);
+	state.maxHit = m_player->maxHitPts();
+	state.inventory = m_player->inventory();
+
+	m_currDungeon->capture(state);
+	state.zobrist = hash();
+	return state;
+}
+
+uint64_t Game::hash() const
+{
+	uint64_t hash = m_currDungeon->key() ^ m_player->key();
+	if(m_hasWon) hash ^= zobristWon();
+	return hash;
+}
+
+void Game::restore(const GameState& state)
+{
+	// Clearing the current game
+	if(m_levels) m_levels->clear();
+	if(m_undo) m_undo->clear();
+	delete m_currDungeon;
+	delete m_player;
+	clearParty();
+
+	m_rng = state.rng;
+	m_turns = state.turns;
+	m_ticks = 0;
+	m_goblinSmellDist = state.goblinSmellDist;
+	m_hasWon = state.hasWon;
+	m_endless = state.endless;
+	for(int k = 0; k < NUMWEAPONKINDS; k++)
+		m_damageDealt[k] = state.damageDealt[k];
+	m_itemsCollected = state.itemsCollected;
+
+	// Rebuilding the player and the level
+	m_player = new Player();
+	restoreActor(state.player, *m_player);
+	m_player->setMaxHitPts(state.maxHit);
+	m_player->setKilledBy(state.playerKiller);
+	m_player->setInventory(state.inventory);
+
+	m_currDungeon = new Dungeon(state, m_player, m_rng);
+	if(m_distanceTables) m_currDungeon->startDistanceTable();
+	if(m_endless) stopUndoLog(); // Endless games aren't recorded
+	m_currDungeon->setUndoLog(m_undo);
+}
+
+string Game::step(char command, char choice)
+{
+	if(m_party.empty())
+		return step(&command, &choice);
+
+	// Co-op players stand by
+	vector<char> commands(numPlayers(), 0), choices(numPlayers(), 0);
+	commands[0] = command;
+	choices[0] = choice;
+	return step(commands.data(), choices.data());
+}
+
+string Game::step(const char commands[], const char choices[])
+{
+	string playerResult = ""; // Result is set to nothing by default
+
+	if(isOver()) return playerResult; // Nothing happens after the end
+	startTurn();
+
+	for(int p = 0; p < numPlayers() && !m_hasWon; p++)
+	{
+		Player* player = (p == 0) ? m_player : m_party[p-1];
+		if(player->isDead()) continue; // Fallen co-op players
+		char command = commands[p];
+		char choice = choices ? choices[p] : 0;
+
+		// If player is sleeping, skipping executing command
+		if(player->isAsleep())
 		{
-			m_player->displayInventory();
-			getCharacter(); // To exit inventory
+			player->reduceSleep(); // Reducing sleep time
+			command = 's'; // Dummy command to skip command execution
 		}
-		
-		//////////////////////////////////////////////////////
-		// Wield Weapon Command
-		else if(command == 'w')
+
+		// Some chance (1 in 10 by default) the player recovers health
+		if(m_rng.trueWithProbability(definitions().regenChance))
 		{
-			m_player->displayInventory();
-			// Try to wield weapon according to input
-			playerResult = m_player->attemptWieldWeapon(getCharacter()); 
+			player->attemptRegainHealth();
 		}
+		
+		// Player's move
+		string result = playerAct(player, command, choice);
+		if(playerResult != "" && result != "")
+			playerResult += "\n";
+		playerResult += result;
+	}
 
-		//////////////////////////////////////////////////////
-		// Read Scroll Command
-		else if(command == 'r')
+	//////////////////////////////////////////////////////
+	// Move monsters
+	string monsterResult = m_currDungeon->attemptMoveMonsters();
+	m_turns++;
+
+	// Update what the player sees after everyone moved
+	m_currDungeon->updateFieldOfView();
+
+	// Get result of the move
+	if(playerResult != "" && monsterResult != "") 
+	// If both player and monster return a result
+	// Concatenating them with a line in the middle
+		return playerResult + "\n" + monsterResult;
+	return playerResult + monsterResult;
+}
+
+int Game::addPlayer()
+{
+	if(numPlayers() >= MAXPLAYERS) return -1;
+	stopUndoLog(); // Co-op players aren't recorded
+	Player* player = new Player();
+	if(!m_currDungeon->joinPlayer(player))
+	{
+		delete player;
+		return -1;
+	}
+	m_party.push_back(player);
+	return numPlayers() - 1;
+}
+
+string Game::tick(char command, char choice)
+{
+	string playerResult = "";
+	if(isOver()) return playerResult; // Nothing happens after the end
+	startTurn();
+
+	// A turn goes by every TICKSPERTURN ticks, with the player's
+	// chance of healing
+	m_ticks++;
+	if(m_ticks % TICKSPERTURN == 0)
+	{
+		m_turns++;
+		if(m_rng.trueWithProbability(definitions().regenChance))
+			m_player->attemptRegainHealth();
+	}
+
+	// The player sleeps off their sleep as quickly as they would act
+	bool playerActed = false;
+	m_player->gainEnergy(definitions().playerSpeed);
+	if(m_player->isAsleep())
+	{
+		if(m_player->spendEnergy())
+			m_player->reduceSleep();
+	}
+	else if(command != 0 && m_player->spendEnergy())
+	{
+		playerResult = playerAct(m_player, command, choice);
+		playerActed = true;
+	}
+
+	bool monstersActed;
+	string monsterResult = m_currDungeon->tickMonsters(monstersActed);
+	if(playerActed || monstersActed)
+		m_currDungeon->updateFieldOfView();
+
+	if(playerResult != "" && monsterResult != "") 
+		return playerResult + "\n" + monsterResult;
+	return playerResult + monsterResult;
+}
+
+bool Game::playerReady() const
+{
+	return !isOver() && !m_player->isAsleep() &&
+		m_player->energy() + definitions().playerSpeed >= ACTIONENERGY;
+}
+
+string Game::playerAct(Player* player, char command, char choice)
+{
+	// Initializing variables 
+	int newRow, newCol;
+	Monster* monster;
+	GameObject* object;
+	string playerResult = ""; // Result is set to nothing by default
+
+	//////////////////////////////////////////////////////
+	// Direction Command
+	if(commandToNewPos(player, command, newRow, newCol)) 
+	{
+		if(m_currDungeon->isWall(newRow, newCol))
+			; // Do nothing if player tires to walk into a wall
+
+		else if(m_currDungeon->playerAt(newRow, newCol))
+			; // Co-op players don't walk into each other
+
+		else if(
+			// If there is a monster at the new position
+			(monster = m_currDungeon->monsterAt(newRow, newCol)) != nullptr) 
 		{
-			m_player->displayInventory();
-			// Try to read scroll according to input
-			playerResult = m_player->attemptReadScroll(getCharacter()); 
+			// Do attacking (keeping count of the damage done)
+			int hitBefore = monster->hitPts();
+			int kind = player->weapon().kind;
+			playerResult = player->attemptAttack(monster);
+			if(player == m_player) // Co-op players' damage isn't counted
+				m_damageDealt[kind] += hitBefore - monster->hitPts();
+			if(monster->isDead()) // If player killed monster
+			{
+				// Remove monster from dungeon and drop any items
+				m_currDungeon->killMonster(monster->handle());
+			}
 		}
-
-		//////////////////////////////////////////////////////
-		// Cheat Command
-		else if(command == 'c')
+		else // Player can move to the new position
 		{
-			m_player->cheat();
+			// Move player
+			player->setPos(newRow, newCol);
+			// No update to result string needed here 
 		}
+	}
 
-		//////////////////////////////////////////////////////
-		// Go Down Stairs Command
-		else if(command == '>' &&
-				m_currDungeon->isStair(m_player->row(), m_player->col()) )
+	//////////////////////////////////////////////////////
+	// Pick up Command
+	else if(tolower(command) == 'g')
+	{
+		if(m_currDungeon->isIdol(player->row(),player->col()))
+		// If player is at idol
 		{
-			proceedToNextLevel();
+			// Game Won!
+			playerResult = "You pick up the golden idol\n";     
+			playerResult += "Congratulations, you won!";
+			m_hasWon = true; // Indicate game has been won
 		}
-
-		//////////////////////////////////////////////////////
-		// Move monsters
-		string monsterResult = m_currDungeon->attemptMoveMonsters();
-
-		// Get result of the move to display
-		string result;
-		if(playerResult != "" && monsterResult != "") 
-		// If both player and monster return a result
-		// Concatenating them with a line in the middle
-			result = playerResult + "\n" + monsterResult;
-		else 
-			result = playerResult + monsterResult;
 		
-		//////////////////////////////////////////////////////
-		// Checking if game needs to be ended
-		if(m_player->isDead() || hasWon) // Player has won or is dead
-		{ 
-			result += "\nPress q to exit game.";
-			m_currDungeon->display(result);
-			while(getCharacter() != 'q'); // Wait till player quits
-			break; // End game
+		// Else if player is trying to pick some other obejet
+		else if( (object = m_currDungeon->objectAt(player->row(),player->col())) != nullptr )
+		// If there is an object at Player's pos
+		{
+			int itemsBefore = player->inventory().size();
+			playerResult = player->attemptPickUp(object);
+			m_itemsCollected += player->inventory().size() - itemsBefore;
 		}
+	}
 
-		//////////////////////////////////////////////////////
-		// Display updated grid
-		m_currDungeon->display(result);
+	//////////////////////////////////////////////////////
+	// Wield Weapon Command
+	else if(command == 'w')
+	{
+		// Try to wield weapon according to input
+		playerResult = player->attemptWieldWeapon(choice); 
+	}
 
-		//////////////////////////////////////////////////////
-		// Take new command
-		command = getCharacter();
+	//////////////////////////////////////////////////////
+	// Read Scroll Command
+	else if(command == 'r')
+	{
+		// Try to read scroll according to input
+		playerResult = player->attemptReadScroll(choice); 
 	}
+
+	//////////////////////////////////////////////////////
+	// Cheat Command
+	else if(command == 'c')
+	{
+		player->cheat();
+	}
+
+	//////////////////////////////////////////////////////
+	// Go Down Stairs Command
+	else if(command == '>' &&
+			m_currDungeon->isStair(player->row(), player->col()) )
+	{
+		proceedToNextLevel();
+	}
+
+	//////////////////////////////////////////////////////
+	// Go Up Stairs Command (endless games)
+	else if(command == '<' &&
+			m_currDungeon->isUpStair(player->row(), player->col()) )
+	{
+		returnToPreviousLevel();
+	}
+	return playerResult;
+}
+
+void Game::useDistanceTables(bool use)
+{
+	m_distanceTables = use;
+	if(use) m_currDungeon->startDistanceTable();
+}
+
+bool Game::startUndoLog()
+{
+	if(m_endless || !m_party.empty()) return false;
+	if(!m_undo) m_undo = new UndoLog;
+	m_currDungeon->setUndoLog(m_undo);
+	return true;
+}
+
+void Game::stopUndoLog()
+{
+	if(m_currDungeon) m_currDungeon->setUndoLog(nullptr);
+	delete m_undo;
+	m_undo = nullptr;
+}
+
+int Game::undoableTurns() const
+{
+	return m_undo ? m_undo->turns() : 0;
+}
+
+bool Game::undoTurn()
+	// Carry out the operations recorded, newest first, back to the
+	// start of the turn, with nothing recorded meanwhile
+{
+	if(!m_undo || m_undo->turns() == 0) return false;
+	m_currDungeon->setUndoLog(nullptr);
+	const Dungeon* level = m_currDungeon;
+	int row = m_player->row(), col = m_player->col();
+
+	UndoRecord record;
+	while(m_undo->pop(record) && record.op != UndoRecord::TURN)
+	{
+		switch(record.op)
+		{
+			case UndoRecord::LEVELLEFT:
+				// Back to the level kept, where the player left it
+				delete m_currDungeon;
+				m_currDungeon = m_undo->popLevel();
+				m_player->setDungeon(m_currDungeon);
+				m_player->setPos(record.a, record.b);
+				break;
+			case UndoRecord::MOVE:
+			case UndoRecord::STAT:
+			case UndoRecord::WEAPON:
+			case UndoRecord::ITEMPUSHED:
+			case UndoRecord::ITEMERASED:
+			{
+				Actor* actor = record.player ? record.player
+					: m_currDungeon->monster(record.handle);
+				actor->undo(record, *m_undo);
+				break;
+			}
+			default:
+				m_currDungeon->undo(record, *m_undo);
+		}
+	}
+
+	// What the turn changed of the game itself
+	TurnMark mark = m_undo->popTurn();
+	m_rng.setState(mark.rng);
+	m_turns = mark.turns;
+	m_ticks = mark.ticks;
+	m_hasWon = mark.hasWon;
+	for(int k = 0; k < NUMWEAPONKINDS; k++)
+		m_damageDealt[k] = mark.damageDealt[k];
+	m_itemsCollected = mark.itemsCollected;
+
+	// The view only changes with where the player stands
+	if(m_currDungeon != level || m_player->row() != row || m_player->col() != col)
+		m_currDungeon->updateFieldOfView();
+	m_currDungeon->setUndoLog(m_undo);
+	return true;
+}
+
+bool Game::isOver() const
+{
+	return m_hasWon || partyDead();
+}
+
+bool Game::partyDead() const
+{
+	if(!m_player->isDead()) return false;
+	for(int p = 0; p < m_party.size(); p++)
+		if(!m_party[p]->isDead()) return false;
+	return true;
+}
+
+GameOutcome Game::outcome() const
+{
+	GameOutcome outcome;
+	outcome.won = m_hasWon;
+	outcome.dead = partyDead();
+	outcome.depth = m_currDungeon->level();
+	outcome.turns = m_turns;
+	outcome.killedBy = m_player->killedBy();
+	for(int k = 0; k < NUMWEAPONKINDS; k++)
+		outcome.damageDealt[k] = m_damageDealt[k];
+	outcome.itemsCollected = m_itemsCollected;
+	return outcome;
 }
 
 /////////////////////////////////////////////////////////////////
 // Private Helper Functions
 
-bool Game::commandToNewPos(char command, int& newRow, int& newCol)
+bool Game::commandToNewPos(const Player* player, char command, int& newRow, int& newCol)
 	// Take player move commands and convert them to new position
 {
-	int currRow = m_player->row();
-	int currCol = m_player->col();
+	int currRow = player->row();
+	int currCol = player->col();
 
 	switch(command)
 	{
@@ -214,14 +691,91 @@ void Game::proceedToNextLevel()
 {
 	int currLevel = m_currDungeon->level();
 
-	// Generate new level
-	Dungeon* newLevel = new Dungeon(currLevel+1, m_player, m_goblinSmellDist);
+	// Keep previous level in an endless game (or for the undo log),
+	// clear it otherwise
+	m_currDungeon->dropCoopPlayers();
+	if(m_levels)
+		m_levels->put(m_currDungeon, m_turns);
+	else if(m_undo)
+	{
+		m_currDungeon->setUndoLog(nullptr);
+		m_undo->levelLeft(m_currDungeon, m_player->row(), m_player->col());
+	}
+	else
+		delete m_currDungeon;
 
-	// Clear previous level
-	delete m_currDungeon;
+	// Going back to the level below if it is kept, or generating it
+	Player* leader = this->leader();
+	Dungeon* newLevel = m_levels ? m_levels->take(currLevel+1, leader, m_rng, m_turns) : nullptr;
+	if(!newLevel)
+		newLevel = new Dungeon(currLevel+1, leader, m_goblinSmellDist, m_rng,
+			MAXROWS, MAXCOLS, ROOMROW, m_endless);
 
 	// Update game
 	m_currDungeon = newLevel;
+	if(m_distanceTables) m_currDungeon->startDistanceTable();
+	m_currDungeon->setUndoLog(m_undo);
+	joinParty();
+}
+
+void Game::returnToPreviousLevel()
+	// Go back to the level above if it is kept (it is gone if the
+	// game was restored from a fork, and the stairs lead nowhere)
+{
+	int currLevel = m_currDungeon->level();
+	if(!m_levels || !m_levels->contains(currLevel-1))
+		return;
+
+	m_currDungeon->dropCoopPlayers();
+	m_levels->put(m_currDungeon, m_turns);
+	m_currDungeon = m_levels->take(currLevel-1, leader(), m_rng, m_turns);
+	if(m_distanceTables) m_currDungeon->startDistanceTable();
+	joinParty();
+}
+
+void Game::startTurn()
+	// Mark the start of a turn in the undo log, with what the turn
+	// can change of the game itself
+{
+	if(!m_undo) return;
+	TurnMark mark;
+	mark.rng = m_rng.state();
+	mark.turns = m_turns;
+	mark.ticks = m_ticks;
+	mark.hasWon = m_hasWon;
+	for(int k = 0; k < NUMWEAPONKINDS; k++)
+		mark.damageDealt[k] = m_damageDealt[k];
+	mark.itemsCollected = m_itemsCollected;
+	m_undo->turnStarted(mark);
+}
+
+Player* Game::leader() const
+{
+	for(int p = 0; p < numPlayers(); p++)
+	{
+		Player* player = (p == 0) ? m_player : m_party[p-1];
+		if(!player->isDead())
+			return player;
+	}
+	return m_player;
+}
+
+void Game::joinParty()
+	// Players still standing follow the leader to a new level
+{
+	for(int p = 0; p < numPlayers(); p++)
+	{
+		Player* player = (p == 0) ? m_player : m_party[p-1];
+		if(!player->isDead() && player != m_currDungeon->player(0))
+			m_currDungeon->joinPlayer(player);
+	}
+}
+
+void Game::clearParty()
+{
+	for(int p = 0; p < m_party.size(); p++)
+		delete m_party[p];
+	m_party.clear();
 }
 
 // You will presumably add to this project other .h/.cpp files for the
@@ -229,4 +783,23 @@ void Game::proceedToNextLevel()
 // weapons, etc.  You might have a separate .h/.cpp pair for each class
 // (e.g., Player.h, Boegeyman.h, etc.), or you might put the class
 // declarations for all actors in Actor.h, all game objects in GameObject.h,
-// etc.
\ No newline at end of file
+// etc.
+void Game::snapshot(Frame& frame, const string& result) const
+{
+	m_currDungeon->render(frame, result);
+	frame.turn = m_turns;
+}
+
+void Game::showTurn(Renderer& renderer, TurnSnapshot& shown, const string& result) const
+{
+	shown.showInventory = false;
+	snapshot(shown.frame, result);
+	renderer.show(shown);
+}
+
+void Game::showInventory(Renderer& renderer, TurnSnapshot& shown) const
+{
+	shown.showInventory = true;
+	shown.inventory = m_player->inventory();
+	renderer.show(shown);
+}
@@ -3,8 +3,37 @@
 #ifndef GAME_INCLUDED
 #define GAME_INCLUDED
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Rng.h"
+#include "Item.h"
+#include "LevelCache.h"
+
 class Dungeon;
 class Player;
+struct GameState;
+struct Frame;
+struct TurnSnapshot;
+class KeySource;
+class FrameSink;
+class Renderer;
+class QuantileSketch;
+struct TickStats;
+class UndoLog;
+
+// Summary of a game once it is over (or so far)
+struct GameOutcome
+{
+	bool won;     // Picked up the golden idol
+	bool dead;    // Killed by a monster
+	int depth;    // Level reached
+	int turns;    // Turns played
+	int killedBy; // MonsterKind that killed the first player (not co-op ones), -1 if none
+	int damageDealt[NUMWEAPONKINDS]; // By the first player (not co-op ones), per weapon kind
+	int itemsCollected; // Weapons and scrolls picked up
+};
 
 ////////////////////////////////////////////////////////////////////
 // Game Class Declarations
@@ -14,18 +43,134 @@ class Game
 {
   public:
     Game(int goblinSmellDistance);
+	Game(int goblinSmellDistance, uint64_t seed); // Reproducible game
+	// Endless game: no idol, stairs up ('<') and down on every level
+	// below the first, and the levels left behind kept in a LevelCache
+	// spilling to the file at cachePath
+	Game(int goblinSmellDistance, uint64_t seed, const std::string& cachePath,
+		int hotLevels = HOTLEVELS, int warmLevels = WARMLEVELS);
+	Game(const GameState& state); // Carry on a forked game
 	~Game();
 
     void play();
+	// Play with keys from keys and the screen sent to sink, reading,
+	// playing and showing on three threads (see Pipeline.h) unless
+	// threaded is false. Key to screen times in microseconds are
+	// merged into latency if given.
+	void play(KeySource& keys, FrameSink& sink, QuantileSketch* latency = nullptr,
+		bool threaded = true);
+	// Play in real time (see RealTime.h): the world goes on at a fixed
+	// tick rate whether keys are pressed or not. How the clock kept up
+	// is merged into stats if given.
+	void playRealTime(KeySource& keys, FrameSink& sink, TickStats* stats = nullptr);
+
+	// Start over with a new game played from seed
+	void reset(uint64_t seed);
+
+	// Play one turn without any input or output: the player's
+	// command (choice is the inventory key for 'w' and 'r'), then
+	// the monsters' moves. Returns the result message of the turn.
+	std::string step(char command, char choice = 0);
+
+	// Co-op: up to MAXPLAYERS players share the game's levels, and
+	// the monsters go after whichever is nearest. A player added
+	// joins the current level at a random free spot, and follows the
+	// others down (or up) stairs any of them takes. The game is over
+	// once every player is dead (or one picks up the idol). Forks
+	// only keep the first player.
+	// Add a player, returns its index (-1 if there are MAXPLAYERS)
+	int addPlayer();
+	// Play one co-op turn: every living player's command (and choice,
+	// if choices is given) in player order, then the monsters' moves
+	std::string step(const char commands[], const char choices[] = nullptr);
+	int numPlayers() const {return 1 + m_party.size();}
+	const Player* player(int i) const {return i == 0 ? m_player : m_party[i-1];}
+
+	// Real-time games: play one tick (see RealTime.h). Each actor
+	// gains energy and acts if it has enough, the player playing
+	// command (0 for none) then. Returns the result message of the
+	// tick.
+	std::string tick(char command, char choice = 0);
+	// A command given to the next tick would be played (otherwise it
+	// is ignored, and should be held until this is true)
+	bool playerReady() const;
+
+	// Player has won or is dead
+	bool isOver() const;
+
+	// Give every level entered from now on (the current one included)
+	// a table of the steps between its cells, built on a worker thread
+	// (see DistanceTable.h), for the monsters to look distances up
+	// instead of searching. Play is the same either way, only faster.
+	void useDistanceTables(bool use);
+
+	// Record every change the turns (or ticks) played from now on
+	// make, so they can be taken back (see UndoLog.h). Not for
+	// endless or co-op games: returns false for those (and adding a
+	// co-op player stops the log). Reset and restore start the log
+	// over.
+	bool startUndoLog();
+	void stopUndoLog();
+	// Turns recorded that undoTurn can take back
+	int undoableTurns() const;
+	// Take back the last turn recorded (false if there is none),
+	// leaving the game as it was before it, random numbers included
+	bool undoTurn();
+
+	// Independent copy of the whole game, random number generator
+	// included, as one flat block (see GameState.h). Holds only the
+	// current level, so levels above are forgotten on restore.
+	GameState fork() const;
+	// Carry on from a forked game state instead
+	void restore(const GameState& state);
+	// Zobrist hash of the position, the same as fork().hash() (the
+	// first player's, not co-op ones), kept up to date by the level,
+	// the player and the monsters as they change, so reading it is
+	// cheap enough for every turn
+	uint64_t hash() const;
+
+	const Player* player() const {return m_player;}
+	const Dungeon* dungeon() const {return m_currDungeon;}
+	// Levels left behind in an endless game (nullptr otherwise)
+	const LevelCache* levels() const {return m_levels;}
+
+	// Outcome of the game so far
+	GameOutcome outcome() const;
+
+	// Snapshot of the current turn for a Spectator, with result as
+	// the turn's message
+	void snapshot(Frame& frame, const std::string& result) const;
 
   private:
+	Rng m_rng;              // Source of all randomness in the game
 	Player* m_player;       // Player
 	Dungeon* m_currDungeon; // current level Dungeon 
 	int m_goblinSmellDist;  // Goblin smell distance
+	int m_turns;            // Turns played so far
+	int m_ticks;            // Ticks played in real time (since a reset)
+	bool m_hasWon;          // Golden idol picked up
+	bool m_endless;         // Endless game
+	bool m_distanceTables;  // Levels get distance tables
+	LevelCache* m_levels;   // Levels left behind in an endless game
+	UndoLog* m_undo;        // Changes recorded, nullptr if not kept
+	std::vector<Player*> m_party; // Co-op players after the first
+	int m_damageDealt[NUMWEAPONKINDS]; // By the first player, per weapon kind
+	int m_itemsCollected;   // Weapons and scrolls picked up
 
 	// Private Helper Functions
-	bool commandToNewPos(char command, int& newRow, int& newCol);
+	bool commandToNewPos(const Player* player, char command, int& newRow, int& newCol);
+	std::string playerAct(Player* player, char command, char choice);
+	bool partyDead() const;
+	// First living player (the first player if none is), whom a new
+	// level is entered and seen by
+	Player* leader() const;
+	void joinParty();
+	void clearParty();
 	void proceedToNextLevel();
+	void returnToPreviousLevel();
+	void startTurn();
+	void showTurn(Renderer& renderer, TurnSnapshot& shown, const std::string& result) const;
+	void showInventory(Renderer& renderer, TurnSnapshot& shown) const;
 };
 
 #endif // GAME_INCLUDED
@@ -5,6 +5,7 @@
 
 #include <string>
 #include "Dungeon.h"
+#include "Item.h"
 
 ////////////////////////////////////////////////////////////////////
 // Base GameObject Class Declaration
@@ -35,12 +36,20 @@ class GameObject
 	// Name and symbol
 	virtual std::string name() const = 0;
 	virtual char symbol() const = 0;
+
+	// Item record of the object (when picked up)
+	virtual Item item() const = 0;
+
+	// Handle of the object in its Dungeon
+	SlotHandle handle() const {return m_handle;}
 	
 	/////////////////////////////////////////////////////////////////
 	// Setters
 
 	// Position
 	bool setPos(int row, int col);
+	// Set by the Dungeon as the object is put on it
+	void setHandle(SlotHandle handle) {m_handle = handle;}
 
 	/////////////////////////////////////////////////////////////////
 
@@ -54,6 +63,8 @@ class GameObject
 	int m_row;
 	int m_col;
 
+	SlotHandle m_handle;
+
 	/////////////////////////////////////////////////////////////////
 };
 
@@ -0,0 +1,597 @@
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+
+#include "GameState.h"
+#include "Rules.h"
+#include "Combat.h"
+#include "Definitions.h"
+#include "Actor.h"
+#include "Player.h"
+#include "Monster.h"
+#include "FieldOfView.h"
+#include "LevelGenerator.h"
+#include "utilities.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////
+// GameState Implementation
+//
+// Every function mirrors the Game, Dungeon, Actor, Player, Monster
+// or item function named in its comment, drawing random numbers in
+// the same order, and plays by the same rules (Rules.h).
+////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////
+// Zobrist Keys
+//
+// The key of a feature is its value mixed with the salt of its kind
+// of feature, so keys need no tables and every value has its own.
+
+const uint64_t TERRAINSALT = 0x54455252414E4931ULL;
+const uint64_t LEVELSALT   = 0x4C4556454C4B4559ULL;
+const uint64_t WONSALT     = 0x574F4E4B45595321ULL;
+const uint64_t PLAYERSALT  = 0x504C415945524B59ULL;
+const uint64_t MONSTERSALT = 0x4D4F4E535445524BULL;
+const uint64_t OBJECTSALT  = 0x4F424A4543544B59ULL;
+const uint64_t ITEMSALT    = 0x4954454D4B455953ULL;
+
+static uint64_t itemCode(const Item& item)
+{
+	int kind = item.isWeapon() ? item.weapon.kind : item.isScroll() ? item.scroll.kind : 0;
+	return uint64_t(item.type) << 8 | kind;
+}
+
+uint64_t zobristTerrain(const char grid[MAXROWS][MAXCOLS], int rows, int cols)
+{
+	uint64_t key = 0;
+	for(int i = 0; i < rows; i++)
+		for(int j = 0; j < cols; j++)
+			key ^= mixSeed(TERRAINSALT, uint64_t(i * MAXCOLS + j) << 8
+				| (unsigned char)grid[i][j]);
+	return key;
+}
+
+uint64_t zobristPlayer(const ActorState& player, int maxHit)
+{
+	uint64_t place = uint64_t(player.row) << 48 | uint64_t(player.col) << 40
+		| uint64_t(uint16_t(player.hit)) << 24 | uint64_t(maxHit) << 16
+		| player.sleep;
+	uint64_t stats = uint64_t(player.armor) << 24 | uint64_t(player.strength) << 16
+		| uint64_t(player.dexterity) << 8 | player.weapon.kind;
+	return mixSeed(mixSeed(PLAYERSALT, place), stats);
+}
+
+uint64_t zobristMonster(const ActorState& monster)
+{
+	return mixSeed(MONSTERSALT, uint64_t(monster.kind) << 48
+		| uint64_t(monster.row) << 40 | uint64_t(monster.col) << 32
+		| uint64_t(monster.maxHit) << 24 | uint64_t(uint16_t(monster.hit)) << 8
+		| monster.sleep);
+}
+
+uint64_t zobristObject(const ObjectState& object)
+{
+	return mixSeed(OBJECTSALT, uint64_t(object.row) << 40
+		| uint64_t(object.col) << 32 | itemCode(object.item));
+}
+
+uint64_t zobristInventory(const Inventory& inventory)
+	// Items keyed by their slot as well, as the order picks them
+{
+	uint64_t key = 0;
+	for(int i = 0; i < inventory.size(); i++)
+		key ^= mixSeed(ITEMSALT, uint64_t(i) << 32 | itemCode(inventory[i]));
+	return key;
+}
+
+uint64_t zobristLevel(int level)
+{
+	return mixSeed(LEVELSALT, level);
+}
+
+uint64_t zobristWon()
+{
+	return mixSeed(WONSALT, 0);
+}
+
+/////////////////////////////////////////////////////////////////
+// The Level as the Rules Look at It
+
+// Cells a monster or the player can step on (Rules.h)
+struct OpenCell
+{
+	explicit OpenCell(const GameState& state) : state(state) {}
+	bool operator()(int row, int col) const {return state.canOccupy(row, col);}
+	const GameState& state;
+};
+
+// Steps around walls to a goblin, beyond the straight distance: a
+// state knows none
+struct NoBound
+{
+	int operator()(int, int) const {return 0;}
+};
+
+/////////////////////////////////////////////////////////////////
+// Game Functions
+
+void GameState::reset(uint64_t seed, int goblinSmellDistance, bool endlessDepth)
+	// Game::reset
+{
+	rng.setSeed(seed);
+	turns = 0;
+	goblinSmellDist = goblinSmellDistance;
+	hasWon = false;
+	endless = endlessDepth;
+	for(int k = 0; k < NUMWEAPONKINDS; k++)
+		damageDealt[k] = 0;
+	itemsCollected = 0;
+
+	// Player::Player
+	player.hit = BASEHEALTH;
+	player.row = player.col = 0;
+	player.armor = 2;
+	player.strength = 2;
+	player.dexterity = 2;
+	player.sleep = 0;
+	player.kind = 0;
+	player.maxHit = 0;
+	player.weapon = makeWeapon(SHORTSWORD);
+	maxHit = BASEHEALTH;
+	playerKiller = -1;
+	inventory = Inventory();
+	inventory.push(makeItem(player.weapon));
+
+	newLevel(0);
+}
+
+void GameState::step(char command, char choice)
+	// Game::step
+{
+	if(isOver()) return;
+
+	// The player's key is taken out for the turn and put back once
+	// everything changing the player has
+	zobrist ^= zobristPlayer(player, maxHit);
+
+	if(player.sleep > 0)
+	{
+		player.sleep--;
+		command = 's';
+	}
+
+	// Player::attemptRegainHealth
+	if(rng.trueWithProbability(definitions().regenChance) && player.hit < maxHit)
+		player.hit++;
+
+	int newRow = player.row, newCol = player.col;
+	bool direction = true;
+	switch(command)
+	{
+		case ARROW_UP:    newRow--; break;
+		case ARROW_DOWN:  newRow++; break;
+		case ARROW_LEFT:  newCol--; break;
+		case ARROW_RIGHT: newCol++; break;
+		default: direction = false;
+	}
+
+	if(direction)
+	{
+		int m;
+		if(isWall(newRow, newCol))
+			;
+		else if((m = monsterAt(newRow, newCol)) != -1)
+		{
+			int hitBefore = monsters[m].hit;
+			zobrist ^= zobristMonster(monsters[m]);
+			attack(player, monsters[m]);
+			zobrist ^= zobristMonster(monsters[m]);
+			damageDealt[player.weapon.kind] += hitBefore - monsters[m].hit;
+			if(monsters[m].hit <= 0)
+				killMonster(m);
+		}
+		else
+		{
+			player.row = newRow;
+			player.col = newCol;
+		}
+	}
+	else if(tolower(command) == 'g')
+	{
+		int o;
+		if(grid[player.row][player.col] == IDOL)
+		{
+			hasWon = true;
+			zobrist ^= zobristWon();
+		}
+		else if((o = objectAt(player.row, player.col)) != -1
+				&& !inventory.isFull())
+		{
+			// Player::attemptPickUp
+			zobrist ^= zobristObject(objects[o]) ^ zobristInventory(inventory);
+			inventory.push(objects[o].item);
+			zobrist ^= zobristInventory(inventory);
+			itemsCollected++;
+			memmove(&objects[o], &objects[o + 1],
+				(numObjects - o - 1) * sizeof(ObjectState));
+			numObjects--;
+		}
+	}
+	else if(command == 'w' || command == 'r')
+	{
+		// Player::attemptWieldWeapon and Player::attemptReadScroll
+		int sub = itemSubscript(inventory, choice);
+		if(sub != -1)
+		{
+			if(command == 'w' && inventory[sub].isWeapon())
+				player.weapon = inventory[sub].weapon;
+			else if(command == 'r' && inventory[sub].isScroll())
+			{
+				int kind = inventory[sub].scroll.kind;
+				readScroll(kind, player, maxHit, rows, cols, OpenCell(*this), rng);
+				zobrist ^= zobristInventory(inventory);
+				inventory.erase(sub);
+				zobrist ^= zobristInventory(inventory);
+			}
+		}
+	}
+	else if(command == 'c')
+	{
+		// Player::cheat
+		if(maxHit < 50) maxHit = 50;
+		if(player.hit < 50) player.hit = 50;
+		if(player.strength < 9) player.strength = 9;
+	}
+	else if(command == '>' && grid[player.row][player.col] == STAIR)
+	{
+		newLevel(level + 1);
+		zobrist ^= zobristPlayer(player, maxHit); // Out for the turn
+	}
+
+	moveMonsters();
+	turns++;
+	updateSeen();
+	zobrist ^= zobristPlayer(player, maxHit);
+}
+
+void GameState::rehash(bool terrain)
+{
+	if(terrain) terrainKey = zobristTerrain(grid, rows, cols);
+	zobrist = terrainKey ^ zobristLevel(level) ^ zobristInventory(inventory)
+		^ zobristPlayer(player, maxHit);
+	if(hasWon) zobrist ^= zobristWon();
+	for(int m = 0; m < numMonsters; m++)
+		zobrist ^= zobristMonster(monsters[m]);
+	for(int o = 0; o < numObjects; o++)
+		zobrist ^= zobristObject(objects[o]);
+}
+
+GameOutcome GameState::outcome() const
+	// Game::outcome
+{
+	GameOutcome outcome;
+	outcome.won = hasWon;
+	outcome.dead = player.hit <= 0;
+	outcome.depth = level;
+	outcome.turns = turns;
+	outcome.killedBy = playerKiller;
+	for(int k = 0; k < NUMWEAPONKINDS; k++)
+		outcome.damageDealt[k] = damageDealt[k];
+	outcome.itemsCollected = itemsCollected;
+	return outcome;
+}
+
+/////////////////////////////////////////////////////////////////
+// Helper Functions
+
+bool GameState::isWall(int row, int col) const
+	// Dungeon::isWall
+{
+	if(row < 0 || row >= rows || col < 0 || col >= cols)
+		return true;
+	return grid[row][col] == WALL;
+}
+
+int GameState::monsterAt(int row, int col) const
+	// Dungeon::monsterAt
+{
+	if(isWall(row, col)) return -1;
+	for(int m = 0; m < numMonsters; m++)
+		if(monsters[m].row == row && monsters[m].col == col)
+			return m;
+	return -1;
+}
+
+int GameState::objectAt(int row, int col) const
+	// Dungeon::objectAt
+{
+	if(isWall(row, col)) return -1;
+	for(int o = 0; o < numObjects; o++)
+		if(objects[o].row == row && objects[o].col == col)
+			return o;
+	return -1;
+}
+
+bool GameState::canOccupy(int row, int col) const
+	// Dungeon::canPlayerOccupy
+{
+	return !isWall(row, col) && monsterAt(row, col) == -1;
+}
+
+/////////////////////////////////////////////////////////////////
+// Private Helper Functions
+
+void GameState::newLevel(int newLevel)
+	// Dungeon::Dungeon
+{
+	uint64_t seed = uint64_t(rng.next()) << 32;
+	seed |= rng.next();
+	Level plan;
+	levelGenerator(ROOMROW).generate(seed, newLevel, plan, MAXROWS, MAXCOLS, endless);
+
+	level = newLevel;
+	rows = plan.rows;
+	cols = plan.cols;
+	memcpy(grid, plan.grid, sizeof(grid));
+	numMonsters = 0;
+	numObjects = 0;
+
+	// Dungeon::addSpawn and the Monster constructors
+	for(int i = 0; i < plan.numSpawns; i++)
+	{
+		const Spawn& spawn = plan.spawns[i];
+		if(spawn.type != Spawn::MONSTERSPAWN)
+		{
+			ObjectState& object = objects[numObjects++];
+			object.row = spawn.row;
+			object.col = spawn.col;
+			if(spawn.type == Spawn::WEAPONSPAWN)
+				object.item = makeItem(makeWeapon(WeaponKind(spawn.kind)));
+			else
+				object.item = makeItem(makeScroll(ScrollKind(spawn.kind)));
+			continue;
+		}
+
+		ActorState& monster = monsters[numMonsters++];
+		monster.row = spawn.row;
+		monster.col = spawn.col;
+		monster.sleep = 0;
+		monster.kind = spawn.kind;
+		const MonsterDef& def = definitions().monsters[spawn.kind];
+		int hit, strength, dexterity;
+		rollMonsterStats(spawn.kind, rng, hit, strength, dexterity);
+		monster.hit = hit;
+		monster.maxHit = hit;
+		monster.armor = def.armor;
+		monster.strength = strength;
+		monster.dexterity = dexterity;
+		monster.weapon = makeWeapon(WeaponKind(def.weapon));
+	}
+
+	player.row = plan.playerRow;
+	player.col = plan.playerCol;
+
+	memset(seen, 0, sizeof(seen));
+	updateSeen();
+	rehash(); // A new level changes nearly everything
+}
+
+void GameState::attack(const ActorState& attacker, ActorState& defender)
+	// Actor::attemptAttack (a batch of one attack)
+{
+	CombatBatch batch;
+	addAttack(batch, attacker, defender);
+	batch.resolve(rng);
+	if(batch.hit(0))
+		landHit(attacker, defender, batch.damage(0), rng);
+}
+
+void GameState::killMonster(int m)
+	// Dungeon::killMonster and Monster::dropDead
+{
+	const ActorState& monster = monsters[m];
+	int row = monster.row, col = monster.col;
+	zobrist ^= zobristMonster(monster);
+
+	bool cellFree = objectAt(row, col) == -1 && grid[row][col] != IDOL
+		&& grid[row][col] != STAIR && grid[row][col] != UPSTAIR;
+	Item item;
+	if(rollDeathDrop(monster.kind, cellFree, rng, item))
+	{
+		ObjectState& object = objects[numObjects++];
+		object.row = row;
+		object.col = col;
+		object.item = item;
+		zobrist ^= zobristObject(object);
+	}
+
+	memmove(&monsters[m], &monsters[m + 1],
+		(numMonsters - m - 1) * sizeof(ActorState));
+	numMonsters--;
+}
+
+void GameState::moveMonsters()
+	// Dungeon::attemptMoveMonsters
+{
+	CombatBatch batch;
+	int attackers[MAXBATCHATTACKS]; // Index of each attack's monster
+
+	for(int m = 0; m < numMonsters; m++)
+	{
+		ActorState& monster = monsters[m];
+		zobrist ^= zobristMonster(monster);
+		int steps = abs(player.row - monster.row) + abs(player.col - monster.col);
+		int row = monster.row, col = monster.col;
+		switch(planMonster(monster.sleep, steps, monster.kind != DRAGON))
+		{
+			case SLEEPING:
+				monster.sleep--;
+				break;
+			case ATTACKING:
+				attackers[addAttack(batch, monster, player)] = m;
+				break;
+			case MOVING:
+				if(monster.kind == GOBLIN)
+					goblinMove(m);
+				else if(smellStep(row, col, player.row, player.col,
+						(monster.kind == SNAKEWOMAN) ? SNKWSMELLDIST : BGYSMELLDIST,
+						OpenCell(*this)))
+				{
+					monster.row = row;
+					monster.col = col;
+				}
+				break;
+			default:
+				break;
+		}
+		zobrist ^= zobristMonster(monster);
+	}
+
+	// Combat phase (Dungeon::resolveAttacks)
+	batch.resolve(rng);
+	for(int i = 0; i < batch.size(); i++)
+	{
+		const ActorState& monster = monsters[attackers[i]];
+		if(batch.hit(i))
+			landHit(monster, player, batch.damage(i), rng);
+		if(player.hit <= 0 && playerKiller == -1)
+			playerKiller = monster.kind;
+	}
+}
+
+void GameState::goblinMove(int m)
+	// Goblin::move. The goblin's search there is pruned with the
+	// steps around walls its level's room graph gives, which a state
+	// has none of; the straight distance alone prunes it here.
+{
+	ActorState& goblin = monsters[m];
+
+	// Blocking walls and the other monsters
+	int dist[MAXROWS][MAXCOLS];
+	for(int i = 0; i < rows; i++)
+		for(int j = 0; j < cols; j++)
+			dist[i][j] = (grid[i][j] == WALL) ? BLOCKED : UNREACHED;
+	for(int k = 0; k < numMonsters; k++)
+		if(k != m)
+			dist[monsters[k].row][monsters[k].col] = BLOCKED;
+
+	searchFromTarget(dist, rows, cols, player.row, player.col, goblin.row, goblin.col,
+		goblinSmellDist - 1, NoBound());
+	int dir = goblinStep(dist, goblin.row, goblin.col, player.row, player.col,
+		goblinSmellDist, OpenCell(*this));
+	if(dir != -1)
+	{
+		goblin.row += STEPROW[dir];
+		goblin.col += STEPCOL[dir];
+	}
+}
+
+void GameState::updateSeen()
+	// Dungeon::updateFieldOfView
+{
+	bool visible[MAXROWS][MAXCOLS];
+	computeFieldOfView(grid, rows, cols, player.row, player.col, FOVRADIUS, visible);
+	for(int i = 0; i < rows; i++)
+		for(int j = 0; j < cols; j++)
+			seen[i][j] |= visible[i][j];
+}
+
+////////////////////////////////////////////////////////////////////
+// Actor Conversions
+////////////////////////////////////////////////////////////////////
+
+void captureActor(const Actor& actor, ActorState& state)
+{
+	state.hit = actor.hitPts();
+	state.row = actor.row();
+	state.col = actor.col();
+	state.armor = actor.armorPts();
+	state.strength = actor.strengthPts();
+	state.dexterity = actor.dexterityPts();
+	state.sleep = actor.sleepPts();
+	state.kind = 0;
+	state.maxHit = 0;
+	state.weapon = actor.weapon();
+}
+
+void restoreActor(const ActorState& state, Actor& actor)
+{
+	actor.setPos(state.row, state.col);
+	// Hit points of a dead actor can be below what setHitPts takes
+	actor.setHitPts(state.hit > 0 ? state.hit : 0);
+	if(state.hit < 0)
+		actor.takeDamage(-state.hit);
+	actor.setArmorPts(state.armor);
+	actor.setStrengthPts(state.strength);
+	actor.setDexterityPts(state.dexterity);
+	actor.setSleepPts(state.sleep);
+	actor.setWeapon(state.weapon);
+}
+
+void updateActor(const ActorState& before, const ActorState& after, Actor& actor)
+{
+	if(after.row != before.row || after.col != before.col)
+		actor.setPos(after.row, after.col);
+	if(after.hit < before.hit)
+		actor.takeDamage(before.hit - after.hit); // Maybe below 0
+	else if(after.hit > before.hit)
+		actor.setHitPts(after.hit);
+	if(after.armor != before.armor) actor.setArmorPts(after.armor);
+	if(after.strength != before.strength) actor.setStrengthPts(after.strength);
+	if(after.dexterity != before.dexterity) actor.setDexterityPts(after.dexterity);
+	if(after.sleep != before.sleep) actor.setSleepPts(after.sleep);
+	if(after.weapon.kind != before.weapon.kind) actor.setWeapon(after.weapon);
+}
+
+////////////////////////////////////////////////////////////////////
+// Comparison
+////////////////////////////////////////////////////////////////////
+
+static bool sameActor(const ActorState& a, const ActorState& b, bool isMonster)
+{
+	return a.hit == b.hit && a.row == b.row && a.col == b.col
+		&& a.armor == b.armor && a.strength == b.strength
+		&& a.dexterity == b.dexterity && a.sleep == b.sleep
+		&& (!isMonster || (a.kind == b.kind && a.maxHit == b.maxHit))
+		&& a.weapon.kind == b.weapon.kind;
+}
+
+static bool sameItem(const Item& a, const Item& b)
+{
+	if(a.type != b.type) return false;
+	if(a.isWeapon()) return a.weapon.kind == b.weapon.kind;
+	if(a.isScroll()) return a.scroll.kind == b.scroll.kind;
+	return true;
+}
+
+bool operator==(const GameState& a, const GameState& b)
+{
+	if(a.rng.state() != b.rng.state() || a.turns != b.turns
+		|| a.goblinSmellDist != b.goblinSmellDist || a.hasWon != b.hasWon
+		|| a.endless != b.endless
+		|| !sameActor(a.player, b.player, false) || a.maxHit != b.maxHit
+		|| a.inventory.size() != b.inventory.size()
+		|| a.level != b.level || a.rows != b.rows || a.cols != b.cols
+		|| a.playerKiller != b.playerKiller || a.itemsCollected != b.itemsCollected
+		|| memcmp(a.damageDealt, b.damageDealt, sizeof(a.damageDealt)) != 0
+		|| a.numMonsters != b.numMonsters || a.numObjects != b.numObjects)
+		return false;
+
+	for(int i = 0; i < a.inventory.size(); i++)
+		if(!sameItem(a.inventory[i], b.inventory[i]))
+			return false;
+	for(int i = 0; i < a.rows; i++)
+		if(memcmp(a.grid[i], b.grid[i], a.cols) != 0
+			|| memcmp(a.seen[i], b.seen[i], a.cols * sizeof(bool)) != 0)
+			return false;
+	for(int m = 0; m < a.numMonsters; m++)
+		if(!sameActor(a.monsters[m], b.monsters[m], true))
+			return false;
+	for(int o = 0; o < a.numObjects; o++)
+		if(a.objects[o].row != b.objects[o].row || a.objects[o].col != b.objects[o].col
+			|| !sameItem(a.objects[o].item, b.objects[o].item))
+			return false;
+	return true;
+}
@@ -0,0 +1,174 @@
+// GameState.h
+
+#ifndef GAMESTATE_INCLUDED
+#define GAMESTATE_INCLUDED
+
+#include <cstdint>
+#include <type_traits>
+
+#include "Dungeon.h"
+#include "Item.h"
+#include "Inventory.h"
+#include "Rng.h"
+#include "LevelGenerator.h"
+#include "Game.h"
+
+class Actor;
+class CombatBatch;
+
+const int MAXSTATEMONSTERS = MAXSPAWNS; // Monsters never outnumber spawns
+const int MAXSTATEOBJECTS = MAXSPAWNS;  // Nor do objects, drops included
+
+////////////////////////////////////////////////////////////////////
+// Game State
+//
+// The complete state of a game (random number generator included)
+// in one flat block of a few KB with no pointers in it, so that
+// forking a game is a plain copy of the block.
+//
+// A GameState plays by the same rules as Game and Dungeon (the rules
+// both call, Rules.h) and draws the same random numbers in the same
+// order, so a state forked from a Game and the Game itself stay
+// equal turn after turn under the same commands. It builds no result messages, which makes it the
+// fast copy to play lookahead games on.
+//
+// Only the current level is stored, so in an endless game a state
+// can go down but not back up ('<' does nothing, as in a Game that
+// no longer has the level above).
+//
+// A state carries a 64-bit Zobrist hash of the position: terrain,
+// level, the player's place, stats and inventory, and the monsters
+// and objects (each keyed by all it is, in no particular order).
+// The random number generator, turn count, cells seen and tallies
+// are left out, so the same position reached two ways hashes the
+// same, for transposition tables and finding duplicate states. Step
+// keeps the hash up to date as it goes, changing only the keys of
+// what it changes; a state written field by field needs rehash().
+// A Game keeps the same hash up to date as it plays (Game::hash).
+////////////////////////////////////////////////////////////////////
+
+// An actor (the player or a monster)
+struct ActorState
+{
+	short hit; // Hit points (negative once killed by a heavy blow)
+	unsigned char row, col;
+	unsigned char armor, strength, dexterity, sleep;
+	unsigned char kind; // MonsterKind (unused for the player)
+	unsigned char maxHit; // Hit points at spawn (unused for the player)
+	WeaponItem weapon;
+};
+
+// An object lying in the dungeon
+struct ObjectState
+{
+	unsigned char row, col;
+	Item item;
+};
+
+struct GameState
+{
+	/////////////////////////////////////////////////////////////////
+	// Game
+
+	Rng rng;              // Source of all randomness in the game
+	int turns;            // Turns played so far
+	int goblinSmellDist;  // Goblin smell distance
+	bool hasWon;          // Golden idol picked up
+	bool endless;         // Endless game (see Game.h)
+	int damageDealt[NUMWEAPONKINDS]; // By the player, per weapon kind
+	int itemsCollected;   // Weapons and scrolls picked up
+
+	/////////////////////////////////////////////////////////////////
+	// Player
+
+	ActorState player;
+	int maxHit;
+	int playerKiller; // MonsterKind that killed the player, -1 if none
+	Inventory inventory;
+
+	/////////////////////////////////////////////////////////////////
+	// Current Dungeon level
+
+	int level;
+	int rows, cols;
+	char grid[MAXROWS][MAXCOLS]; // Terrain with the stair or idol
+	bool seen[MAXROWS][MAXCOLS]; // Cells ever seen by the player
+
+	int numMonsters;
+	ActorState monsters[MAXSTATEMONSTERS]; // In the order they move
+	int numObjects;
+	ObjectState objects[MAXSTATEOBJECTS];
+
+	/////////////////////////////////////////////////////////////////
+	// Hash
+
+	// Keys of everything hashed (see hash())
+	uint64_t zobrist;
+	uint64_t terrainKey; // Key of the grid, worked out once a level
+
+	/////////////////////////////////////////////////////////////////
+	// Game Functions (same meaning as in Game)
+
+	// Start a new game played from seed
+	void reset(uint64_t seed, int goblinSmellDistance, bool endlessDepth = false);
+	// Play one turn
+	void step(char command, char choice = 0);
+
+	bool isOver() const {return player.hit <= 0 || hasWon;}
+	GameOutcome outcome() const;
+
+	// Zobrist hash of the position, and working it out again from
+	// every field (after writing fields directly), the terrain's key
+	// included unless the grid is known to be unchanged
+	uint64_t hash() const {return zobrist;}
+	void rehash(bool terrain = true);
+
+	/////////////////////////////////////////////////////////////////
+	// Helper Functions
+
+	bool isWall(int row, int col) const;
+	int monsterAt(int row, int col) const; // Index, -1 if none
+	int objectAt(int row, int col) const;  // Index, -1 if none
+	bool canOccupy(int row, int col) const;
+
+  private:
+	/////////////////////////////////////////////////////////////////
+	// Private Helper Functions
+
+	void newLevel(int newLevel);
+	void attack(const ActorState& attacker, ActorState& defender);
+	void killMonster(int m);
+	void moveMonsters();
+	void goblinMove(int m);
+	void updateSeen();
+};
+
+static_assert(std::is_trivially_copyable<GameState>::value,
+	"GameState must be copyable as plain bytes");
+
+// Copy the position, stats and weapon of an Actor to and from
+// an ActorState
+void captureActor(const Actor& actor, ActorState& state);
+void restoreActor(const ActorState& state, Actor& actor);
+// Set on an Actor, through its setters, the fields of after that
+// differ from before (what a rule (Rules.h) changed of its record)
+void updateActor(const ActorState& before, const ActorState& after, Actor& actor);
+
+// Zobrist keys of what a state hashes, which the hash of a state
+// (GameState::hash) and of a Game (Game::hash) are made of: a level's
+// terrain (GameState::terrainKey), the player with their maximum hit
+// points, a monster, an object, an inventory, the level's depth and
+// the golden idol picked up
+uint64_t zobristTerrain(const char grid[MAXROWS][MAXCOLS], int rows, int cols);
+uint64_t zobristPlayer(const ActorState& player, int maxHit);
+uint64_t zobristMonster(const ActorState& monster);
+uint64_t zobristObject(const ObjectState& object);
+uint64_t zobristInventory(const Inventory& inventory);
+uint64_t zobristLevel(int level);
+uint64_t zobristWon();
+
+// True if both states are the same game at the same point
+bool operator==(const GameState& a, const GameState& b);
+inline bool operator!=(const GameState& a, const GameState& b) {return !(a == b);}
+
+#endif // GAMESTATE_INCLUDED
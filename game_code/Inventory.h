@@ -0,0 +1,88 @@
+// Inventory.h
+
+#ifndef INVENTORY_INCLUDED
+#define INVENTORY_INCLUDED
+
+#include <type_traits>
+
+#include "Item.h"
+
+const int MAXINVENTORY = 26; // One slot for every key from 'a' to 'z'
+
+////////////////////////////////////////////////////////////////////
+// Inventory Class Declaration
+//
+// Fixed capacity array of item values stored inline, so copying
+// an inventory is a plain copy of its bytes
+////////////////////////////////////////////////////////////////////
+
+class Inventory
+{
+  public:
+	/////////////////////////////////////////////////////////////////
+	// Constructor
+	Inventory() : m_items(), m_size(0) {}
+
+	/////////////////////////////////////////////////////////////////
+	// Accessors
+	int size() const {return m_size;}
+	bool isFull() const {return m_size == MAXINVENTORY;}
+	const Item& operator[](int sub) const {return m_items[sub];}
+
+	/////////////////////////////////////////////////////////////////
+	// Modifiers
+
+	// Add item at the end, returns false if inventory full
+	bool push(const Item& item);
+	// Remove item at subscript, keeping the order of the others
+	bool erase(int sub);
+	// Put item in at subscript, moving those from there one up
+	bool insert(int sub, const Item& item);
+
+  private:
+	/////////////////////////////////////////////////////////////////
+
+	Item m_items[MAXINVENTORY];
+	int m_size;
+
+	/////////////////////////////////////////////////////////////////
+};
+
+static_assert(std::is_trivially_copyable<Inventory>::value,
+	"Inventory must be copyable as raw bytes");
+
+/////////////////////////////////////////////////////////////////////
+// Inline Implementations
+
+inline
+bool Inventory::push(const Item& item)
+{
+	if(isFull()) return false;
+	m_items[m_size++] = item;
+	return true;
+}
+
+inline
+bool Inventory::erase(int sub)
+{
+	if(sub < 0 || sub >= m_size) return false;
+	// Shift the items after sub one slot down
+	for(int i = sub; i < m_size - 1; i++)
+		m_items[i] = m_items[i+1];
+	m_size--;
+	return true;
+}
+
+inline
+bool Inventory::insert(int sub, const Item& item)
+{
+	if(isFull() || sub < 0 || sub > m_size) return false;
+	// Shift the items from sub one slot up
+	for(int i = m_size; i > sub; i--)
+		m_items[i] = m_items[i-1];
+	m_items[sub] = item;
+	m_size++;
+	return true;
+}
+
+#endif // INVENTORY_INCLUDED
@@ -0,0 +1,135 @@
+// Item.h
+
+#ifndef ITEM_INCLUDED
+#define ITEM_INCLUDED
+
+#include <string>
+
+class Player;
+
+const char WEAPON = ')';
+const char SCROLL = '?';
+
+// Kinds of weapons
+enum WeaponKind
+{
+	SHORTSWORD, LONGSWORD, MACE, MAGICAXE, SLEEPFANGS,
+	NUMWEAPONKINDS
+};
+
+// Kinds of scrolls
+enum ScrollKind
+{
+	TELEPORTSCROLL, ARMORSCROLL, STRENGTHSCROLL, HEALTHSCROLL,
+	DEXTERITYSCROLL,
+	NUMSCROLLKINDS
+};
+
+////////////////////////////////////////////////////////////////////
+// Item Records
+//
+// Items are plain values: a few bytes with no heap allocation and
+// no virtual functions, so they can be copied around freely
+// (inventories, monster weapons, game state snapshots).
+////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////
+// Weapon Record (implemented in Weapon.cpp)
+
+struct WeaponItem
+{
+	unsigned char kind;   // WeaponKind
+	unsigned char dmg;    // Damage amount
+	unsigned char dexBns; // Dexterity bonus
+
+	// Accessors
+	int damageAmt() const    {return dmg;}
+	int dexterityBns() const {return dexBns;}
+
+	// Name and action (special moves are rules, see Rules.h)
+	std::string name() const;
+	std::string action() const;
+};
+
+// Produce the record of a weapon of the given kind
+WeaponItem makeWeapon(WeaponKind kind);
+
+////////////////////////////////////////////////////////////////////
+// Scroll Record (implemented in Scroll.cpp)
+
+struct ScrollItem
+{
+	unsigned char kind;  // ScrollKind
+
+	// Name and effect string
+	std::string name() const;
+	std::string effect() const;
+
+	// Each scroll has a unique effect on its user
+	void haveEffect(Player* user) const;
+};
+
+// Produce the record of a scroll of the given kind
+ScrollItem makeScroll(ScrollKind kind);
+
+////////////////////////////////////////////////////////////////////
+// Tagged Item (either a weapon or a scroll)
+
+struct Item
+{
+	// Item types
+	enum { NOITEM, WEAPONITEM, SCROLLITEM };
+
+	unsigned char type; // Tag deciding which record is active
+	union
+	{
+		WeaponItem weapon;
+		ScrollItem scroll;
+	};
+
+	bool isWeapon() const {return type == WEAPONITEM;}
+	bool isScroll() const {return type == SCROLLITEM;}
+
+	// Name and symbol
+	std::string name() const;
+	char symbol() const;
+};
+
+/////////////////////////////////////////////////////////////////////
+// Inline Implementations
+
+inline
+Item makeItem(const WeaponItem& weapon)
+{
+	Item item;
+	item.type = Item::WEAPONITEM;
+	item.weapon = weapon;
+	return item;
+}
+
+inline
+Item makeItem(const ScrollItem& scroll)
+{
+	Item item;
+	item.type = Item::SCROLLITEM;
+	item.scroll = scroll;
+	return item;
+}
+
+inline
+std::string Item::name() const
+{
+	if(isWeapon()) return weapon.name();
+	if(isScroll()) return scroll.name();
+	return "";
+}
+
+inline
+char Item::symbol() const
+{
+	if(isWeapon()) return WEAPON;
+	if(isScroll()) return SCROLL;
+	return ' ';
+}
+
+#endif // ITEM_INCLUDED
@@ -0,0 +1,509 @@
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "LevelArchive.h"
+#include "LevelGenerator.h"
+#include "Game.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////
+// File Layout
+////////////////////////////////////////////////////////////////////
+
+static const char FILEMAGIC[8] = {'M','R','O','U','G','E','A','1'};
+static const char CHUNKMAGIC[4] = {'C','H','N','K'};
+static const uint32_t ARCHIVEVERSION = 1;
+
+const size_t FILEHEADERSIZE = 16;  // magic, version, unused
+const size_t CHUNKHEADERSIZE = 24; // magic, type, count, columns, size
+const size_t COLUMNENTRYSIZE = 16; // id, width, offset
+
+// Width of an entry of each column (0 for the spawn records,
+// whose count is given by the spawn index column)
+static const uint32_t COLUMNWIDTH[NUMARCHIVECOLUMNS] =
+{
+	8, 4, WALLPLANEBYTES, 4, 2, 4, 0, // Level columns
+	1, 1, 4, 4                        // Outcome columns
+};
+
+// Columns making up each record type
+static const int FIRSTCOLUMN[NUMARCHIVERECORDTYPES] = {LEVELSEEDCOL, OUTCOMEFLAGSCOL};
+static const int ENDCOLUMN[NUMARCHIVERECORDTYPES] = {LEVELSPAWNSCOL + 1, NUMARCHIVECOLUMNS};
+
+/////////////////////////////////////////////////////////////////
+// Little-endian encoding helpers
+
+static void putU32(unsigned char* out, uint32_t value)
+{
+	for(int i = 0; i < 4; i++)
+		out[i] = (value >> (8*i)) & 255;
+}
+
+static void putU64(unsigned char* out, uint64_t value)
+{
+	for(int i = 0; i < 8; i++)
+		out[i] = (value >> (8*i)) & 255;
+}
+
+static uint32_t getU32(const unsigned char* in)
+{
+	uint32_t value = 0;
+	for(int i = 3; i >= 0; i--)
+		value = (value << 8) | in[i];
+	return value;
+}
+
+static uint64_t getU64(const unsigned char* in)
+{
+	uint64_t value = 0;
+	for(int i = 7; i >= 0; i--)
+		value = (value << 8) | in[i];
+	return value;
+}
+
+static void appendU32(vector<unsigned char>& column, uint32_t value)
+{
+	size_t at = column.size();
+	column.resize(at + 4);
+	putU32(&column[at], value);
+}
+
+static size_t align8(size_t n)
+{
+	return (n + 7) & ~size_t(7);
+}
+
+/////////////////////////////////////////////////////////////////
+// Mapping files into memory
+
+static const unsigned char* mapFile(const string& path, size_t& size)
+	// Map the whole file read-only, nullptr if it can't be opened
+	// or is empty
+{
+	size = 0;
+	int fd = open(path.c_str(), O_RDONLY);
+	if(fd < 0) return nullptr;
+
+	struct stat info;
+	if(fstat(fd, &info) != 0 || info.st_size == 0)
+	{
+		close(fd);
+		return nullptr;
+	}
+	void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd); // The mapping stays valid after closing
+	if(data == MAP_FAILED) return nullptr;
+
+	size = info.st_size;
+	return static_cast<const unsigned char*>(data);
+}
+
+////////////////////////////////////////////////////////////////////
+// ArchiveWriter Class Implementation
+////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////
+// Constructor and Destructor
+
+ArchiveWriter::ArchiveWriter(const string& path, int chunkRecords)
+	: m_path(path), m_file(nullptr), m_chunkRecords(chunkRecords), m_failed(false)
+{
+	if(chunkRecords <= 0)
+	{
+		cerr << "Error: Invalid chunk size passed to ArchiveWriter Contructor" << endl;
+		exit(1);
+	}
+	for(int t = 0; t < NUMARCHIVERECORDTYPES; t++)
+		m_count[t] = 0;
+
+	// Checking what is already in the file
+	struct stat info;
+	bool exists = (stat(path.c_str(), &info) == 0 && info.st_size > 0);
+	size_t valid = ArchiveReader::validLength(path);
+	if(exists && valid == 0)
+	{
+		cerr << "Error: " << path << " is not a level archive" << endl;
+		exit(1);
+	}
+	// Dropping a chunk left incomplete by an earlier writer
+	if(exists && valid < size_t(info.st_size)
+		&& truncate(path.c_str(), valid) != 0)
+	{
+		cerr << "Error: Can't repair level archive " << path << endl;
+		exit(1);
+	}
+
+	m_file = fopen(path.c_str(), "ab");
+	if(!m_file)
+	{
+		cerr << "Error: Can't open level archive " << path << endl;
+		exit(1);
+	}
+
+	// Starting a new archive
+	if(!exists)
+	{
+		unsigned char header[FILEHEADERSIZE] = {};
+		memcpy(header, FILEMAGIC, 8);
+		putU32(header + 8, ARCHIVEVERSION);
+		if(fwrite(header, 1, FILEHEADERSIZE, m_file) != FILEHEADERSIZE
+			|| fflush(m_file) != 0)
+		{
+			cerr << "Error: Can't write level archive " << path << endl;
+			exit(1);
+		}
+	}
+}
+
+ArchiveWriter::~ArchiveWriter()
+{
+	bool written = flush();
+	if(fclose(m_file) != 0)
+		written = false;
+	if(!written)
+		cerr << "Error: Can't write level archive " << m_path
+			 << ", records were lost" << endl;
+}
+
+/////////////////////////////////////////////////////////////////
+// Writing Functions
+
+void ArchiveWriter::addLevel(const Level& level)
+{
+	unsigned char entry[8];
+
+	putU64(entry, level.seed);
+	m_columns[LEVELSEEDCOL].insert(m_columns[LEVELSEEDCOL].end(), entry, entry + 8);
+
+	entry[0] = level.style;
+	entry[1] = level.depth;
+	entry[2] = level.rows;
+	entry[3] = level.cols;
+	m_columns[LEVELSHAPECOL].insert(m_columns[LEVELSHAPECOL].end(), entry, entry + 4);
+
+	// Packing walls into bits
+	vector<unsigned char>& walls = m_columns[LEVELWALLSCOL];
+	size_t at = walls.size();
+	walls.resize(at + WALLPLANEBYTES, 0);
+	for(int i = 0; i < MAXROWS; i++)
+		for(int j = 0; j < MAXCOLS; j++)
+			if(i >= level.rows || j >= level.cols || level.grid[i][j] == WALL)
+			{
+				int bit = MAXCOLS*i + j;
+				walls[at + (bit >> 3)] |= 1 << (bit & 7);
+			}
+
+	entry[0] = level.stairRow;
+	entry[1] = level.stairCol;
+	entry[2] = level.grid[level.stairRow][level.stairCol];
+	entry[3] = 0;
+	m_columns[LEVELSTAIRCOL].insert(m_columns[LEVELSTAIRCOL].end(), entry, entry + 4);
+
+	entry[0] = level.playerRow;
+	entry[1] = level.playerCol;
+	m_columns[LEVELPLAYERCOL].insert(m_columns[LEVELPLAYERCOL].end(), entry, entry + 2);
+
+	// Spawn list: index of its first spawn, then the spawns
+	vector<unsigned char>& spawns = m_columns[LEVELSPAWNSCOL];
+	appendU32(m_columns[LEVELSPAWNIDXCOL], spawns.size()/sizeof(Spawn));
+	const unsigned char* first = reinterpret_cast<const unsigned char*>(level.spawns);
+	spawns.insert(spawns.end(), first, first + level.numSpawns*sizeof(Spawn));
+
+	if(++m_count[LEVELRECORDS] == m_chunkRecords)
+		writeChunk(LEVELRECORDS);
+}
+
+void ArchiveWriter::addOutcome(const GameOutcome& outcome)
+{
+	m_columns[OUTCOMEFLAGSCOL].push_back((outcome.won ? 1 : 0) | (outcome.dead ? 2 : 0));
+	m_columns[OUTCOMEKILLERCOL].push_back(outcome.killedBy < 0 ? 255 : outcome.killedBy);
+	appendU32(m_columns[OUTCOMEDEPTHCOL], outcome.depth);
+	appendU32(m_columns[OUTCOMETURNSCOL], outcome.turns);
+
+	if(++m_count[OUTCOMERECORDS] == m_chunkRecords)
+		writeChunk(OUTCOMERECORDS);
+}
+
+bool ArchiveWriter::flush()
+{
+	for(int t = 0; t < NUMARCHIVERECORDTYPES; t++)
+		if(m_count[t] > 0)
+			writeChunk(ArchiveRecordType(t));
+	if(fflush(m_file) != 0)
+		m_failed = true;
+	return !m_failed;
+}
+
+/////////////////////////////////////////////////////////////////
+// Private Helper Functions
+
+void ArchiveWriter::writeChunk(ArchiveRecordType type)
+	// Write buffered records of type as one chunk and clear them
+{
+	// Closing the last spawn list
+	if(type == LEVELRECORDS)
+		appendU32(m_columns[LEVELSPAWNIDXCOL],
+			m_columns[LEVELSPAWNSCOL].size()/sizeof(Spawn));
+
+	int first = FIRSTCOLUMN[type];
+	int end = ENDCOLUMN[type];
+	int numColumns = end - first;
+
+	// Laying out the columns after the headers
+	vector<unsigned char> header(CHUNKHEADERSIZE + numColumns*COLUMNENTRYSIZE, 0);
+	size_t offset = align8(header.size());
+	for(int c = first; c < end; c++)
+	{
+		unsigned char* entry = &header[CHUNKHEADERSIZE + (c - first)*COLUMNENTRYSIZE];
+		putU32(entry, c);
+		putU32(entry + 4, COLUMNWIDTH[c]);
+		putU64(entry + 8, offset);
+		offset = align8(offset + m_columns[c].size());
+	}
+	memcpy(&header[0], CHUNKMAGIC, 4);
+	putU32(&header[4], type);
+	putU32(&header[8], m_count[type]);
+	putU32(&header[12], numColumns);
+	putU64(&header[16], offset); // Size of the whole chunk
+
+	// Writing headers and columns with padding between them
+	const unsigned char padding[8] = {};
+	write(&header[0], header.size());
+	write(padding, align8(header.size()) - header.size());
+	for(int c = first; c < end; c++)
+	{
+		if(!m_columns[c].empty())
+			write(&m_columns[c][0], m_columns[c].size());
+		write(padding, align8(m_columns[c].size()) - m_columns[c].size());
+		m_columns[c].clear();
+	}
+	m_count[type] = 0;
+}
+
+void ArchiveWriter::write(const void* data, size_t size)
+	// Write size bytes, noting a failure (the chunk is then left
+	// incomplete, and dropped when the archive is next opened)
+{
+	if(size > 0 && fwrite(data, 1, size, m_file) != size)
+		m_failed = true;
+}
+
+////////////////////////////////////////////////////////////////////
+// LevelView Class Implementation
+////////////////////////////////////////////////////////////////////
+
+uint64_t LevelView::seed() const
+{
+	return getU64(m_seed);
+}
+
+bool LevelView::isWall(int row, int col) const
+	// return's true if position is a wall or outside grid
+{
+	if(row < 0 || row >= rows() || col < 0 || col >= cols())
+		return true;
+	int bit = MAXCOLS*row + col;
+	return (m_walls[bit >> 3] >> (bit & 7)) & 1;
+}
+
+void LevelView::toLevel(Level& level) const
+{
+	level.seed = seed();
+	level.style = style();
+	level.depth = depth();
+	level.rows = rows();
+	level.cols = cols();
+
+	for(int i = 0; i < MAXROWS; i++)
+		for(int j = 0; j < MAXCOLS; j++)
+			level.grid[i][j] = isWall(i, j) ? WALL : ' ';
+
+	level.stairRow = stairRow();
+	level.stairCol = stairCol();
+	level.grid[stairRow()][stairCol()] = stairSymbol();
+	level.playerRow = playerRow();
+	level.playerCol = playerCol();
+
+	level.numSpawns = min(numSpawns(), MAXSPAWNS);
+	for(int i = 0; i < level.numSpawns; i++)
+		level.spawns[i] = spawn(i);
+}
+
+////////////////////////////////////////////////////////////////////
+// ArchiveReader Class Implementation
+////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////
+// Constructor and Destructor
+
+ArchiveReader::ArchiveReader(const string& path)
+{
+	m_data = mapFile(path, m_size);
+	if(!m_data)
+	{
+		cerr << "Error: Can't open level archive " << path << endl;
+		exit(1);
+	}
+	for(int t = 0; t < NUMARCHIVERECORDTYPES; t++)
+		m_total[t] = 0;
+	if(scanChunks(m_data, m_size, m_chunks, m_total) == 0)
+	{
+		cerr << "Error: " << path << " is not a level archive" << endl;
+		exit(1);
+	}
+}
+
+ArchiveReader::~ArchiveReader()
+{
+	munmap(const_cast<unsigned char*>(m_data), m_size);
+}
+
+/////////////////////////////////////////////////////////////////
+// Accessors
+
+LevelView ArchiveReader::level(size_t i) const
+{
+	const Chunk& chunk = findChunk(LEVELRECORDS, i);
+	size_t r = i - chunk.first; // Record within chunk
+
+	LevelView view;
+	view.m_seed   = chunk.columns[LEVELSEEDCOL] + 8*r;
+	view.m_shape  = chunk.columns[LEVELSHAPECOL] + 4*r;
+	view.m_walls  = chunk.columns[LEVELWALLSCOL] + WALLPLANEBYTES*r;
+	view.m_stair  = chunk.columns[LEVELSTAIRCOL] + 4*r;
+	view.m_player = chunk.columns[LEVELPLAYERCOL] + 2*r;
+
+	uint32_t first = getU32(chunk.columns[LEVELSPAWNIDXCOL] + 4*r);
+	uint32_t end = getU32(chunk.columns[LEVELSPAWNIDXCOL] + 4*(r + 1));
+	view.m_spawns = reinterpret_cast<const Spawn*>(chunk.columns[LEVELSPAWNSCOL]) + first;
+	view.m_numSpawns = end - first;
+	return view;
+}
+
+GameOutcome ArchiveReader::outcome(size_t i) const
+{
+	const Chunk& chunk = findChunk(OUTCOMERECORDS, i);
+	size_t r = i - chunk.first; // Record within chunk
+
+	GameOutcome outcome;
+	unsigned char flags = chunk.columns[OUTCOMEFLAGSCOL][r];
+	unsigned char killer = chunk.columns[OUTCOMEKILLERCOL][r];
+	outcome.won = flags & 1;
+	outcome.dead = flags & 2;
+	outcome.killedBy = (killer == 255) ? -1 : killer;
+	outcome.depth = int32_t(getU32(chunk.columns[OUTCOMEDEPTHCOL] + 4*r));
+	outcome.turns = int32_t(getU32(chunk.columns[OUTCOMETURNSCOL] + 4*r));
+	for(int k = 0; k < NUMWEAPONKINDS; k++)
+		outcome.damageDealt[k] = 0; // Not archived
+	outcome.itemsCollected = 0;
+	return outcome;
+}
+
+size_t ArchiveReader::validLength(const string& path)
+{
+	size_t size;
+	const unsigned char* data = mapFile(path, size);
+	if(!data) return 0;
+	size_t valid = scanChunks(data, size, nullptr, nullptr);
+	munmap(const_cast<unsigned char*>(data), size);
+	return valid;
+}
+
+/////////////////////////////////////////////////////////////////
+// Private Helper Functions
+
+const ArchiveReader::Chunk& ArchiveReader::findChunk(ArchiveRecordType type, size_t i) const
+	// Binary search for the chunk holding record i of type
+{
+	const vector<Chunk>& chunks = m_chunks[type];
+	size_t low = 0, high = chunks.size() - 1;
+	while(low < high)
+	{
+		size_t mid = (low + high + 1)/2;
+		if(chunks[mid].first <= i) low = mid;
+		else high = mid - 1;
+	}
+	return chunks[low];
+}
+
+size_t ArchiveReader::scanChunks(const unsigned char* data, size_t size,
+	vector<Chunk>* chunks, size_t* totals)
+	// Walk the chunk headers, checking that every chunk is complete.
+	// Fills chunks and totals (if given) and returns the length of
+	// the valid part of the file (0 if it is not an archive).
+{
+	if(size < FILEHEADERSIZE || memcmp(data, FILEMAGIC, 8) != 0
+		|| getU32(data + 8) != ARCHIVEVERSION)
+		return 0;
+
+	size_t pos = FILEHEADERSIZE;
+	while(pos + CHUNKHEADERSIZE <= size)
+	{
+		const unsigned char* header = data + pos;
+		uint32_t type = getU32(header + 4);
+		uint32_t count = getU32(header + 8);
+		uint32_t numColumns = getU32(header + 12);
+		uint64_t chunkSize = getU64(header + 16);
+
+		if(memcmp(header, CHUNKMAGIC, 4) != 0 || type >= NUMARCHIVERECORDTYPES
+			|| numColumns > NUMARCHIVECOLUMNS
+			|| chunkSize < CHUNKHEADERSIZE + numColumns*COLUMNENTRYSIZE
+			|| chunkSize > size - pos)
+			break; // Incomplete or damaged chunk
+
+		// Locating the columns
+		Chunk chunk;
+		chunk.count = count;
+		for(int c = 0; c < NUMARCHIVECOLUMNS; c++)
+			chunk.columns[c] = nullptr;
+		bool valid = true;
+		for(uint32_t c = 0; c < numColumns; c++)
+		{
+			const unsigned char* entry = header + CHUNKHEADERSIZE + c*COLUMNENTRYSIZE;
+			uint32_t id = getU32(entry);
+			uint64_t offset = getU64(entry + 8);
+			if(id >= NUMARCHIVECOLUMNS || offset + uint64_t(COLUMNWIDTH[id])*count > chunkSize)
+			{
+				valid = false;
+				break;
+			}
+			chunk.columns[id] = header + offset;
+		}
+		// Every column of the record type is needed
+		for(int c = FIRSTCOLUMN[type]; valid && c < ENDCOLUMN[type]; c++)
+			valid = (chunk.columns[c] != nullptr);
+		// The spawn lists must end inside the chunk
+		if(valid && type == LEVELRECORDS)
+		{
+			if(chunk.columns[LEVELSPAWNIDXCOL] + 4*(count + 1) > header + chunkSize)
+				valid = false;
+			else
+			{
+				uint32_t numSpawns = getU32(chunk.columns[LEVELSPAWNIDXCOL] + 4*count);
+				valid = (chunk.columns[LEVELSPAWNSCOL] + numSpawns*sizeof(Spawn)
+							<= header + chunkSize);
+			}
+		}
+		if(!valid) break;
+
+		if(chunks)
+		{
+			chunk.first = totals[type];
+			totals[type] += count;
+			if(count > 0)
+				chunks[type].push_back(chunk);
+		}
+		pos += chunkSize;
+	}
+	return pos;
+}
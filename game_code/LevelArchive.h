@@ -0,0 +1,217 @@
+// LevelArchive.h
+
+#ifndef LEVELARCHIVE_INCLUDED
+#define LEVELARCHIVE_INCLUDED
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "LevelGenerator.h"
+#include "Game.h"
+
+////////////////////////////////////////////////////////////////////
+// Level Archive
+//
+// Append-only binary file of generated levels and game outcomes.
+//
+// The file is a 16 byte header followed by chunks. A chunk holds
+// up to ARCHIVECHUNKRECORDS records of one type stored column by
+// column: every column is a packed array with one fixed width entry
+// per record (except the spawn list, which is indexed by an offsets
+// column), so a record is found with pointer arithmetic alone. The
+// reader maps the file into memory and reads records in place.
+//
+// All numbers are stored little-endian, every column starts on an
+// 8 byte boundary. A chunk cut short by a crash is dropped when the
+// file is next opened for writing.
+////////////////////////////////////////////////////////////////////
+
+const int ARCHIVECHUNKRECORDS = 4096; // Records written per chunk
+
+// Walls of a level as bits, row by row (bit MAXCOLS*r + c)
+const int WALLPLANEBYTES = (MAXROWS*MAXCOLS + 7)/8;
+
+// Types of records (one type per chunk)
+enum ArchiveRecordType
+{
+	LEVELRECORDS, OUTCOMERECORDS,
+	NUMARCHIVERECORDTYPES
+};
+
+// Columns of the chunks and the width of their entries in bytes
+enum ArchiveColumn
+{
+	// Level records
+	LEVELSEEDCOL,      // 8: uint64 seed
+	LEVELSHAPECOL,     // 4: style, depth, rows, cols
+	LEVELWALLSCOL,     // WALLPLANEBYTES: wall bit-plane
+	LEVELSTAIRCOL,     // 4: stair row, col, STAIR or IDOL, unused
+	LEVELPLAYERCOL,    // 2: player start row, col
+	LEVELSPAWNIDXCOL,  // 4: uint32 index of first spawn in chunk
+	                   //    (one extra entry ends the last list)
+	LEVELSPAWNSCOL,    // 4 per spawn: Spawn records
+
+	// Outcome records
+	OUTCOMEFLAGSCOL,   // 1: bit 0 won, bit 1 dead
+	OUTCOMEKILLERCOL,  // 1: MonsterKind that killed the player or 255
+	OUTCOMEDEPTHCOL,   // 4: int32 level reached
+	OUTCOMETURNSCOL,   // 4: int32 turns played
+
+	NUMARCHIVECOLUMNS
+};
+
+////////////////////////////////////////////////////////////////////
+// ArchiveWriter Class Declaration
+////////////////////////////////////////////////////////////////////
+
+class ArchiveWriter
+{
+  public:
+	/////////////////////////////////////////////////////////////////
+	// Constructor and Destructor
+
+	// Opens path for appending (creating it if needed)
+	ArchiveWriter(const std::string& path,
+		int chunkRecords = ARCHIVECHUNKRECORDS);
+	~ArchiveWriter(); // Writes any buffered records, reporting a failure
+
+	/////////////////////////////////////////////////////////////////
+	// Writing Functions
+
+	void addLevel(const Level& level);
+	void addOutcome(const GameOutcome& outcome);
+
+	// Write buffered records as (possibly short) chunks. Returns
+	// false if any write since the archive was opened failed.
+	bool flush();
+
+  private:
+	/////////////////////////////////////////////////////////////////
+
+	std::string m_path;
+	std::FILE* m_file;
+	int m_chunkRecords;
+	bool m_failed; // A write failed
+
+	// Buffered columns and record counts of each record type
+	std::vector<unsigned char> m_columns[NUMARCHIVECOLUMNS];
+	int m_count[NUMARCHIVERECORDTYPES];
+
+	// Private Helper Functions
+	void writeChunk(ArchiveRecordType type);
+	void write(const void* data, size_t size);
+
+	// Writers own a file, so they are not copied
+	ArchiveWriter(const ArchiveWriter&);
+	ArchiveWriter& operator=(const ArchiveWriter&);
+
+	/////////////////////////////////////////////////////////////////
+};
+
+////////////////////////////////////////////////////////////////////
+// LevelView Class Declaration
+//
+// A level record read in place from an archive
+////////////////////////////////////////////////////////////////////
+
+class LevelView
+{
+  public:
+	/////////////////////////////////////////////////////////////////
+	// Accessors
+
+	uint64_t seed() const;
+	LevelStyle style() const {return LevelStyle(m_shape[0]);}
+	int depth() const {return m_shape[1];}
+	int rows() const  {return m_shape[2];}
+	int cols() const  {return m_shape[3];}
+
+	bool isWall(int row, int col) const;
+	const unsigned char* wallPlane() const {return m_walls;}
+
+	int stairRow() const {return m_stair[0];}
+	int stairCol() const {return m_stair[1];}
+	char stairSymbol() const {return m_stair[2];}
+
+	int playerRow() const {return m_player[0];}
+	int playerCol() const {return m_player[1];}
+
+	int numSpawns() const {return m_numSpawns;}
+	const Spawn& spawn(int i) const {return m_spawns[i];}
+
+	// Decode into a full Level
+	void toLevel(Level& level) const;
+
+  private:
+	friend class ArchiveReader;
+
+	const unsigned char* m_seed;
+	const unsigned char* m_shape;
+	const unsigned char* m_walls;
+	const unsigned char* m_stair;
+	const unsigned char* m_player;
+	const Spawn* m_spawns;
+	int m_numSpawns;
+};
+
+////////////////////////////////////////////////////////////////////
+// ArchiveReader Class Declaration
+////////////////////////////////////////////////////////////////////
+
+class ArchiveReader
+{
+  public:
+	/////////////////////////////////////////////////////////////////
+	// Constructor and Destructor
+
+	// Maps the archive at path into memory
+	ArchiveReader(const std::string& path);
+	~ArchiveReader();
+
+	/////////////////////////////////////////////////////////////////
+	// Accessors
+
+	size_t numLevels() const   {return m_total[LEVELRECORDS];}
+	size_t numOutcomes() const {return m_total[OUTCOMERECORDS];}
+
+	// Random access to records (0 <= i < numLevels()/numOutcomes())
+	LevelView level(size_t i) const;
+	GameOutcome outcome(size_t i) const;
+
+	// Length of the leading part of the file holding complete chunks,
+	// 0 if path is not an archive
+	static size_t validLength(const std::string& path);
+
+  private:
+	/////////////////////////////////////////////////////////////////
+
+	// Chunk of records and where its columns are
+	struct Chunk
+	{
+		size_t first;  // Index of first record in chunk
+		size_t count;  // Records in chunk
+		const unsigned char* columns[NUMARCHIVECOLUMNS];
+	};
+
+	const unsigned char* m_data; // Mapped file
+	size_t m_size;
+
+	std::vector<Chunk> m_chunks[NUMARCHIVERECORDTYPES];
+	size_t m_total[NUMARCHIVERECORDTYPES];
+
+	// Private Helper Functions
+	const Chunk& findChunk(ArchiveRecordType type, size_t i) const;
+	static size_t scanChunks(const unsigned char* data, size_t size,
+		std::vector<Chunk>* chunks, size_t* totals);
+
+	// Readers own a mapping, so they are not copied
+	ArchiveReader(const ArchiveReader&);
+	ArchiveReader& operator=(const ArchiveReader&);
+
+	/////////////////////////////////////////////////////////////////
+};
+
+#endif // LEVELARCHIVE_INCLUDED
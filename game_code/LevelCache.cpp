@@ -0,0 +1,313 @@
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+#include "LevelCache.h"
+#include "Dungeon.h"
+#include "Player.h"
+#include "GameState.h"
+#include "DormantLevel.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////
+// Packed Levels
+////////////////////////////////////////////////////////////////////
+
+static const char PACKMAGIC[4] = {'M', 'R', 'L', '1'};
+
+// magic, depth, rows, cols, a spare byte (once the killer, now kept
+// by the player), cells listed, smell distance, monsters, objects,
+// player row and col
+const size_t PACKHEADERSIZE = 20;
+
+static void setBit(unsigned char* plane, int bit)
+{
+	plane[bit >> 3] |= 1 << (bit & 7);
+}
+
+static bool getBit(const unsigned char* plane, int bit)
+{
+	return (plane[bit >> 3] >> (bit & 7)) & 1;
+}
+
+void packLevel(const GameState& state, vector<unsigned char>& bytes)
+{
+	int cells = state.rows * state.cols;
+	int planeBytes = (cells + 7) / 8;
+
+	// Cells other than walls and open floor (stairs and idol)
+	vector<unsigned char> listed;
+	for(int i = 0; i < state.rows; i++)
+		for(int j = 0; j < state.cols; j++)
+			if(state.grid[i][j] != WALL && state.grid[i][j] != ' ')
+			{
+				listed.push_back(i);
+				listed.push_back(j);
+				listed.push_back(state.grid[i][j]);
+			}
+
+	bytes.assign(PACKHEADERSIZE, 0);
+	memcpy(&bytes[0], PACKMAGIC, sizeof(PACKMAGIC));
+	for(int i = 0; i < 4; i++)
+		bytes[4 + i] = (uint32_t(state.level) >> (8*i)) & 255;
+	bytes[8] = state.rows;
+	bytes[9] = state.cols;
+	bytes[11] = listed.size() / 3;
+	bytes[12] = state.goblinSmellDist & 255;
+	bytes[13] = (state.goblinSmellDist >> 8) & 255;
+	bytes[14] = state.numMonsters;
+	bytes[15] = state.numObjects;
+	bytes[16] = state.player.row;
+	bytes[17] = state.player.col;
+	bytes.insert(bytes.end(), listed.begin(), listed.end());
+
+	// Walls and seen cells as bits, row by row
+	size_t walls = bytes.size();
+	bytes.resize(walls + 2 * planeBytes, 0);
+	size_t seen = walls + planeBytes;
+	for(int i = 0; i < state.rows; i++)
+		for(int j = 0; j < state.cols; j++)
+		{
+			int bit = state.cols*i + j;
+			if(state.grid[i][j] == WALL) setBit(&bytes[walls], bit);
+			if(state.seen[i][j]) setBit(&bytes[seen], bit);
+		}
+
+	// Monsters and objects as they are stored
+	const unsigned char* monsters = reinterpret_cast<const unsigned char*>(state.monsters);
+	bytes.insert(bytes.end(), monsters, monsters + state.numMonsters * sizeof(ActorState));
+	const unsigned char* objects = reinterpret_cast<const unsigned char*>(state.objects);
+	bytes.insert(bytes.end(), objects, objects + state.numObjects * sizeof(ObjectState));
+}
+
+bool unpackLevel(const unsigned char* bytes, size_t size, GameState& state)
+{
+	if(size < PACKHEADERSIZE || memcmp(bytes, PACKMAGIC, sizeof(PACKMAGIC)) != 0)
+		return false;
+	int rows = bytes[8], cols = bytes[9];
+	int numListed = bytes[11];
+	int numMonsters = bytes[14], numObjects = bytes[15];
+	int planeBytes = (rows * cols + 7) / 8;
+	if(rows > MAXROWS || cols > MAXCOLS || numMonsters > MAXSTATEMONSTERS
+		|| numObjects > MAXSTATEOBJECTS
+		|| size != PACKHEADERSIZE + 3*numListed + 2*planeBytes
+			+ numMonsters*sizeof(ActorState) + numObjects*sizeof(ObjectState))
+		return false;
+
+	uint32_t depth = 0;
+	for(int i = 0; i < 4; i++)
+		depth |= uint32_t(bytes[4 + i]) << (8*i);
+	state.level = int(depth);
+	state.rows = rows;
+	state.cols = cols;
+	state.goblinSmellDist = bytes[12] | bytes[13] << 8;
+	state.player.row = bytes[16];
+	state.player.col = bytes[17];
+
+	// Terrain from the wall plane, then the listed cells on top
+	const unsigned char* listed = bytes + PACKHEADERSIZE;
+	const unsigned char* walls = listed + 3*numListed;
+	const unsigned char* seen = walls + planeBytes;
+	memset(state.grid, WALL, sizeof(state.grid));
+	memset(state.seen, 0, sizeof(state.seen));
+	for(int i = 0; i < rows; i++)
+		for(int j = 0; j < cols; j++)
+		{
+			int bit = cols*i + j;
+			state.grid[i][j] = getBit(walls, bit) ? WALL : ' ';
+			state.seen[i][j] = getBit(seen, bit);
+		}
+	for(int c = 0; c < numListed; c++)
+	{
+		int row = listed[3*c], col = listed[3*c + 1];
+		if(row >= rows || col >= cols) return false;
+		state.grid[row][col] = listed[3*c + 2];
+	}
+
+	const unsigned char* records = seen + planeBytes;
+	state.numMonsters = numMonsters;
+	memcpy(state.monsters, records, numMonsters * sizeof(ActorState));
+	records += numMonsters * sizeof(ActorState);
+	state.numObjects = numObjects;
+	memcpy(state.objects, records, numObjects * sizeof(ObjectState));
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////
+// LevelCache Class Implementation
+////////////////////////////////////////////////////////////////////
+
+LevelCache::LevelCache(const string& path, int hotLevels, int warmLevels)
+	: m_path(path), m_hotLevels(hotLevels < 0 ? 0 : hotLevels),
+	  m_warmLevels(warmLevels < 0 ? 0 : warmLevels), m_warmBytes(0), m_fileBytes(0),
+	  m_dormantTurns(0)
+{
+	m_file = fopen(path.c_str(), "w+b");
+	if(!m_file)
+	{
+		cerr << "Error: Can't create level cache file " << path << endl;
+		exit(1);
+	}
+	for(int t = 0; t < NUMTIERS; t++)
+		m_hits[t] = 0;
+}
+
+LevelCache::~LevelCache()
+{
+	clear();
+	fclose(m_file);
+	remove(m_path.c_str());
+}
+
+void LevelCache::put(Dungeon* dungeon, int turn)
+{
+	int depth = dungeon->level();
+	if(m_entries.count(depth))
+	{
+		cerr << "Error: Level " << depth << " is already in the level cache" << endl;
+		exit(1);
+	}
+
+	Entry& entry = m_entries[depth];
+	entry.tier = HOT;
+	entry.live = dungeon;
+	entry.playerRow = dungeon->player()->row();
+	entry.playerCol = dungeon->player()->col();
+	entry.leftTurn = turn;
+	entry.size = 0;
+	m_hot.push_front(depth);
+	entry.recent = m_hot.begin();
+
+	while(int(m_hot.size()) > m_hotLevels)
+		coolHot();
+}
+
+Dungeon* LevelCache::take(int depth, Player* player, Rng& rng, int turn)
+{
+	map<int, Entry>::iterator found = m_entries.find(depth);
+	if(found == m_entries.end())
+		return nullptr;
+	Entry& entry = found->second;
+	m_hits[entry.tier]++;
+	int away = turn - entry.leftTurn;
+	if(away > 0) m_dormantTurns += away;
+
+	Dungeon* dungeon = nullptr;
+	if(entry.tier == HOT)
+	{
+		dungeon = entry.live;
+		dungeon->enter(player, entry.playerRow, entry.playerCol);
+		dungeon->simulateDormant(away);
+		m_hot.erase(entry.recent);
+	}
+	else
+	{
+		GameState state;
+		bool ok;
+		if(entry.tier == WARM)
+		{
+			ok = unpackLevel(&entry.packed[0], entry.packed.size(), state);
+			m_warmBytes -= entry.packed.size();
+			m_warm.erase(entry.recent);
+		}
+		else
+		{
+			vector<unsigned char> bytes(entry.size);
+			ok = fseek(m_file, m_slots[depth].offset, SEEK_SET) == 0
+				&& fread(&bytes[0], entry.size, 1, m_file) == 1
+				&& unpackLevel(&bytes[0], bytes.size(), state);
+		}
+		if(!ok)
+		{
+			cerr << "Error: Level " << depth << " in the level cache is damaged" << endl;
+			exit(1);
+		}
+		simulateDormant(state, away, entry.playerRow, entry.playerCol, rng);
+		dungeon = new Dungeon(state, player, rng);
+	}
+
+	m_entries.erase(found);
+	return dungeon;
+}
+
+void LevelCache::clear()
+{
+	for(map<int, Entry>::iterator e = m_entries.begin(); e != m_entries.end(); e++)
+		if(e->second.tier == HOT)
+			delete e->second.live;
+	m_entries.clear();
+	m_slots.clear();
+	m_hot.clear();
+	m_warm.clear();
+	m_warmBytes = 0;
+
+	// Starting the file over
+	fclose(m_file);
+	m_file = fopen(m_path.c_str(), "w+b");
+	if(!m_file)
+	{
+		cerr << "Error: Can't create level cache file " << m_path << endl;
+		exit(1);
+	}
+	m_fileBytes = 0;
+}
+
+/////////////////////////////////////////////////////////////////
+// Private Helper Functions
+
+void LevelCache::coolHot()
+{
+	int depth = m_hot.back();
+	m_hot.pop_back();
+	Entry& entry = m_entries[depth];
+
+	// Packing the level as a game state stores it, with the
+	// player where they left it
+	GameState state;
+	entry.live->capture(state);
+	state.goblinSmellDist = entry.live->goblinSmellDist();
+	state.player.row = entry.playerRow;
+	state.player.col = entry.playerCol;
+	delete entry.live;
+	entry.live = nullptr;
+	packLevel(state, entry.packed);
+
+	entry.tier = WARM;
+	m_warmBytes += entry.packed.size();
+	m_warm.push_front(depth);
+	entry.recent = m_warm.begin();
+
+	while(int(m_warm.size()) > m_warmLevels)
+		coolWarm();
+}
+
+void LevelCache::coolWarm()
+{
+	int depth = m_warm.back();
+	m_warm.pop_back();
+	Entry& entry = m_entries[depth];
+
+	// Writing over the level's old place in the file if it fits,
+	// at the end otherwise
+	size_t size = entry.packed.size();
+	bool written = m_slots.count(depth) != 0;
+	FileSlot& slot = m_slots[depth];
+	if(!written || size > slot.capacity)
+	{
+		slot.offset = long(m_fileBytes);
+		slot.capacity = size;
+		m_fileBytes += size;
+	}
+	if(fseek(m_file, slot.offset, SEEK_SET) != 0
+		|| fwrite(&entry.packed[0], size, 1, m_file) != 1)
+	{
+		cerr << "Error: Can't write level cache file " << m_path << endl;
+		exit(1);
+	}
+	entry.size = size;
+
+	m_warmBytes -= size;
+	vector<unsigned char>().swap(entry.packed);
+	entry.tier = COLD;
+}
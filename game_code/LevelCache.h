@@ -0,0 +1,137 @@
+// LevelCache.h
+
+#ifndef LEVELCACHE_INCLUDED
+#define LEVELCACHE_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Rng.h"
+
+class Dungeon;
+class Player;
+struct GameState;
+
+const int HOTLEVELS = 4;   // Levels kept live by default
+const int WARMLEVELS = 64; // Levels kept packed in memory by default
+
+////////////////////////////////////////////////////////////////////
+// Level Cache
+//
+// The levels of an endless game the player is not on, so they can
+// go back to them. Their monsters carry on living meanwhile: the
+// turns the player was away are applied when a level is taken back
+// (see DormantLevel.h). The most recently left levels are kept as they
+// are (hot), older ones packed into a few hundred bytes each (warm)
+// and the oldest written to a scratch file (cold), so however deep
+// a game goes only a bounded number of levels are held in memory
+// (besides a few dozen bytes per level saying where it is).
+//
+// A packed level is its terrain as bit-planes (walls and cells seen)
+// with the few other cells (stairs, idol) listed, followed by the
+// records of its monsters and objects as a GameState stores them.
+// The scratch file belongs to the cache: it is only read by the
+// process that wrote it and is removed with the cache.
+////////////////////////////////////////////////////////////////////
+
+class LevelCache
+{
+  public:
+	/////////////////////////////////////////////////////////////////
+	// Constructor and Destructor
+
+	// Spills the coldest levels to the file at path
+	LevelCache(const std::string& path, int hotLevels = HOTLEVELS,
+		int warmLevels = WARMLEVELS);
+	~LevelCache(); // Deletes the levels kept and removes the file
+
+	/////////////////////////////////////////////////////////////////
+	// Cache Functions
+
+	// Keep dungeon, the level the player is leaving on game turn
+	// turn (the cache owns it from now on), as the most recently used
+	// one
+	void put(Dungeon* dungeon, int turn);
+	// Take the level numbered depth back out of the cache on game
+	// turn turn, caught up with the turns since it was left, with the
+	// player where they left it, rng as its random numbers and the
+	// player's field of view updated; nullptr if it isn't kept
+	Dungeon* take(int depth, Player* player, Rng& rng, int turn);
+	bool contains(int depth) const {return m_entries.count(depth) != 0;}
+	// Forget every level
+	void clear();
+
+	/////////////////////////////////////////////////////////////////
+	// Accessors
+
+	int numHot() const  {return int(m_hot.size());}
+	int numWarm() const {return int(m_warm.size());}
+	int numCold() const {return int(m_entries.size() - m_hot.size() - m_warm.size());}
+	size_t warmBytes() const {return m_warmBytes;} // Packed levels in memory
+	size_t fileBytes() const {return m_fileBytes;} // Scratch file length
+
+	// Levels taken back from each tier so far
+	uint64_t hotHits() const  {return m_hits[HOT];}
+	uint64_t warmHits() const {return m_hits[WARM];}
+	uint64_t coldHits() const {return m_hits[COLD];}
+	// Turns levels taken back had been left for, in all
+	uint64_t dormantTurns() const {return m_dormantTurns;}
+
+  private:
+	/////////////////////////////////////////////////////////////////
+
+	enum Tier { HOT, WARM, COLD, NUMTIERS };
+
+	struct Entry
+	{
+		Tier tier;
+		Dungeon* live;                      // Hot
+		int playerRow, playerCol;           // Where the player left it
+		int leftTurn;                       // Game turn it was left on
+		std::vector<unsigned char> packed;  // Warm
+		size_t size;                        // Cold: packed bytes in the file
+		std::list<int>::iterator recent;    // In m_hot or m_warm
+	};
+
+	// Place of a level in the file, reused whenever it is written
+	// out again and still fits, so the file stops growing once every
+	// level has been written
+	struct FileSlot
+	{
+		long offset;
+		size_t capacity;
+	};
+
+	std::string m_path;
+	std::FILE* m_file;
+	int m_hotLevels, m_warmLevels;
+
+	std::map<int, Entry> m_entries; // By depth
+	std::map<int, FileSlot> m_slots; // By depth
+	std::list<int> m_hot, m_warm;   // Depths, most recently used first
+	size_t m_warmBytes, m_fileBytes;
+	uint64_t m_hits[NUMTIERS];
+	uint64_t m_dormantTurns;
+
+	// Private Helper Functions
+	void coolHot();  // Packs the least recently used hot level
+	void coolWarm(); // Writes the least recently used warm level out
+
+	// Caches own levels and a file, so they are not copied
+	LevelCache(const LevelCache&);
+	LevelCache& operator=(const LevelCache&);
+
+	/////////////////////////////////////////////////////////////////
+};
+
+// Pack the level stored in state (see Dungeon::capture) into bytes,
+// and unpack it again (false if bytes is not a packed level)
+void packLevel(const GameState& state, std::vector<unsigned char>& bytes);
+bool unpackLevel(const unsigned char* bytes, size_t size, GameState& state);
+
+#endif // LEVELCACHE_INCLUDED
@@ -0,0 +1,646 @@
+#include <algorithm>
+#include <cassert>
+#include <thread>
+#include <vector>
+
+#include "LevelGenerator.h"
+#include "Dungeon.h"
+#include "Player.h"
+#include "Monster.h"
+#include "Item.h"
+#include "Rng.h"
+#include "Definitions.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////
+// Base LevelGenerator Class Implementation
+////////////////////////////////////////////////////////////////////
+
+void LevelGenerator::generate(Rng& rng, int depth, Level& level,
+	int rows, int cols, bool endless) const
+	// Carve the terrain, then place monsters, the stair (or idol),
+	// the up stair (endless games only), objects and the player in
+	// that order
+{
+	rows = max(minRows(), min(rows, MAXROWS));
+	cols = max(minCols(), min(cols, MAXCOLS));
+
+	level.seed = 0;
+	level.style = style();
+	level.depth = depth;
+	level.rows = rows;
+	level.cols = cols;
+	level.numSpawns = 0;
+
+	// Generating terrain
+	carve(rng, level.grid, rows, cols);
+
+	// Keeping track of monsters placed so far
+	bool monsterAt[MAXROWS][MAXCOLS] = {};
+	int row, col;
+
+	const Definitions& defs = definitions();
+
+	// Generating monsters
+	int monsterNum = rng.randInt(defs.minMonsters,
+		defs.maxMonsters + defs.monstersPerLevel*depth); // No. of monsters
+	if(monsterNum > MAXSPAWNS - defs.maxObjects) // Leaving room for the objects
+		monsterNum = MAXSPAWNS - defs.maxObjects;
+	int openCells = 0;
+	for(int i = 0; i < rows; i++)
+		for(int j = 0; j < cols; j++)
+			if(level.grid[i][j] != WALL) openCells++;
+	assert(openCells >= 2); // Room for the stair and the way back up
+	if(monsterNum > openCells - 2) // Leaving room for both stairs
+		monsterNum = max(0, openCells - 2);
+
+	// Setting choices according to Dungeon level (the kinds that
+	// appear this deep, in order)
+	int kinds[NUMMONSTERKINDS];
+	int numKinds = 0;
+	for(int k = 0; k < NUMMONSTERKINDS; k++)
+		if(defs.monsters[k].minLevel <= depth)
+			kinds[numKinds++] = k;
+	if(numKinds == 0) monsterNum = 0;
+
+	for(int i = 0; i < monsterNum; i++)
+	{
+		produceOpenPos(rng, level, monsterAt, row, col);
+		monsterAt[row][col] = true;
+
+		Spawn& spawn = level.spawns[level.numSpawns++];
+		spawn.type = Spawn::MONSTERSPAWN;
+		spawn.kind = kinds[rng.randInt(0, numKinds - 1)];
+		spawn.row = row;
+		spawn.col = col;
+	}
+
+	// Adding stair or idol depending on level
+	produceOpenPos(rng, level, monsterAt, row, col);
+	level.grid[row][col] = (depth == IDOLLEVEL && !endless)? IDOL : STAIR;
+	level.stairRow = row;
+	level.stairCol = col;
+
+	// Adding the way back up, where the player starts
+	bool upStair = endless && depth > 0;
+	if(upStair)
+	{
+		do{
+			produceOpenPos(rng, level, monsterAt, row, col);
+		}while(level.grid[row][col] == STAIR);
+		level.grid[row][col] = UPSTAIR;
+		level.playerRow = row;
+		level.playerCol = col;
+	}
+
+	// Generating objects
+	int objectNum = rng.randInt(defs.minObjects, defs.maxObjects); // Number of GameObjects to add
+	for(int i = 0; i < objectNum; i++)
+	{
+		produceOpenPos(rng, level, monsterAt, row, col);
+
+		Spawn& spawn = level.spawns[level.numSpawns++];
+		spawn.row = row;
+		spawn.col = col;
+
+		// Randomly selecting an item from the bag
+		// (with repeats making some items more likely)
+		const Item& item = defs.objectBag[rng.randInt(0, defs.numObjectBag - 1)];
+		if(item.isWeapon())
+		{
+			spawn.type = Spawn::WEAPONSPAWN; spawn.kind = item.weapon.kind;
+		}
+		else
+		{
+			spawn.type = Spawn::SCROLLSPAWN; spawn.kind = item.scroll.kind;
+		}
+	}
+
+	// Placing player on a random position (unless on the up stair)
+	if(!upStair)
+	{
+		produceOpenPos(rng, level, monsterAt, row, col);
+		level.playerRow = row;
+		level.playerCol = col;
+	}
+}
+
+void LevelGenerator::generate(uint64_t seed, int depth, Level& level,
+	int rows, int cols, bool endless) const
+{
+	Rng rng(seed);
+	generate(rng, depth, level, rows, cols, endless);
+	level.seed = seed;
+}
+
+void LevelGenerator::produceOpenPos(Rng& rng, const Level& level,
+	const bool monsterAt[MAXROWS][MAXCOLS], int& row, int& col)
+	// Keep producing new positions until one is found that is
+	// not a wall and has no monster on it
+{
+	do{
+		row = rng.randInt(level.rows);
+		col = rng.randInt(level.cols);
+	}while(level.grid[row][col] == WALL || monsterAt[row][col]);
+}
+
+////////////////////////////////////////////////////////////////////
+// Derived LevelGenerator Classes Implementations
+////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////
+// Row of rooms
+
+// Helper structure
+struct Room
+{
+	// Top left corner of room
+	int m_r, m_c;
+	// Height and Width of the room
+	int m_dr,m_dc;
+
+	Room(int r, int dr, int c, int dc)
+	: m_r(r), m_c(c), m_dr(dr), m_dc(dc) {}
+	Room() {}
+};
+
+void RoomRowGenerator::carve(Rng& rng, char grid[MAXROWS][MAXCOLS],
+	int rows, int cols) const
+	// Set grid to have randomly generated rooms and connect them
+{
+	// Set everything on the grid to walls
+	for(int i = 0; i < rows; i++)
+		for(int j = 0; j < cols; j++)
+			grid[i][j] = WALL;
+
+	// Find the number of rooms to be placed together
+	// in horizontal direction
+	int numOfRoomsC = rng.randInt(4,6);
+
+	// Finding max width
+	int maxDc = (cols - 3 - numOfRoomsC)/numOfRoomsC;
+	// Fidning Max height
+	int maxDr = (rows - 5);
+
+	Room prevRoom(0,0,0,0);
+
+	// Generate each room
+	for(int j = 0; j < numOfRoomsC; j++)
+	{
+		Room thisRoom; // Generate a new room
+
+		thisRoom.m_dc = rng.randInt(5, maxDc); // Deciding room width
+		thisRoom.m_dr = rng.randInt(3, maxDr); // Deciding room height
+
+		// Deciding the top left corner depending on where the
+		// previous room is and the dimensions of this room
+		int maxUpper = rows - 1 - maxDr;
+		int prevLower = prevRoom.m_r + prevRoom.m_dr;
+
+		// Ensuring the new room shares a wall with the prev room
+		if(prevLower != 0 && prevLower <  maxUpper)
+			maxUpper = prevLower - 1;
+
+		thisRoom.m_r = rng.randInt(2 ,maxUpper);
+		thisRoom.m_c = rng.randInt(1 + prevRoom.m_c + prevRoom.m_dc,
+		 1 + prevRoom.m_c + prevRoom.m_dc + maxDc - thisRoom.m_dc);
+
+		// Clear this room
+		for(int i=thisRoom.m_r; i < thisRoom.m_r+thisRoom.m_dr; i++)
+			for(int j=thisRoom.m_c; j<thisRoom.m_c+thisRoom.m_dc; j++)
+				grid[i][j] = ' ';
+
+		// Clear a path between this and the last room
+		if(prevRoom.m_dr != 0 && prevRoom.m_dc != 0)
+		{
+			// Determining bounds on corridor height
+
+			// Highest a corridor can be
+			int r1 = max(thisRoom.m_r, prevRoom.m_r);
+			// Lowest a corridor can be
+			int r2 = min(thisRoom.m_r + thisRoom.m_dr - 1,
+						prevRoom.m_r + prevRoom.m_dr - 1);
+
+			int cr = rng.randInt(r1, r2);  // Corridor height
+
+			// Clear the corridor
+			for(int i = prevRoom.m_c + prevRoom.m_dc; i < thisRoom.m_c; i++)
+			{
+				grid[cr][i] = ' ';
+			}
+		}
+		prevRoom = thisRoom;
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+// BSP rooms
+
+const int BSPMINROWS = 4; // Smallest area a room is placed in
+const int BSPMINCOLS = 7;
+
+static void carveCorridor(char grid[MAXROWS][MAXCOLS],
+	int r1, int c1, int r2, int c2)
+	// Clear an L-shaped corridor from (r1, c1) to (r2, c2)
+{
+	for(int j = min(c1, c2); j <= max(c1, c2); j++)
+		grid[r1][j] = ' ';
+	for(int i = min(r1, r2); i <= max(r1, r2); i++)
+		grid[i][c2] = ' ';
+}
+
+static void bspCarve(Rng& rng, char grid[MAXROWS][MAXCOLS],
+	int r, int c, int dr, int dc, int& cr, int& cc)
+	// Split the area at (r, c) of size dr x dc in two and carve both
+	// halves, or place a single room in it if it is too small.
+	// (cr, cc) is set to a cell inside one of the rooms carved.
+{
+	bool canSplitR = dr >= 2*BSPMINROWS + 1;
+	bool canSplitC = dc >= 2*BSPMINCOLS + 1;
+
+	// Larger areas are always split, smaller ones sometimes kept whole
+	if((canSplitR || canSplitC)
+		&& (dr*dc > 120 || rng.trueWithProbability(0.75)))
+	{
+		// Splitting along the longer side (rows are about twice as
+		// tall as columns are wide on a terminal)
+		bool splitC = canSplitC && (!canSplitR || dc > 2*dr);
+
+		int r1, c1, r2, c2;
+		if(splitC)
+		{
+			int at = rng.randInt(c + BSPMINCOLS, c + dc - BSPMINCOLS - 1);
+			bspCarve(rng, grid, r, c, dr, at - c, r1, c1);
+			bspCarve(rng, grid, r, at + 1, dr, c + dc - at - 1, r2, c2);
+		}
+		else
+		{
+			int at = rng.randInt(r + BSPMINROWS, r + dr - BSPMINROWS - 1);
+			bspCarve(rng, grid, r, c, at - r, dc, r1, c1);
+			bspCarve(rng, grid, at + 1, c, r + dr - at - 1, dc, r2, c2);
+		}
+
+		// Joining the two halves
+		if(rng.trueWithProbability(0.5))
+			carveCorridor(grid, r1, c1, r2, c2);
+		else
+			carveCorridor(grid, r2, c2, r1, c1);
+
+		// Either half can represent this area
+		if(rng.trueWithProbability(0.5))
+		{
+			cr = r1; cc = c1;
+		}
+		else
+		{
+			cr = r2; cc = c2;
+		}
+		return;
+	}
+
+	// Placing a room in the area leaving a wall on its far sides
+	int roomDr = rng.randInt(min(3, dr - 1), dr - 1);
+	int roomDc = rng.randInt(min(4, dc - 1), dc - 1);
+	int roomR = rng.randInt(r, r + dr - 1 - roomDr);
+	int roomC = rng.randInt(c, c + dc - 1 - roomDc);
+
+	for(int i = roomR; i < roomR + roomDr; i++)
+		for(int j = roomC; j < roomC + roomDc; j++)
+			grid[i][j] = ' ';
+
+	cr = rng.randInt(roomR, roomR + roomDr - 1);
+	cc = rng.randInt(roomC, roomC + roomDc - 1);
+}
+
+void BspRoomGenerator::carve(Rng& rng, char grid[MAXROWS][MAXCOLS],
+	int rows, int cols) const
+{
+	// Set everything on the grid to walls
+	for(int i = 0; i < rows; i++)
+		for(int j = 0; j < cols; j++)
+			grid[i][j] = WALL;
+
+	// Partitioning everything inside the outer wall
+	int cr, cc;
+	bspCarve(rng, grid, 1, 1, rows - 1, cols - 1, cr, cc);
+}
+
+////////////////////////////////////////////////////////////////////
+// Cellular automata caves
+
+// Initial chance of a cell being wall, out of 128 (about 45%)
+const uint64_t CAVEWALLCHANCE = 58;
+const int CAVESTEPS = 4; // Smoothing steps
+const int CAVETRIES = 64; // Fills tried before settling for the largest cave
+const int CAVEMINOPEN = 15; // Smallest cave settled for (a 3 x 5 room)
+
+// The automaton works on rows of bits (bit j is column j, set for
+// wall) so that 64 cells are updated with every operation
+const int CAVEWORDS = (MAXCOLS + 63)/64;
+
+struct CaveRow
+{
+	uint64_t w[CAVEWORDS];
+};
+
+// A horizontal run of open cells, also a union-find node
+struct CaveRun
+{
+	int row, start, end; // Cells start to end (inclusive) of row
+	int parent;          // Union-find parent
+	int size;            // Cells in the cave (valid for roots)
+};
+
+static inline void shiftLeftCols(const CaveRow& in, CaveRow& out)
+	// Bit j of out is bit j-1 of in (left neighbour of column j)
+{
+	uint64_t carry = 0;
+	for(int k = 0; k < CAVEWORDS; k++)
+	{
+		out.w[k] = (in.w[k] << 1) | carry;
+		carry = in.w[k] >> 63;
+	}
+}
+
+static inline void shiftRightCols(const CaveRow& in, CaveRow& out)
+	// Bit j of out is bit j+1 of in (right neighbour of column j)
+{
+	uint64_t carry = 0;
+	for(int k = CAVEWORDS - 1; k >= 0; k--)
+	{
+		out.w[k] = (in.w[k] >> 1) | carry;
+		carry = in.w[k] << 63;
+	}
+}
+
+static inline uint64_t randomWalls(Rng& rng)
+	// 64 cells, each wall with a chance of CAVEWALLCHANCE/128.
+	// Every byte of a draw is compared to the chance at once.
+{
+	const uint64_t lowBits = 0x7F7F7F7F7F7F7F7FULL;
+	const uint64_t highBits = 0x8080808080808080ULL;
+	const uint64_t offset = (128 - CAVEWALLCHANCE) * 0x0101010101010101ULL;
+
+	uint64_t walls = 0;
+	for(int g = 0; g < 8; g++)
+	{
+		uint64_t draw = (uint64_t(rng.next()) << 32) | rng.next();
+		// High bit of a byte is clear iff its low 7 bits < chance
+		uint64_t isWall = ~((draw & lowBits) + offset) & highBits;
+		// Gathering the 8 flags into one byte
+		walls |= (((isWall >> 7) * 0x0102040810204080ULL) >> 56) << (8*g);
+	}
+	return walls;
+}
+
+static inline int lowestBit(uint64_t word)
+	// Index of the lowest set bit of a non-zero word
+{
+#if defined(__GNUC__)
+	return __builtin_ctzll(word);
+#else
+	int bit = 0;
+	while(!(word & 1)) {word >>= 1; bit++;}
+	return bit;
+#endif
+}
+
+static inline int nextCol(const CaveRow& row, int from, bool wall)
+	// First column at or after from that is wall (or open if !wall).
+	// Returns 64*CAVEWORDS if there is none.
+{
+	int k = from >> 6;
+	if(k >= CAVEWORDS) return 64*CAVEWORDS;
+	uint64_t word = (wall ? row.w[k] : ~row.w[k]) & (~0ULL << (from & 63));
+	while(!word)
+	{
+		if(++k == CAVEWORDS) return 64*CAVEWORDS;
+		word = wall ? row.w[k] : ~row.w[k];
+	}
+	return 64*k + lowestBit(word);
+}
+
+static int findRun(CaveRun runs[], int run)
+	// Union-find root of run (with path halving)
+{
+	while(runs[run].parent != run)
+	{
+		runs[run].parent = runs[runs[run].parent].parent;
+		run = runs[run].parent;
+	}
+	return run;
+}
+
+void CaveGenerator::carve(Rng& rng, char grid[MAXROWS][MAXCOLS],
+	int rows, int cols) const
+{
+	CaveRow rowsA[MAXROWS], rowsB[MAXROWS];
+	CaveRow* curr = rowsA;
+	CaveRow* next = rowsB;
+
+	// Cells that are not interior (border and past the last column)
+	// are always wall
+	CaveRow border;
+	for(int k = 0; k < CAVEWORDS; k++)
+		border.w[k] = ~0ULL;
+	for(int j = 1; j < cols - 1; j++)
+		border.w[j >> 6] &= ~(1ULL << (j & 63));
+
+	// Runs of open cells
+	CaveRun runs[MAXROWS*MAXCOLS/2 + MAXROWS];
+	int keptSize = 0; // Largest cave carved into grid so far
+	for(int i = 0; i < rows; i++)
+		for(int j = 0; j < cols; j++)
+			grid[i][j] = WALL;
+
+	for(int tries = 0; tries < CAVETRIES; tries++) // Until a large enough cave is produced
+	{
+		// Random fill
+		for(int i = 0; i < rows; i++)
+		{
+			if(i == 0 || i == rows - 1)
+			{
+				for(int k = 0; k < CAVEWORDS; k++)
+					curr[i].w[k] = next[i].w[k] = ~0ULL;
+				continue;
+			}
+			for(int k = 0; k < CAVEWORDS; k++)
+				curr[i].w[k] = randomWalls(rng) | border.w[k];
+		}
+
+		// Smoothing: a cell becomes wall if at least 5 of the 9 cells
+		// around it (including itself) are walls. The count is done
+		// with bitwise adders, one bit of the count per word.
+		for(int step = 0; step < CAVESTEPS; step++)
+		{
+			for(int i = 1; i < rows - 1; i++)
+			{
+				// Walls in each column of the 3 rows (0 to 3)
+				CaveRow v0, v1;
+				for(int k = 0; k < CAVEWORDS; k++)
+				{
+					uint64_t a = curr[i-1].w[k], b = curr[i].w[k], c = curr[i+1].w[k];
+					v0.w[k] = a ^ b ^ c;
+					v1.w[k] = (a & b) | (c & (a ^ b));
+				}
+				// Same counts for the columns on either side
+				CaveRow x0, x1, z0, z1;
+				shiftLeftCols(v0, x0);
+				shiftLeftCols(v1, x1);
+				shiftRightCols(v0, z0);
+				shiftRightCols(v1, z1);
+
+				for(int k = 0; k < CAVEWORDS; k++)
+				{
+					// t = x + v (3 bits)
+					uint64_t t0 = x0.w[k] ^ v0.w[k];
+					uint64_t c0 = x0.w[k] & v0.w[k];
+					uint64_t t1 = x1.w[k] ^ v1.w[k] ^ c0;
+					uint64_t t2 = (x1.w[k] & v1.w[k]) | (c0 & (x1.w[k] ^ v1.w[k]));
+					// u = t + z (4 bits)
+					uint64_t u0 = t0 ^ z0.w[k];
+					uint64_t d0 = t0 & z0.w[k];
+					uint64_t u1 = t1 ^ z1.w[k] ^ d0;
+					uint64_t d1 = (t1 & z1.w[k]) | (d0 & (t1 ^ z1.w[k]));
+					uint64_t u2 = t2 ^ d1;
+					uint64_t u3 = t2 & d1;
+					// u >= 5
+					next[i].w[k] = (u3 | (u2 & (u1 | u0))) | border.w[k];
+				}
+			}
+			CaveRow* temp = curr;
+			curr = next;
+			next = temp;
+		}
+
+		// Labelling connected caves: runs of open cells in each row
+		// are joined with the overlapping runs of the row above
+		int numRuns = 0;
+		int prevFirst = 0, prevEnd = 0; // Runs of the row above
+		for(int i = 1; i < rows - 1; i++)
+		{
+			int first = numRuns;
+			// (the border column on the right always ends a run)
+			for(int j = nextCol(curr[i], 1, false); j < cols - 1;
+				j = nextCol(curr[i], j, false))
+			{
+				CaveRun& run = runs[numRuns];
+				run.row = i;
+				run.start = j;
+				j = nextCol(curr[i], j, true);
+				run.end = j - 1;
+				run.parent = numRuns;
+				run.size = run.end - run.start + 1;
+				numRuns++;
+			}
+
+			// Joining with the runs above (both lists are sorted)
+			int p = prevFirst;
+			for(int r = first; r < numRuns; r++)
+			{
+				while(p < prevEnd && runs[p].end < runs[r].start) p++;
+				for(int q = p; q < prevEnd && runs[q].start <= runs[r].end; q++)
+				{
+					int a = findRun(runs, r), b = findRun(runs, q);
+					if(a != b)
+					{
+						runs[a].parent = b;
+						runs[b].size += runs[a].size;
+					}
+				}
+			}
+			prevFirst = first;
+			prevEnd = numRuns;
+		}
+
+		// Finding the largest cave
+		int bestRoot = -1, bestSize = 0;
+		for(int r = 0; r < numRuns; r++)
+			if(runs[r].parent == r && runs[r].size > bestSize)
+			{
+				bestSize = runs[r].size;
+				bestRoot = r;
+			}
+
+		// Keeping only the largest cave (of all tries)
+		if(bestSize > keptSize)
+		{
+			keptSize = bestSize;
+			for(int i = 0; i < rows; i++)
+				for(int j = 0; j < cols; j++)
+					grid[i][j] = WALL;
+			for(int r = 0; r < numRuns; r++)
+				if(findRun(runs, r) == bestRoot)
+					for(int j = runs[r].start; j <= runs[r].end; j++)
+						grid[runs[r].row][j] = ' ';
+		}
+
+		// Retry if the level would be too cramped
+		if(keptSize >= rows*cols/4)
+			return;
+	}
+	// Out of tries: the largest cave found stands, unless there is
+	// hardly any, when a small room in the middle is carved instead
+	if(keptSize < CAVEMINOPEN)
+	{
+		for(int i = 0; i < rows; i++)
+			for(int j = 0; j < cols; j++)
+				grid[i][j] = WALL;
+		for(int i = rows/2 - 1; i <= rows/2 + 1; i++)
+			for(int j = cols/2 - 2; j <= cols/2 + 2; j++)
+				grid[i][j] = ' ';
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+// Generation Functions
+////////////////////////////////////////////////////////////////////
+
+const LevelGenerator& levelGenerator(LevelStyle style)
+{
+	static const RoomRowGenerator roomRow;
+	static const BspRoomGenerator bspRooms;
+	static const CaveGenerator caves;
+
+	switch(style)
+	{
+		case BSPROOMS: return bspRooms;
+		case CAVES:    return caves;
+		default:       return roomRow;
+	}
+}
+
+static void generateRange(const LevelGenerator* generator, int depth,
+	uint64_t seed, uint64_t first, Level* levels, int count)
+	// Generate a contiguous range of levels on the calling thread
+{
+	for(int i = 0; i < count; i++)
+		generator->generate(mixSeed(seed, first + i), depth, levels[i]);
+}
+
+void generateLevels(LevelStyle style, int depth, uint64_t seed,
+	uint64_t first, Level* levels, int count, int numThreads)
+{
+	const LevelGenerator& generator = levelGenerator(style);
+
+	if(numThreads > count) numThreads = count;
+	if(numThreads <= 1)
+	{
+		generateRange(&generator, depth, seed, first, levels, count);
+		return;
+	}
+
+	// Giving each thread an equal contiguous share of the batch
+	vector<thread> workers;
+	int done = 0;
+	for(int t = 0; t < numThreads; t++)
+	{
+		int share = (count - done) / (numThreads - t);
+		workers.push_back(thread(generateRange, &generator, depth,
+			seed, first + done, levels + done, share));
+		done += share;
+	}
+	for(size_t t = 0; t < workers.size(); t++)
+		workers[t].join();
+}
@@ -0,0 +1,158 @@
+// LevelGenerator.h
+
+#ifndef LEVELGENERATOR_INCLUDED
+#define LEVELGENERATOR_INCLUDED
+
+#include <cstdint>
+
+#include "Dungeon.h"
+#include "Rng.h"
+
+// Generated levels per second every worker thread of a batch is
+// expected to reach on every level style (checked by
+// tools/levelgen_bench.cpp)
+const int TARGETLEVELSPERSEC = 50000;
+
+const int MAXSPAWNS = 32; // Max no. of monsters and objects in a fresh level
+const int IDOLLEVEL = 4;  // Level with the golden idol instead of a stair
+
+// Smallest levels of each style: room rows need room for six rooms
+// of at least 5 x 3 with walls around them, BSP rooms for a split
+// into two rooms, and caves for a cave that holds the spawns
+const int ROOMROWMINROWS = 8;
+const int ROOMROWMINCOLS = 39;
+const int BSPLEVELMINROWS = 10;
+const int BSPLEVELMINCOLS = 16;
+const int CAVEMINROWS = 8;
+const int CAVEMINCOLS = 12;
+
+////////////////////////////////////////////////////////////////////
+// Level Structures
+//
+// A Level is the complete plan of a freshly generated dungeon level
+// stored in one flat block: terrain (with the stair or idol),
+// monsters and objects to spawn and where the player starts.
+////////////////////////////////////////////////////////////////////
+
+struct Spawn
+{
+	// Spawn types
+	enum { MONSTERSPAWN, WEAPONSPAWN, SCROLLSPAWN };
+
+	unsigned char type;     // What is spawned
+	unsigned char kind;     // MonsterKind, WeaponKind or ScrollKind
+	unsigned char row, col; // Where it is spawned
+};
+
+struct Level
+{
+	uint64_t seed;     // Seed the level was generated from
+	LevelStyle style;  // Generator that produced the level
+	int depth;         // Level of the Dungeon
+	int rows, cols;    // Size of the level
+
+	char grid[MAXROWS][MAXCOLS]; // Terrain, stairs and idol
+
+	int stairRow, stairCol;   // Position of stair (or idol)
+	int playerRow, playerCol; // Starting position of player
+
+	int numSpawns;
+	Spawn spawns[MAXSPAWNS]; // Monsters first, then objects
+};
+
+////////////////////////////////////////////////////////////////////
+// Base LevelGenerator Class Declaration
+////////////////////////////////////////////////////////////////////
+
+class LevelGenerator
+{
+  public:
+	virtual ~LevelGenerator() {}
+
+	/////////////////////////////////////////////////////////////////
+	// Generation Functions
+
+	// Generate a complete level: terrain, stair or idol, spawns
+	// and player position. Uses only rng as source of randomness.
+	// Levels of an endless game have no idol, and below level 0 an
+	// up stair the player starts on. Sizes below the style's minimum
+	// (or above MAXROWS x MAXCOLS) are clamped, the size used being
+	// recorded in the level.
+	void generate(Rng& rng, int depth, Level& level,
+		int rows = MAXROWS, int cols = MAXCOLS, bool endless = false) const;
+	// Same, with a new Rng seeded by seed (recorded in the level)
+	void generate(uint64_t seed, int depth, Level& level,
+		int rows = MAXROWS, int cols = MAXCOLS, bool endless = false) const;
+
+	// Style of levels produced
+	virtual LevelStyle style() const = 0;
+	// Smallest size the style carves a sound level in
+	virtual int minRows() const = 0;
+	virtual int minCols() const = 0;
+
+	// Set the terrain of the grid: WALL or open (' ') in every cell
+	// of the rows x cols area. Open cells must all be connected.
+	virtual void carve(Rng& rng, char grid[MAXROWS][MAXCOLS],
+		int rows, int cols) const = 0;
+
+  private:
+	/////////////////////////////////////////////////////////////////
+	// Private Helper Functions
+
+	// Produce a random open position with no monster on it
+	static void produceOpenPos(Rng& rng, const Level& level,
+		const bool monsterAt[MAXROWS][MAXCOLS], int& row, int& col);
+};
+
+////////////////////////////////////////////////////////////////////
+// Derived LevelGenerator Classes Declarations
+////////////////////////////////////////////////////////////////////
+
+// 4 to 6 rooms in a row joined by horizontal corridors
+class RoomRowGenerator : public LevelGenerator
+{
+  public:
+	virtual LevelStyle style() const {return ROOMROW;}
+	virtual int minRows() const {return ROOMROWMINROWS;}
+	virtual int minCols() const {return ROOMROWMINCOLS;}
+	virtual void carve(Rng& rng, char grid[MAXROWS][MAXCOLS],
+		int rows, int cols) const;
+};
+
+// Rooms in the leaves of a binary space partition, siblings
+// joined by L-shaped corridors
+class BspRoomGenerator : public LevelGenerator
+{
+  public:
+	virtual LevelStyle style() const {return BSPROOMS;}
+	virtual int minRows() const {return BSPLEVELMINROWS;}
+	virtual int minCols() const {return BSPLEVELMINCOLS;}
+	virtual void carve(Rng& rng, char grid[MAXROWS][MAXCOLS],
+		int rows, int cols) const;
+};
+
+// Cellular automata caves, keeping the largest connected cave
+class CaveGenerator : public LevelGenerator
+{
+  public:
+	virtual LevelStyle style() const {return CAVES;}
+	virtual int minRows() const {return CAVEMINROWS;}
+	virtual int minCols() const {return CAVEMINCOLS;}
+	virtual void carve(Rng& rng, char grid[MAXROWS][MAXCOLS],
+		int rows, int cols) const;
+};
+
+////////////////////////////////////////////////////////////////////
+// Generation Functions
+////////////////////////////////////////////////////////////////////
+
+// Generator for the given style
+const LevelGenerator& levelGenerator(LevelStyle style);
+
+// Generate count levels of the given style and depth into levels.
+// Level i is generated from mixSeed(seed, first + i), so the output
+// is the same for any number of threads and any batch split.
+void generateLevels(LevelStyle style, int depth, uint64_t seed,
+	uint64_t first, Level* levels, int count, int numThreads = 1);
+
+#endif // LEVELGENERATOR_INCLUDED
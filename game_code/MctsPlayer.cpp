@@ -0,0 +1,351 @@
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+#include "MctsPlayer.h"
+#include "GameState.h"
+#include "utilities.h"
+
+using namespace std;
+
+const int MAXSTAIRSTEPS = 400; // Steps counted as far from the stair
+
+static const char MOVES[4] = {ARROW_UP, ARROW_DOWN, ARROW_LEFT, ARROW_RIGHT};
+static const int MOVEROW[4] = {-1, 1, 0, 0};
+static const int MOVECOL[4] = {0, 0, -1, 1};
+
+////////////////////////////////////////////////////////////////////
+// Commands
+////////////////////////////////////////////////////////////////////
+
+int legalCommands(const GameState& state, PlayerCommand commands[MAXCOMMANDS])
+{
+	int count = 0;
+	int row = state.player.row, col = state.player.col;
+
+	// Moves (and attacks) that don't walk into a wall
+	for(int dir = 0; dir < 4; dir++)
+		if(!state.isWall(row + MOVEROW[dir], col + MOVECOL[dir]))
+			commands[count++] = {MOVES[dir], 0};
+
+	// Picking up and going down
+	if(state.grid[row][col] == IDOL
+		|| (state.objectAt(row, col) != -1 && !state.inventory.isFull()))
+		commands[count++] = {'g', 0};
+	if(state.grid[row][col] == STAIR)
+		commands[count++] = {'>', 0};
+
+	// Wielding another kind of weapon, reading each kind of scroll
+	bool weaponSeen[NUMWEAPONKINDS] = {};
+	bool scrollSeen[NUMSCROLLKINDS] = {};
+	weaponSeen[state.player.weapon.kind] = true;
+	for(int i = 0; i < state.inventory.size(); i++)
+	{
+		const Item& item = state.inventory[i];
+		if(item.isWeapon() && !weaponSeen[item.weapon.kind])
+		{
+			weaponSeen[item.weapon.kind] = true;
+			commands[count++] = {'w', char('a' + i)};
+		}
+		else if(item.isScroll() && !scrollSeen[item.scroll.kind])
+		{
+			scrollSeen[item.scroll.kind] = true;
+			commands[count++] = {'r', char('a' + i)};
+		}
+	}
+
+	if(count == 0) // Nowhere to go
+		commands[count++] = {'s', 0};
+	return count;
+}
+
+static void goalDistances(const GameState& state, short dist[MAXROWS][MAXCOLS])
+	// Steps from every cell to the stair or idol, around walls
+	// (-1 where it can't be reached)
+{
+	unsigned char queueRow[MAXROWS * MAXCOLS], queueCol[MAXROWS * MAXCOLS];
+	int head = 0, tail = 0;
+	for(int i = 0; i < state.rows; i++)
+		for(int j = 0; j < state.cols; j++)
+		{
+			dist[i][j] = -1;
+			if(state.grid[i][j] == STAIR || state.grid[i][j] == IDOL)
+			{
+				dist[i][j] = 0;
+				queueRow[tail] = i; queueCol[tail++] = j;
+			}
+		}
+	while(head < tail)
+	{
+		int r = queueRow[head], c = queueCol[head++];
+		for(int dir = 0; dir < 4; dir++)
+		{
+			int nr = r + MOVEROW[dir], nc = c + MOVECOL[dir];
+			if(state.isWall(nr, nc) || dist[nr][nc] != -1)
+				continue;
+			dist[nr][nc] = dist[r][c] + 1;
+			queueRow[tail] = nr; queueCol[tail++] = nc;
+		}
+	}
+}
+
+PlayerCommand rolloutCommand(const GameState& state, Rng& rng)
+{
+	int row = state.player.row, col = state.player.col;
+	if(state.grid[row][col] == IDOL)
+		return {'g', 0};
+	if(state.grid[row][col] == STAIR)
+		return {'>', 0};
+	if(state.objectAt(row, col) != -1 && !state.inventory.isFull())
+		return {'g', 0};
+	return {MOVES[rng.randInt(4)], 0};
+}
+
+PlayerCommand seekerCommand(const GameState& state, Rng& rng)
+{
+	int row = state.player.row, col = state.player.col;
+	if(state.grid[row][col] == IDOL)
+		return {'g', 0};
+	if(state.grid[row][col] == STAIR)
+		return {'>', 0};
+	if(state.objectAt(row, col) != -1 && !state.inventory.isFull())
+		return {'g', 0};
+
+	// Fighting back
+	for(int dir = 0; dir < 4; dir++)
+		if(state.monsterAt(row + MOVEROW[dir], col + MOVECOL[dir]) != -1)
+			return {MOVES[dir], 0};
+
+	// Best weapon in the knapsack
+	int bestWeapon = -1, bestDamage = state.player.weapon.damageAmt();
+	for(int i = 0; i < state.inventory.size(); i++)
+		if(state.inventory[i].isWeapon()
+			&& state.inventory[i].weapon.damageAmt() > bestDamage)
+		{
+			bestWeapon = i;
+			bestDamage = state.inventory[i].weapon.damageAmt();
+		}
+	if(bestWeapon != -1)
+		return {'w', char('a' + bestWeapon)};
+
+	// One step closer to the stair or idol (ties broken at random)
+	short dist[MAXROWS][MAXCOLS];
+	goalDistances(state, dist);
+	int closest[4], numClosest = 0, closestDist = -1;
+	for(int dir = 0; dir < 4; dir++)
+	{
+		int r = row + MOVEROW[dir], c = col + MOVECOL[dir];
+		if(state.isWall(r, c) || dist[r][c] == -1
+			|| (numClosest > 0 && dist[r][c] > closestDist))
+			continue;
+		if(numClosest == 0 || dist[r][c] < closestDist)
+			numClosest = 0;
+		closestDist = dist[r][c];
+		closest[numClosest++] = dir;
+	}
+	if(numClosest == 0)
+		return {MOVES[rng.randInt(4)], 0};
+	return {MOVES[closest[rng.randInt(numClosest)]], 0};
+}
+
+////////////////////////////////////////////////////////////////////
+// Search Tree
+////////////////////////////////////////////////////////////////////
+
+struct SearchNode
+{
+	PlayerCommand command; // Command leading to the node
+	int firstChild;        // -1 until expanded
+	int numChildren;
+	int visits;
+	double valueSum;
+};
+
+// What every thread reports about the commands at the root
+struct RootStats
+{
+	vector<int> visits;
+	vector<double> valueSums;
+	int rollouts;
+};
+
+static void searchTree(const GameState& root, const PlayerCommand* rootCommands,
+	int numRoot, const MctsOptions& options, uint64_t seed,
+	chrono::steady_clock::time_point deadline, atomic<int>* rolloutsLeft,
+	RootStats& stats)
+	// Grow one tree from root until a budget runs out
+{
+	Rng rng(seed);
+	vector<SearchNode> nodes;
+	nodes.reserve(4096);
+
+	// Root with its children
+	nodes.push_back({{0, 0}, 1, numRoot, 0, 0});
+	for(int i = 0; i < numRoot; i++)
+		nodes.push_back({rootCommands[i], -1, 0, 0, 0});
+
+	vector<int> path;
+	PlayerCommand commands[MAXCOMMANDS];
+	stats.rollouts = 0;
+
+	for(;;)
+	{
+		// Checking the budgets
+		if(rolloutsLeft && rolloutsLeft->fetch_sub(1) <= 0)
+			break;
+		if(options.maxSeconds > 0 && chrono::steady_clock::now() >= deadline)
+			break;
+		stats.rollouts++;
+
+		// Copy of the game with its own dice
+		GameState state = root;
+		state.rng.setSeed(rng.next64());
+
+		// Selection and expansion
+		path.clear();
+		path.push_back(0);
+		int node = 0;
+		for(int depth = 0; depth < options.treeDepth && !state.isOver(); depth++)
+		{
+			if(nodes[node].firstChild == -1)
+			{
+				int count = legalCommands(state, commands);
+				nodes[node].firstChild = nodes.size();
+				nodes[node].numChildren = count;
+				for(int i = 0; i < count; i++)
+					nodes.push_back({commands[i], -1, 0, 0, 0});
+			}
+
+			// Untried commands first, then the best UCT score
+			const SearchNode& parent = nodes[node];
+			int best = -1;
+			double bestScore = -1;
+			double logVisits = log(double(parent.visits + 1));
+			for(int c = parent.firstChild; c < parent.firstChild + parent.numChildren; c++)
+			{
+				if(nodes[c].visits == 0)
+				{
+					best = c;
+					break;
+				}
+				double score = nodes[c].valueSum / nodes[c].visits
+					+ options.exploration * sqrt(logVisits / nodes[c].visits);
+				if(score > bestScore)
+				{
+					bestScore = score;
+					best = c;
+				}
+			}
+
+			node = best;
+			path.push_back(node);
+			state.step(nodes[node].command.command, nodes[node].command.choice);
+			if(nodes[node].visits == 0)
+				break; // New node: continue at random
+		}
+
+		// Rollout
+		for(int t = 0; t < options.rolloutDepth && !state.isOver(); t++)
+		{
+			PlayerCommand command = rolloutCommand(state, rng);
+			state.step(command.command, command.choice);
+		}
+
+		// Backpropagation
+		double value = MctsPlayer::evaluate(state);
+		for(size_t i = 0; i < path.size(); i++)
+		{
+			nodes[path[i]].visits++;
+			nodes[path[i]].valueSum += value;
+		}
+	}
+
+	stats.visits.assign(numRoot, 0);
+	stats.valueSums.assign(numRoot, 0);
+	for(int i = 0; i < numRoot; i++)
+	{
+		stats.visits[i] = nodes[1 + i].visits;
+		stats.valueSums[i] = nodes[1 + i].valueSum;
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+// MctsPlayer Class Implementation
+////////////////////////////////////////////////////////////////////
+
+MctsPlayer::MctsPlayer(const MctsOptions& options, uint64_t seed)
+	: m_options(options), m_rng(seed), m_lastRollouts(0)
+{
+	if(m_options.numThreads < 1) m_options.numThreads = 1;
+	if(m_options.maxRollouts <= 0 && m_options.maxSeconds <= 0)
+		m_options.maxRollouts = MctsOptions().maxRollouts; // Needs some budget
+}
+
+PlayerCommand MctsPlayer::decide(const GameState& state)
+{
+	PlayerCommand rootCommands[MAXCOMMANDS];
+	int numRoot = legalCommands(state, rootCommands);
+	m_lastRollouts = 0;
+	if(numRoot == 1)
+		return rootCommands[0]; // Nothing to decide
+
+	chrono::steady_clock::time_point deadline = chrono::steady_clock::now()
+		+ chrono::duration_cast<chrono::steady_clock::duration>(
+			chrono::duration<double>(m_options.maxSeconds));
+	atomic<int> rolloutsLeft(m_options.maxRollouts);
+	atomic<int>* budget = (m_options.maxRollouts > 0) ? &rolloutsLeft : nullptr;
+
+	// Growing a tree on every thread (the caller's thread included)
+	int numThreads = m_options.numThreads;
+	vector<RootStats> stats(numThreads);
+	vector<thread> workers;
+	for(int t = 1; t < numThreads; t++)
+		workers.push_back(thread(searchTree, cref(state), rootCommands, numRoot,
+			cref(m_options), m_rng.next64(),
+			deadline, budget, ref(stats[t])));
+	searchTree(state, rootCommands, numRoot, m_options,
+		m_rng.next64(), deadline, budget, stats[0]);
+	for(size_t t = 0; t < workers.size(); t++)
+		workers[t].join();
+
+	// Adding up the root statistics of all trees
+	vector<int> visits(numRoot, 0);
+	vector<double> valueSums(numRoot, 0);
+	for(int t = 0; t < numThreads; t++)
+	{
+		m_lastRollouts += stats[t].rollouts;
+		for(int i = 0; i < numRoot; i++)
+		{
+			visits[i] += stats[t].visits[i];
+			valueSums[i] += stats[t].valueSums[i];
+		}
+	}
+
+	// Most visited command (best average value among equals)
+	int best = 0;
+	for(int i = 1; i < numRoot; i++)
+		if(visits[i] > visits[best]
+			|| (visits[i] == visits[best] && visits[i] > 0
+				&& valueSums[i] / visits[i] > valueSums[best] / visits[best]))
+			best = i;
+	return rootCommands[best];
+}
+
+double MctsPlayer::evaluate(const GameState& state)
+{
+	if(state.hasWon) return 1;
+	if(state.player.hit <= 0) return 0;
+
+	// Steps from the player to the stair or idol, around walls
+	short dist[MAXROWS][MAXCOLS];
+	goalDistances(state, dist);
+	int steps = dist[state.player.row][state.player.col];
+	if(steps < 0 || steps > MAXSTAIRSTEPS) steps = MAXSTAIRSTEPS;
+
+	// Levels done and part of the way through this one
+	double progress = (state.level + 1.0 - double(steps) / MAXSTAIRSTEPS) / (IDOLLEVEL + 1);
+	double health = double(state.player.hit) / state.maxHit;
+	return 0.05 + 0.6 * progress + 0.3 * health;
+}
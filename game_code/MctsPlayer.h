@@ -0,0 +1,96 @@
+// MctsPlayer.h
+
+#ifndef MCTSPLAYER_INCLUDED
+#define MCTSPLAYER_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+#include "GameState.h"
+#include "Rng.h"
+
+const int MAXCOMMANDS = 6 + 2*MAXINVENTORY; // Moves, g, >, wield, read
+
+////////////////////////////////////////////////////////////////////
+// Player Command
+////////////////////////////////////////////////////////////////////
+
+struct PlayerCommand
+{
+	char command; // h, j, k, l, g, >, w or r
+	char choice;  // Inventory key for w and r
+};
+
+// Commands worth trying in state (moves always, picking up, going
+// down, wielding another weapon and reading scrolls when they can
+// do something). Returns the number of commands written.
+int legalCommands(const GameState& state, PlayerCommand commands[MAXCOMMANDS]);
+
+// Command of the fast rollout policy: take the idol or the stair
+// when standing on it, pick things up, otherwise move at random
+PlayerCommand rolloutCommand(const GameState& state, Rng& rng);
+
+// Command of a simple scripted player: like the rollout policy, but
+// it fights monsters next to it, wields its best weapon and walks
+// the shortest way to the stair or idol. Cheap enough to play whole
+// games for statistics.
+PlayerCommand seekerCommand(const GameState& state, Rng& rng);
+
+////////////////////////////////////////////////////////////////////
+// MctsPlayer Class Declaration
+//
+// Picks the player's commands with Monte Carlo tree search. Every
+// rollout starts from a copy of the game state with a freshly seeded
+// random number generator, so the search plays against the odds of
+// the game rather than its actual future (open loop search over
+// command sequences).
+//
+// Root parallelism: each thread grows its own tree from the same
+// state, and the visit counts of the first commands are added up
+// at the end. A decision stops at whichever budget (rollouts or
+// time) runs out first.
+////////////////////////////////////////////////////////////////////
+
+struct MctsOptions
+{
+	int numThreads = 1;        // Threads with a tree each
+	int maxRollouts = 2000;    // Rollouts per decision, all threads (0: no limit)
+	double maxSeconds = 0.05;  // Time per decision (0: no limit)
+	int treeDepth = 8;         // Deepest command in the trees
+	int rolloutDepth = 24;     // Turns played at random after the tree
+	double exploration = 0.7;  // UCT exploration constant
+};
+
+class MctsPlayer
+{
+  public:
+	/////////////////////////////////////////////////////////////////
+	// Constructor
+	MctsPlayer(const MctsOptions& options = MctsOptions(), uint64_t seed = 1);
+
+	/////////////////////////////////////////////////////////////////
+	// Accessors
+	const MctsOptions& options() const {return m_options;}
+	int lastRollouts() const {return m_lastRollouts;} // Of the last decision
+
+	/////////////////////////////////////////////////////////////////
+	// Search Functions
+
+	// Best command for the player in state
+	PlayerCommand decide(const GameState& state);
+
+	// Value of a state from 0 (dead) to 1 (won), judging progress
+	// towards the idol and the player's health
+	static double evaluate(const GameState& state);
+
+  private:
+	/////////////////////////////////////////////////////////////////
+
+	MctsOptions m_options;
+	Rng m_rng;           // Seeds of the searches
+	int m_lastRollouts;
+
+	/////////////////////////////////////////////////////////////////
+};
+
+#endif // MCTSPLAYER_INCLUDED
@@ -7,9 +7,20 @@
 
 #include "Dungeon.h"
 #include "Actor.h"
+#include "Player.h"
 
-class Weapon;
 class GameObject;
+class DistanceTable;
+
+// Kinds of monsters
+enum MonsterKind
+{
+	GOBLIN, SNAKEWOMAN, BOGEYMAN, DRAGON,
+	NUMMONSTERKINDS
+};
+
+const int SNKWSMELLDIST = 3; // Snakewoman smell distance
+const int BGYSMELLDIST = 5;  // Bogeyman smell distance
 
 ////////////////////////////////////////////////////////////////////
 // Base Monster Class Declarations
@@ -20,35 +31,63 @@ class Monster : public Actor
   public:
   	/////////////////////////////////////////////////////////////////
 	// Constructor and Destructor
-	Monster(int row, int col, Dungeon* dungeon, int hitPts,  
-		int armorPts, int strengthPts, int dexterityPts, 
-		int sleepPts, Weapon* weapon)
-		: Actor(row, col, dungeon, hitPts, armorPts, strengthPts, 
-				dexterityPts, sleepPts, weapon)
-	{}
+	// Stats and weapon come from the definitions of kind
+	// (Definitions.h), random stats drawn from the dungeon's rng
+	Monster(int row, int col, Dungeon* dungeon, MonsterKind kind);
 
 	virtual ~Monster() {}
 
+	/////////////////////////////////////////////////////////////////
+	// Accessors
+	MonsterKind kind() const {return m_kind;}
+	// Hit points the monster spawned with, which healing stops at
+	int maxHitPts() const {return m_maxHit;}
+	void setMaxHitPts(int maxHitPts) {m_maxHit = maxHitPts; rekey();}
+	// Handle of the monster in its Dungeon, set by the Dungeon as the
+	// monster is put on it
+	virtual SlotHandle handle() const {return m_handle;}
+	void setHandle(SlotHandle handle) {m_handle = handle;}
+
+	// Name and symbol (from the definitions of the kind)
+	virtual std::string name() const;
+	virtual char symbol() const;
+
 	/////////////////////////////////////////////////////////////////
 	// Game Functions
 
 	// Monsters may drop an object when they die
-	virtual GameObject* dropDead() = 0;
-	// Move the monsters on the dungeon
-	virtual void move() = 0;
+	GameObject* dropDead();
+	// Move the monster on the dungeon, going after target (the
+	// nearest player). The kinds are a closed set, so the move of the
+	// kind is picked by kind() rather than through a virtual call.
+	void move(const Actor* target);
 	
 	/////////////////////////////////////////////////////////////////
 	// Helper Functions
 
-	// Returns ideal shortest no. of steps from the monster to the player
-	int idealShortestDistToPlayer() const; 
-	// Moves monster closer to Player if possible and player in 
+	// Returns ideal shortest no. of steps from the monster to target
+	int idealShortestDistTo(const Actor* target) const; 
+	// Moves monster closer to target if possible and target in 
 	// smellDist range
-	void dumbSmellMove(int smellDist);
+	void dumbSmellMove(int smellDist, const Actor* target);
+
+  protected:
+	// Key of the monster, its changes passed on to the key of the
+	// Dungeon while it is on it (see Actor.h)
+	virtual uint64_t workOutKey() const;
+	virtual void keyChanged(uint64_t change);
+
+  private:
+	MonsterKind m_kind; // Kind of monster
+	int m_maxHit;       // Hit points at spawn
+	SlotHandle m_handle;
 };
 
 ////////////////////////////////////////////////////////////////////
 // Derived Monster Classes Declarations
+//
+// Each kind names its MonsterKind and whether it moves at all, for
+// code handling the monsters of one kind together (see Dungeon.cpp)
 ////////////////////////////////////////////////////////////////////
 
 ////////////////////////////////////////////////////////////////////
@@ -59,19 +98,20 @@ class Goblin : public Monster
   public:
 	Goblin(int row, int col, Dungeon* dungeon, int smellDist);
 
-	// Name and symbol
-	virtual std::string name() const {return "the Goblin";}
-	virtual char symbol() const      {return 'G';}
+	static const MonsterKind KIND = GOBLIN;
+	static const bool MOVES = true;
 
 	// Game Functions
-	virtual GameObject* dropDead();
-	virtual void move();
+	void move(const Actor* target);
 
   private:
 	int m_smellDist;
+	const Actor* m_target; // Player chased by the move under way
+	const DistanceTable* m_distances; // The level's, if it is ready
 	
 	// Helper structures
-	int m_helperGrid[MAXROWS][MAXCOLS];
+	int m_helperGrid[MAXROWS][MAXCOLS]; // Path lengths from the player
+	                                    // (UNREACHED, BLOCKED: Rules.h)
 	struct Point
 	{
 		int r,c; // Coordinates of point
@@ -84,20 +124,20 @@ class Goblin : public Monster
 	// Helper Functions
 	void initializeHelperGrid();
 	Point dirToNewPoint(int dir, Point start);
-	int ptIdealDistToPlayer(const Point& p);
-	
-	// Recursive Shortest Path Function
-	int shortestPathFrom(Point start, int maxSteps);
+	int ptIdealDistToTarget(const Point& p);
+	// Fewest steps around walls from one point to another (exact
+	// with a distance table, else a lower bound from the room graph)
+	int ptStepsTo(const Point& from, const Point& to);
 };
 
 //  Inline implementations
 inline
-int Goblin::ptIdealDistToPlayer(const Point& p)
-	// Gives ideal distance of p from the player
+int Goblin::ptIdealDistToTarget(const Point& p)
+	// Gives ideal distance of p from the player chased
 	// Ignoring walls and other monsters
 {
-	return ( abs(p.r - dungeon()->player()->row())
-			+abs(p.c - dungeon()->player()->col()) );
+	return ( abs(p.r - m_target->row())
+			+abs(p.c - m_target->col()) );
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -107,14 +147,9 @@ class Dragon : public Monster
 {
   public:
 	Dragon(int row, int col, Dungeon* dungeon);
-	
-	// Name and symbol
-	virtual std::string name() const {return "the Dragon";}
-	virtual char symbol() const      {return 'D';}
 
-	// Game Functions
-	virtual GameObject* dropDead();
-	virtual void move() {} // Dragon does not move
+	static const MonsterKind KIND = DRAGON;
+	static const bool MOVES = false; // Dragon does not move
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -125,13 +160,11 @@ class Snakewoman : public Monster
   public:
 	Snakewoman(int row, int col, Dungeon* dungeon);
 
-	// Name and symbol
-	virtual std::string name() const {return "the Snakewoman";}
-	virtual char symbol() const      {return 'S';}
+	static const MonsterKind KIND = SNAKEWOMAN;
+	static const bool MOVES = true;
 
 	// Game Functions
-	virtual GameObject* dropDead();
-	virtual void move();
+	void move(const Actor* target);
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -142,13 +175,26 @@ class Bogeyman: public Monster
   public:
 	Bogeyman(int row, int col, Dungeon* dungeon);
 
-	// Name and symbol
-	virtual std::string name() const {return "the Bogeyman";}
-	virtual char symbol() const      {return 'B';}
+	static const MonsterKind KIND = BOGEYMAN;
+	static const bool MOVES = true;
 
 	// Game Functions
-	virtual GameObject* dropDead();
-	virtual void move();
+	void move(const Actor* target);
 };
 
+/////////////////////////////////////////////////////////////////////
+// Inline Implementations
+
+inline
+void Monster::move(const Actor* target)
+{
+	switch(m_kind)
+	{
+		case GOBLIN:     static_cast<Goblin*>(this)->move(target); break;
+		case SNAKEWOMAN: static_cast<Snakewoman*>(this)->move(target); break;
+		case BOGEYMAN:   static_cast<Bogeyman*>(this)->move(target); break;
+		default: break; // Dragons don't move
+	}
+}
+
 #endif // MONSTER_INCLUDED
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+
+#include "OutcomeStats.h"
+
+using namespace std;
+
+static const char STATSMAGIC[8] = {'M', 'R', 'S', 'T', 'A', 'T', 'S', '1'};
+
+static const char* const MONSTERKINDNAMES[NUMMONSTERKINDS] =
+	{"Goblin", "Snakewoman", "Bogeyman", "Dragon"};
+
+// Width of the sketch buckets, as a factor
+static const double SKETCHGAMMA = (1 + SKETCHACCURACY) / (1 - SKETCHACCURACY);
+static const double LOGGAMMA = log(SKETCHGAMMA);
+
+////////////////////////////////////////////////////////////////////
+// QuantileSketch Class Implementation
+////////////////////////////////////////////////////////////////////
+
+QuantileSketch::QuantileSketch()
+	: m_count(0), m_zeros(0), m_sum(0), m_min(0), m_max(0)
+{
+	memset(m_buckets, 0, sizeof(m_buckets));
+}
+
+void QuantileSketch::add(double value)
+{
+	if(value < 0) value = 0;
+	if(m_count == 0 || value < m_min) m_min = value;
+	if(m_count == 0 || value > m_max) m_max = value;
+	m_count++;
+	m_sum += value;
+
+	if(value < 1)
+	{
+		m_zeros++;
+		return;
+	}
+	// Bucket i holds values from gamma^(i-1) up to gamma^i
+	int bucket = int(ceil(log(value) / LOGGAMMA));
+	if(bucket >= SKETCHBUCKETS) bucket = SKETCHBUCKETS - 1;
+	m_buckets[bucket]++;
+}
+
+void QuantileSketch::merge(const QuantileSketch& other)
+{
+	if(other.m_count == 0) return;
+	if(m_count == 0 || other.m_min < m_min) m_min = other.m_min;
+	if(m_count == 0 || other.m_max > m_max) m_max = other.m_max;
+	m_count += other.m_count;
+	m_zeros += other.m_zeros;
+	m_sum += other.m_sum;
+	for(int b = 0; b < SKETCHBUCKETS; b++)
+		m_buckets[b] += other.m_buckets[b];
+}
+
+double QuantileSketch::quantile(double q) const
+{
+	if(m_count == 0) return 0;
+	if(q <= 0) return m_min;
+	if(q >= 1) return m_max;
+
+	// Rank of the value wanted, then the bucket holding it
+	uint64_t rank = uint64_t(q * (m_count - 1));
+	if(rank < m_zeros) return m_min;
+	uint64_t seen = m_zeros;
+	for(int b = 0; b < SKETCHBUCKETS; b++)
+	{
+		seen += m_buckets[b];
+		if(seen > rank)
+		{
+			// Middle of the bucket (in relative terms), kept within
+			// the values actually seen (bucket 0 only holds 1)
+			double value = (b == 0) ? 1 : 2 * pow(SKETCHGAMMA, b) / (SKETCHGAMMA + 1);
+			return (value < m_min) ? m_min : (value > m_max) ? m_max : value;
+		}
+	}
+	return m_max;
+}
+
+////////////////////////////////////////////////////////////////////
+// OutcomeStats Implementation
+////////////////////////////////////////////////////////////////////
+
+OutcomeStats::OutcomeStats()
+	: games(0), won(0), dead(0), itemsCollected(0)
+{
+	for(int k = 0; k < NUMMONSTERKINDS; k++)
+		deaths[k] = 0;
+	for(int k = 0; k < NUMWEAPONKINDS; k++)
+		damageDealt[k] = 0;
+}
+
+void OutcomeStats::add(const GameOutcome& outcome)
+{
+	games++;
+	if(outcome.won)
+	{
+		won++;
+		turnsToWin.add(outcome.turns);
+	}
+	if(outcome.dead)
+	{
+		dead++;
+		if(outcome.killedBy >= 0 && outcome.killedBy < NUMMONSTERKINDS)
+			deaths[outcome.killedBy]++;
+		turnsToDeath.add(outcome.turns);
+	}
+	for(int k = 0; k < NUMWEAPONKINDS; k++)
+		damageDealt[k] += outcome.damageDealt[k];
+	itemsCollected += outcome.itemsCollected;
+	depthReached.add(outcome.depth);
+}
+
+void OutcomeStats::merge(const OutcomeStats& other)
+{
+	games += other.games;
+	won += other.won;
+	dead += other.dead;
+	for(int k = 0; k < NUMMONSTERKINDS; k++)
+		deaths[k] += other.deaths[k];
+	for(int k = 0; k < NUMWEAPONKINDS; k++)
+		damageDealt[k] += other.damageDealt[k];
+	itemsCollected += other.itemsCollected;
+	turnsToDeath.merge(other.turnsToDeath);
+	turnsToWin.merge(other.turnsToWin);
+	depthReached.merge(other.depthReached);
+}
+
+static void printSketch(ostream& out, const char* name, const QuantileSketch& sketch)
+{
+	out << "  " << left << setw(16) << name << right << setw(10) << sketch.count()
+		<< setw(10) << sketch.mean();
+	const double QUANTILES[] = {0.5, 0.9, 0.99};
+	for(double q : QUANTILES)
+		out << setw(10) << sketch.quantile(q);
+	out << setw(10) << sketch.max() << '\n';
+}
+
+void OutcomeStats::print(ostream& out) const
+{
+	out << fixed << setprecision(1);
+	out << games << " games: " << won << " won (" << 100 * winRate() << "%), "
+		<< dead << " died, " << games - won - dead << " unfinished\n";
+
+	out << "Deaths by monster:";
+	for(int k = 0; k < NUMMONSTERKINDS; k++)
+		out << "  " << MONSTERKINDNAMES[k] << " " << deaths[k];
+	out << '\n';
+
+	out << "Damage dealt by weapon:";
+	for(int k = 0; k < NUMWEAPONKINDS; k++)
+		out << "  " << makeWeapon(WeaponKind(k)).name() << " " << damageDealt[k];
+	out << '\n';
+
+	out << "Items collected: " << itemsCollected;
+	if(games > 0)
+		out << " (" << double(itemsCollected) / games << " per game)";
+	out << '\n';
+
+	out << "                      count      mean       p50       p90       p99       max\n";
+	printSketch(out, "turns to death", turnsToDeath);
+	printSketch(out, "turns to win", turnsToWin);
+	printSketch(out, "depth reached", depthReached);
+	out << defaultfloat << setprecision(6);
+}
+
+bool OutcomeStats::save(const string& path) const
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if(!file) return false;
+	uint32_t bytes = sizeof(OutcomeStats);
+	bool ok = fwrite(STATSMAGIC, sizeof(STATSMAGIC), 1, file) == 1
+		&& fwrite(&bytes, sizeof(bytes), 1, file) == 1
+		&& fwrite(this, sizeof(OutcomeStats), 1, file) == 1;
+	return fclose(file) == 0 && ok;
+}
+
+bool OutcomeStats::load(const string& path)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if(!file) return false;
+	char magic[8];
+	uint32_t bytes;
+	OutcomeStats loaded;
+	bool ok = fread(magic, sizeof(magic), 1, file) == 1
+		&& memcmp(magic, STATSMAGIC, sizeof(magic)) == 0
+		&& fread(&bytes, sizeof(bytes), 1, file) == 1 && bytes == sizeof(OutcomeStats)
+		&& fread(&loaded, sizeof(OutcomeStats), 1, file) == 1;
+	fclose(file);
+	if(ok) *this = loaded;
+	return ok;
+}
+
+void wilsonInterval(uint64_t successes, uint64_t trials, double z,
+	double& low, double& high)
+{
+	if(trials == 0)
+	{
+		low = 0;
+		high = 1;
+		return;
+	}
+	double n = double(trials);
+	double p = successes / n;
+	double z2 = z * z;
+	double center = (p + z2 / (2 * n)) / (1 + z2 / n);
+	double spread = z * sqrt(p * (1 - p) / n + z2 / (4 * n * n)) / (1 + z2 / n);
+	low = (center - spread < 0) ? 0 : center - spread;
+	high = (center + spread > 1) ? 1 : center + spread;
+}
+
+////////////////////////////////////////////////////////////////////
+// LiveStats Class Implementation
+////////////////////////////////////////////////////////////////////
+
+void LiveStats::merge(const OutcomeStats& stats)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_stats.merge(stats);
+}
+
+OutcomeStats LiveStats::snapshot() const
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_stats;
+}
@@ -0,0 +1,117 @@
+// OutcomeStats.h
+
+#ifndef OUTCOMESTATS_INCLUDED
+#define OUTCOMESTATS_INCLUDED
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <mutex>
+#include <type_traits>
+
+#include "Game.h"
+#include "Monster.h"
+#include "Item.h"
+
+const double SKETCHACCURACY = 0.01; // Relative error of sketch quantiles
+const int SKETCHBUCKETS = 1100;     // Enough for values up to about 10^9
+
+////////////////////////////////////////////////////////////////////
+// Quantile Sketch
+//
+// Approximate quantiles of a stream of non-negative values in fixed
+// memory. Values go into logarithmic buckets a factor of
+// (1 + a)/(1 - a) wide (a = SKETCHACCURACY), so a quantile comes back
+// within a relative error of a. Sketches of separate streams merge
+// exactly by adding up their buckets.
+////////////////////////////////////////////////////////////////////
+
+class QuantileSketch
+{
+  public:
+	QuantileSketch();
+
+	void add(double value);
+	void merge(const QuantileSketch& other);
+
+	uint64_t count() const {return m_count;}
+	double min() const {return m_min;}
+	double max() const {return m_max;}
+	double mean() const {return m_count ? m_sum / m_count : 0;}
+
+	// Value with a fraction q (0 to 1) of the stream at or below it
+	// (0 if the stream is empty)
+	double quantile(double q) const;
+
+  private:
+	uint64_t m_count;
+	uint64_t m_zeros;   // Values below 1 are counted as zeros
+	double m_sum, m_min, m_max;
+	uint64_t m_buckets[SKETCHBUCKETS];
+};
+
+////////////////////////////////////////////////////////////////////
+// Outcome Statistics
+//
+// Running totals of many game outcomes: counters and quantile
+// sketches only, so the memory used never grows with the number of
+// games. Statistics of separate runs (threads or processes) merge
+// into the statistics of the combined run. Plain bytes, so they can
+// be saved to a file and merged later.
+////////////////////////////////////////////////////////////////////
+
+struct OutcomeStats
+{
+	uint64_t games;
+	uint64_t won;                           // Idol picked up
+	uint64_t dead;
+	uint64_t deaths[NUMMONSTERKINDS];       // Deaths by the kind of monster
+	uint64_t damageDealt[NUMWEAPONKINDS];   // By the player, per weapon kind
+	uint64_t itemsCollected;
+	QuantileSketch turnsToDeath;            // Of games lost
+	QuantileSketch turnsToWin;              // Of games won
+	QuantileSketch depthReached;            // Of all games
+
+	OutcomeStats();
+
+	void add(const GameOutcome& outcome);
+	void merge(const OutcomeStats& other);
+
+	double winRate() const {return games ? double(won) / games : 0;}
+
+	// Print a table of the statistics
+	void print(std::ostream& out) const;
+
+	// Save to (load from) a file, false on failure
+	bool save(const std::string& path) const;
+	bool load(const std::string& path);
+};
+
+static_assert(std::is_trivially_copyable<OutcomeStats>::value,
+	"OutcomeStats must be saved as plain bytes");
+
+// Wilson score interval of a rate seen as successes out of trials, z
+// standard deviations wide (1.96 for 95%); 0 to 1 if there are none
+void wilsonInterval(uint64_t successes, uint64_t trials, double z,
+	double& low, double& high);
+
+////////////////////////////////////////////////////////////////////
+// Live Statistics
+//
+// Statistics shared by the threads of a run. Threads add outcomes
+// to statistics of their own and merge them in now and then, and
+// the totals can be read at any time while the run goes on.
+////////////////////////////////////////////////////////////////////
+
+class LiveStats
+{
+  public:
+	void merge(const OutcomeStats& stats);
+	OutcomeStats snapshot() const;
+
+  private:
+	mutable std::mutex m_mutex;
+	OutcomeStats m_stats;
+};
+
+#endif // OUTCOMESTATS_INCLUDED
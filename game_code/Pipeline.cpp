@@ -0,0 +1,163 @@
+#include <iostream>
+
+#include "Pipeline.h"
+#include "utilities.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////
+// TerminalKeySource Class Implementation
+////////////////////////////////////////////////////////////////////
+
+char TerminalKeySource::read(TimePoint& pressed)
+{
+	// Reading cin flushes cout first while they are tied, which would
+	// race with the render thread writing to it
+	static bool untied = (cin.tie(nullptr), true);
+	(void)untied;
+
+	char key = getCharacter();
+	pressed = chrono::steady_clock::now();
+	return key;
+}
+
+////////////////////////////////////////////////////////////////////
+// InputReader Class Implementation
+////////////////////////////////////////////////////////////////////
+
+InputReader::InputReader(KeySource& source, bool threaded)
+	: m_shared(new Shared), m_threaded(threaded)
+{
+	m_shared->source = &source;
+	m_shared->stopping = false;
+	if(threaded)
+		m_reader = thread(readLoop, m_shared);
+}
+
+InputReader::~InputReader()
+{
+	if(!m_threaded) return;
+	m_shared->stopping = true;
+	if(m_shared->source->blocks())
+		m_reader.detach(); // Keeps the shared part alive as long as it runs
+	else
+		m_reader.join();
+}
+
+KeyEvent InputReader::next()
+{
+	KeyEvent event;
+	if(!m_threaded)
+	{
+		event.key = m_shared->source->read(event.pressed);
+		return event;
+	}
+	while(!m_shared->keys.pop(event))
+		this_thread::sleep_for(chrono::microseconds(POLLMICROSECONDS));
+	return event;
+}
+
+bool InputReader::poll(KeyEvent& event)
+{
+	if(!m_threaded)
+	{
+		event = next();
+		return true;
+	}
+	return m_shared->keys.pop(event);
+}
+
+void InputReader::readLoop(shared_ptr<Shared> shared)
+{
+	while(!shared->stopping)
+	{
+		KeyEvent event;
+		event.key = shared->source->read(event.pressed);
+		// Holding on to the key until the game makes room
+		while(!shared->keys.push(event) && !shared->stopping)
+			this_thread::sleep_for(chrono::microseconds(POLLMICROSECONDS));
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+// SnapshotHandoff Class Implementation
+////////////////////////////////////////////////////////////////////
+
+void SnapshotHandoff::publish(const TurnSnapshot& snapshot)
+{
+	m_buffers[m_back] = snapshot;
+	m_back = m_middle.exchange(m_back | FRESH, memory_order_acq_rel) & ~FRESH;
+}
+
+const TurnSnapshot* SnapshotHandoff::takeLatest()
+{
+	if(!(m_middle.load(memory_order_acquire) & FRESH))
+		return nullptr;
+	m_front = m_middle.exchange(m_front, memory_order_acq_rel) & ~FRESH;
+	return &m_buffers[m_front];
+}
+
+////////////////////////////////////////////////////////////////////
+// Renderer Class Implementation
+////////////////////////////////////////////////////////////////////
+
+Renderer::Renderer(FrameSink& sink, bool threaded)
+	: m_sink(sink), m_threaded(threaded), m_stopping(false),
+	  m_published(0), m_shown(0)
+{
+	if(threaded)
+		m_renderer = thread(&Renderer::renderLoop, this);
+}
+
+Renderer::~Renderer()
+{
+	finish();
+}
+
+void Renderer::show(TurnSnapshot& snapshot)
+{
+	snapshot.sequence = m_published++;
+	if(m_threaded)
+		m_handoff.publish(snapshot);
+	else
+		write(snapshot);
+}
+
+void Renderer::finish()
+{
+	if(!m_threaded || !m_renderer.joinable()) return;
+	m_stopping = true;
+	m_renderer.join();
+}
+
+void Renderer::renderLoop()
+{
+	for(;;)
+	{
+		// Looking at the stop flag first, so a snapshot published
+		// before it was set is still shown
+		bool stopping = m_stopping.load();
+		const TurnSnapshot* snapshot = m_handoff.takeLatest();
+		if(snapshot)
+			write(*snapshot);
+		else if(stopping)
+			return;
+		else
+			this_thread::sleep_for(chrono::microseconds(POLLMICROSECONDS));
+	}
+}
+
+void Renderer::write(const TurnSnapshot& snapshot)
+{
+	if(snapshot.showInventory)
+		m_sink.writeInventory(snapshot.inventory);
+	else
+		m_sink.write(snapshot.frame);
+	m_shown++;
+
+	if(snapshot.fromKey)
+	{
+		chrono::duration<double, micro> elapsed = chrono::steady_clock::now() - snapshot.pressed;
+		m_latency.add(elapsed.count());
+	}
+}
@@ -0,0 +1,261 @@
+// Pipeline.h
+
+#ifndef PIPELINE_INCLUDED
+#define PIPELINE_INCLUDED
+
+#include <cstddef>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <memory>
+
+#include "Spectator.h"
+#include "Inventory.h"
+#include "OutcomeStats.h"
+
+const int KEYQUEUESIZE = 256; // Keys read ahead of the game
+const int POLLMICROSECONDS = 100; // Wait between looks at an empty queue
+
+////////////////////////////////////////////////////////////////////
+// Play Pipeline
+//
+// Interactive play split over three threads, so that a slow
+// terminal never holds up reading keys or playing turns:
+//
+//   input thread   reads keys into a queue as they are pressed
+//   game thread    plays a turn per key and publishes a snapshot
+//   render thread  writes the newest snapshot to a FrameSink
+//
+// The two handoffs are lock-free. Keys go through a single producer
+// single consumer ring (SpscQueue), in order, none dropped. Snapshots
+// go through a triple buffer (SnapshotHandoff): the game never waits
+// for the screen, and when turns come faster than the screen can
+// show them, the render thread skips straight to the newest.
+//
+// Every key is stamped with when it was pressed, and the snapshot
+// of the turn it played carries the stamp, so the render thread
+// knows how long each frame shown took from key to screen.
+//
+// Both ends can also run on the game thread (threaded = false), the
+// way the game was first played, for comparison.
+////////////////////////////////////////////////////////////////////
+
+typedef std::chrono::steady_clock::time_point TimePoint;
+
+////////////////////////////////////////////////////////////////////
+// SpscQueue Class Template
+//
+// Fixed size ring of CAPACITY items between exactly one producer
+// thread and one consumer thread. Each side keeps a copy of the
+// other's index and only reloads it when the ring looks full (or
+// empty), so the two rarely touch the same cache line.
+////////////////////////////////////////////////////////////////////
+
+template<typename T, int CAPACITY>
+class SpscQueue
+{
+  public:
+	SpscQueue() : m_head(0), m_tailSeen(0), m_tail(0), m_headSeen(0) {}
+
+	// Producer: add item, false if the queue is full
+	bool push(const T& item);
+	// Consumer: take the oldest item, false if the queue is empty
+	bool pop(T& item);
+
+  private:
+	// Consumer's side
+	alignas(64) std::atomic<size_t> m_head;
+	size_t m_tailSeen;
+	// Producer's side
+	alignas(64) std::atomic<size_t> m_tail;
+	size_t m_headSeen;
+
+	alignas(64) T m_items[CAPACITY];
+};
+
+////////////////////////////////////////////////////////////////////
+// Keys
+////////////////////////////////////////////////////////////////////
+
+struct KeyEvent
+{
+	char key;
+	TimePoint pressed;
+};
+
+// Where keys come from
+class KeySource
+{
+  public:
+	virtual ~KeySource() {}
+	// Wait for the next key, setting when it was pressed
+	virtual char read(TimePoint& pressed) = 0;
+	// read can wait forever (so a thread reading it can't be joined)
+	virtual bool blocks() const {return false;}
+};
+
+// The keyboard, through getCharacter
+class TerminalKeySource : public KeySource
+{
+  public:
+	virtual char read(TimePoint& pressed);
+	virtual bool blocks() const {return true;}
+};
+
+////////////////////////////////////////////////////////////////////
+// InputReader Class Declaration
+//
+// Reads keys from a KeySource on a thread of its own (or, not
+// threaded, when asked). A thread reading a source that blocks can't
+// be stopped, so it is left to end with the next key or the process.
+////////////////////////////////////////////////////////////////////
+
+class InputReader
+{
+  public:
+	InputReader(KeySource& source, bool threaded = true);
+	~InputReader();
+
+	// Wait for the next key
+	KeyEvent next();
+	// Take the next key if one was pressed, without waiting (a reader
+	// that isn't threaded can only wait for it)
+	bool poll(KeyEvent& event);
+
+  private:
+	// Shared with the thread, which may outlive the reader
+	struct Shared
+	{
+		KeySource* source;
+		SpscQueue<KeyEvent, KEYQUEUESIZE> keys;
+		std::atomic<bool> stopping;
+	};
+
+	std::shared_ptr<Shared> m_shared;
+	bool m_threaded;
+	std::thread m_reader;
+
+	static void readLoop(std::shared_ptr<Shared> shared);
+
+	// Readers own a thread, so they are not copied
+	InputReader(const InputReader&);
+	InputReader& operator=(const InputReader&);
+};
+
+////////////////////////////////////////////////////////////////////
+// Snapshots
+////////////////////////////////////////////////////////////////////
+
+// What the screen shows after a turn (or a look at the inventory),
+// never changed once published
+struct TurnSnapshot
+{
+	int sequence;          // Snapshots published before this one
+	bool showInventory;    // Inventory instead of the level
+	Frame frame;
+	Inventory inventory;
+	bool fromKey;          // Produced by a key (not the first screen)
+	TimePoint pressed;     // When that key was pressed
+};
+
+// Triple buffer: the newest snapshot published is always waiting
+// in the middle buffer, swapped with the writer's or the reader's
+// buffer by one atomic exchange
+class SnapshotHandoff
+{
+  public:
+	SnapshotHandoff() : m_middle(1), m_back(0), m_front(2) {}
+
+	// Writer: publish snapshot (replacing one not taken yet)
+	void publish(const TurnSnapshot& snapshot);
+	// Reader: the newest snapshot if one was published since the last
+	// call (valid until the next call), nullptr otherwise
+	const TurnSnapshot* takeLatest();
+
+  private:
+	static const int FRESH = 4; // In m_middle: not taken yet
+
+	TurnSnapshot m_buffers[3];
+	std::atomic<int> m_middle; // Index of the middle buffer, FRESH bit
+	int m_back;                // Writer's buffer
+	int m_front;               // Reader's buffer
+};
+
+////////////////////////////////////////////////////////////////////
+// Renderer Class Declaration
+//
+// Writes snapshots to a FrameSink on a thread of its own (or, not
+// threaded, as soon as they are shown), timing each frame from key
+// to screen.
+////////////////////////////////////////////////////////////////////
+
+class Renderer
+{
+  public:
+	// sink is owned by the caller
+	Renderer(FrameSink& sink, bool threaded = true);
+	~Renderer(); // finish()
+
+	// Show snapshot (its sequence is set here)
+	void show(TurnSnapshot& snapshot);
+	// Show the last snapshot if it isn't yet and stop the thread
+	void finish();
+
+	// Key to screen times of the frames shown, in microseconds, and
+	// the counts (valid after finish)
+	const QuantileSketch& latency() const {return m_latency;}
+	int framesShown() const {return m_shown;}
+	int framesSkipped() const {return m_published - m_shown;}
+
+  private:
+	FrameSink& m_sink;
+	bool m_threaded;
+	SnapshotHandoff m_handoff;
+	std::atomic<bool> m_stopping;
+	int m_published;
+	int m_shown;
+	QuantileSketch m_latency;
+	std::thread m_renderer;
+
+	void renderLoop();
+	void write(const TurnSnapshot& snapshot);
+
+	// Renderers own a thread, so they are not copied
+	Renderer(const Renderer&);
+	Renderer& operator=(const Renderer&);
+};
+
+/////////////////////////////////////////////////////////////////////
+// Inline Implementations
+
+template<typename T, int CAPACITY>
+bool SpscQueue<T, CAPACITY>::push(const T& item)
+{
+	size_t tail = m_tail.load(std::memory_order_relaxed);
+	if(tail - m_headSeen == CAPACITY)
+	{
+		m_headSeen = m_head.load(std::memory_order_acquire);
+		if(tail - m_headSeen == CAPACITY)
+			return false;
+	}
+	m_items[tail % CAPACITY] = item;
+	m_tail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+template<typename T, int CAPACITY>
+bool SpscQueue<T, CAPACITY>::pop(T& item)
+{
+	size_t head = m_head.load(std::memory_order_relaxed);
+	if(head == m_tailSeen)
+	{
+		m_tailSeen = m_tail.load(std::memory_order_acquire);
+		if(head == m_tailSeen)
+			return false;
+	}
+	item = m_items[head % CAPACITY];
+	m_head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+#endif // PIPELINE_INCLUDED
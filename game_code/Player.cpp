@@ -1,13 +1,16 @@
 #include <iostream>
 #include <string>
 #include <cstdlib>
-#include <vector>
 
 #include "Player.h"
 #include "Actor.h"
-#include "Scroll.h"
-#include "Weapon.h"
+#include "Item.h"
+#include "GameObject.h"
 #include "Dungeon.h"
+#include "Spectator.h"
+#include "UndoLog.h"
+#include "Rules.h"
+#include "GameState.h"
 #include "utilities.h"
 
 using namespace std;
@@ -17,26 +20,22 @@ using namespace std;
 ////////////////////////////////////////////////////////////////////
 
 /////////////////////////////////////////////////////////////////
-// Constructor and Destructor
+// Constructor
 
 Player::Player()
 	: Actor(0, 0, nullptr/*dungeon*/, BASEHEALTH/*hitPts*/, 
 	2/*armorPts*/, 2/*strengthPts*/, 2/*dexterityPts*/, 
-	0/*sleepPts*/, new ShortSword(0,0, nullptr)/*weapon*/) , 
-	m_maxHit(BASEHEALTH)
+	0/*sleepPts*/, makeWeapon(SHORTSWORD)/*weapon*/) , 
+	m_maxHit(BASEHEALTH), m_killedBy(-1), m_inventoryKey(0)
 {
-	m_inventory.push_back(weapon()); // Placing ShortSword in inventory
+	m_inventory.push(makeItem(weapon())); // Placing ShortSword in inventory
+	inventoryChanged();
 }
 
-Player::~Player()
+void Player::setInventory(const Inventory& inventory)
 {
-	// Loop over the inventory
-	for(int i = 0; i < m_inventory.size(); i++)
-	{
-		//If not weapon(weapon deleted in actor base class destructor)
-		if(m_inventory[i] != weapon()) 
-			delete m_inventory[i]; // Delete the GameObjects
-	}
+	m_inventory = inventory;
+	inventoryChanged();
 }
 
 /////////////////////////////////////////////////////////////////////
@@ -52,36 +51,30 @@ string Player::attemptPickUp(GameObject* object)
 		return "";          // Do Nothing
 	}
 		
-	if(m_inventory.size() == 26)  // If inventory full
+	if(m_inventory.isFull())  // If inventory full
 	{
 		// Don't pick up object
 		return "Your knapsack is full; you can't pick that up.";
 	}
 	
 	// Else pick up object and return string
-	m_inventory.push_back(object); // Placing object in inventory
-	dungeon()->removeObject(object); // Removing object
+	Item item = object->item();
+	if(isLogged()) dungeon()->undoLog()->itemPushed(this);
+	m_inventory.push(item); // Placing a copy of the object in inventory
+	inventoryChanged();
+	dungeon()->removeObject(object->handle()); // Removing (and destroying) object
 	
-	if(object->symbol() == SCROLL)// If object is a scroll
-		return "You pick up a scroll called " + object->name(); 
+	if(item.isScroll())// If object is a scroll
+		return "You pick up a scroll called " + item.name(); 
 	// Else object is a weapon
-	return "You pick up " + object->name(); 
+	return "You pick up " + item.name(); 
 }
 
 void Player::displayInventory() const
 	// Clear screen and display the player's inventory
 {
 	clearScreen();
-	vector<GameObject*>::const_iterator itr = m_inventory.begin();
-	char key = 'a';
-	for(; itr != m_inventory.end(); itr++, key++)
-	{
-		string print = ""; 
-		if((*itr)->symbol() == SCROLL) // If object is scroll
-			print = "A scroll called "; // Add prefix
-			// There is no prefic if object is weapon
-		cout << key << ". " << print + (*itr)->name() << endl;
-	}
+	printInventory(cout, m_inventory);
 }
 
 string Player::attemptReadScroll(char key)
@@ -95,22 +88,21 @@ string Player::attemptReadScroll(char key)
 		return ""; // Do nothing
 
 	// Verify if requested object is scroll
-	Scroll* toRead = dynamic_cast<Scroll*>(m_inventory[sub]);  
-	if(!toRead) // If requested object is not scroll
-		return "You can't read a " + m_inventory[sub]->name(); 
+	if(!m_inventory[sub].isScroll()) // If requested object is not scroll
+		return "You can't read a " + m_inventory[sub].name(); 
 	
 	// Read the scroll
-	toRead->haveEffect(this);
-	string name = toRead->name();
-	string effect = toRead->effect();
-
-	// Remove scroll from vector
-	m_inventory.erase(m_inventory.begin()+sub);
+	ScrollItem toRead = m_inventory[sub].scroll;
+	toRead.haveEffect(this);
 
-	delete toRead; // Destroy scroll
+	// Remove scroll from inventory
+	if(isLogged()) dungeon()->undoLog()->itemErased(this, sub, m_inventory[sub]);
+	m_inventory.erase(sub);
+	inventoryChanged();
 
 	// Return result
-	return "You read the scroll called " + name + "\n" + effect;
+	return "You read the scroll called " + toRead.name() + "\n" 
+		+ toRead.effect();
 }
 
 string Player::attemptWieldWeapon(char key)
@@ -124,13 +116,19 @@ string Player::attemptWieldWeapon(char key)
 		return ""; // Do nothing
 
 	// Verify if requested object is weapon
-	Weapon* toWield = dynamic_cast<Weapon*>(m_inventory[sub]);  
-	if(!toWield) // If requested object is not weapon
-		return "You can't wield " + m_inventory[sub]->name();
+	if(!m_inventory[sub].isWeapon()) // If requested object is not weapon
+		return "You can't wield " + m_inventory[sub].name();
 
-	setWeapon(toWield); // Change player's weapon
+	setWeapon(m_inventory[sub].weapon); // Change player's weapon
 
-	return "You are wielding " + toWield->name();
+	return "You are wielding " + weapon().name();
+}
+
+int Player::keyToSubscript(char key) const
+// Converts a character key into a subscript for player's inventory
+// Returns -1 if invalid key
+{
+	return itemSubscript(m_inventory, key);
 }
 
 void Player::cheat()
@@ -139,4 +137,46 @@ void Player::cheat()
 	if(maxHitPts() < 50) setMaxHitPts(50);
 	if(hitPts() < 50) setHitPts(50);
 	if(strengthPts() < 9) setStrengthPts(9);
-}
\ No newline at end of file
+}
+
+void Player::undo(const UndoRecord& record, UndoLog& log)
+{
+	switch(record.op)
+	{
+		case UndoRecord::ITEMPUSHED:
+			m_inventory.erase(m_inventory.size() - 1);
+			inventoryChanged();
+			break;
+		case UndoRecord::ITEMERASED:
+			m_inventory.insert(record.index, log.popItem());
+			inventoryChanged();
+			break;
+		case UndoRecord::STAT:
+			if(record.stat == STATMAXHIT)
+				m_maxHit = record.a;
+			else if(record.stat == STATKILLEDBY)
+				m_killedBy = record.a;
+			else // The stats every actor has
+				Actor::undo(record, log);
+			rekey();
+			break;
+		default:
+			Actor::undo(record, log);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////
+// Key
+
+uint64_t Player::workOutKey() const
+{
+	ActorState state;
+	captureActor(*this, state);
+	return zobristPlayer(state, m_maxHit) ^ m_inventoryKey;
+}
+
+void Player::inventoryChanged()
+{
+	m_inventoryKey = zobristInventory(m_inventory);
+	rekey();
+}
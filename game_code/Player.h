@@ -4,7 +4,7 @@
 #define PLAYER_INCLUDED
 
 #include "Actor.h"
-#include <vector>
+#include "Inventory.h"
 
 class GameObject;
 
@@ -19,17 +19,21 @@ class Player : public Actor
 {
   public:
   	/////////////////////////////////////////////////////////////////
-	// Constructor and Destructor
+	// Constructor
 	Player();
-	~Player();
 
 	/////////////////////////////////////////////////////////////////
 	// Accessors
 	int maxHitPts() const {return m_maxHit;}
+	// MonsterKind of the monster that killed this player, -1 if none
+	int killedBy() const {return m_killedBy;}
+	const Inventory& inventory() const {return m_inventory;}
 	
 	/////////////////////////////////////////////////////////////////
 	// Setters
 	bool setMaxHitPts(int maxHitPts);
+	void setInventory(const Inventory& inventory);
+	void setKilledBy(int kind);
 
 	// Name and symbol
 	virtual std::string name() const {return "Player";}
@@ -44,15 +48,25 @@ class Player : public Actor
 	std::string attemptReadScroll(char key);// Read scroll 
 	std::string attemptWieldWeapon(char key);// Change Weapon 
 	void cheat(); // Cheat function
+
+	// Take back the change of record (see UndoLog.h)
+	virtual void undo(const UndoRecord& record, UndoLog& log);
+
+  protected:
+	// Key of the player and their inventory (see Actor.h)
+	virtual uint64_t workOutKey() const;
 	
   private:
 	/////////////////////////////////////////////////////////////////
 	
 	int m_maxHit; // Max hit points
-	std::vector<GameObject*> m_inventory;// Inventory 
+	int m_killedBy; // Kind of monster that killed the player
+	Inventory m_inventory; // Inventory (stored by value)
+	uint64_t m_inventoryKey; // Zobrist key of the inventory
 
 	// Helper functions
 	int keyToSubscript(char key) const;
+	void inventoryChanged(); // Keying it again
 
 	/////////////////////////////////////////////////////////////////
 };
@@ -63,23 +77,22 @@ inline
 bool Player::setMaxHitPts(int maxHitPts)
 {
 	if(maxHitPts < 0 || maxHitPts > MAXHIT) return false;
-	m_maxHit = maxHitPts; return true;
+	if(isLogged()) logStat(STATMAXHIT, m_maxHit);
+	m_maxHit = maxHitPts; rekey(); return true;
 }
 
 inline
-void Player::attemptRegainHealth()
-	// If health less than max hit, regain 1 hit point
+void Player::setKilledBy(int kind)
 {
-	if(hitPts() < m_maxHit) setHitPts(hitPts()+1);
+	if(isLogged()) logStat(STATKILLEDBY, m_killedBy);
+	m_killedBy = kind;
 }
 
 inline
-int Player::keyToSubscript(char key) const
-// Converts a character key into a subscript for player's inventory
-// Returns -1 if invalid key
+void Player::attemptRegainHealth()
+	// If health less than max hit, regain 1 hit point
 {
-	int sub =  key - 'a';
-	return (sub < m_inventory.size()) ? sub : -1; 
+	if(hitPts() < m_maxHit) setHitPts(hitPts()+1);
 }
 
 #endif // PLAYER_INCLUDED
\ No newline at end of file
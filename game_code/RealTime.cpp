@@ -0,0 +1,55 @@
+#include <thread>
+
+#include "RealTime.h"
+
+using namespace std;
+
+void TickStats::merge(const TickStats& other)
+{
+	tickMicros.merge(other.tickMicros);
+	ticks += other.ticks;
+	overBudget += other.overBudget;
+	dropped += other.dropped;
+}
+
+////////////////////////////////////////////////////////////////////
+// TickClock Class Implementation
+////////////////////////////////////////////////////////////////////
+
+TickClock::TickClock(int tickMicroseconds)
+	: m_tick(chrono::microseconds(tickMicroseconds)), m_started(false)
+{}
+
+int TickClock::waitForTicks()
+{
+	TimePoint now = chrono::steady_clock::now();
+	if(!m_started)
+	{
+		m_started = true;
+		m_next = now;
+	}
+	if(now < m_next)
+	{
+		this_thread::sleep_until(m_next);
+		now = m_next;
+	}
+
+	// Every tick due by now, the ones beyond catching up dropped
+	int due = int((now - m_next) / m_tick) + 1;
+	if(due > MAXCATCHUPTICKS)
+	{
+		m_stats.dropped += due - MAXCATCHUPTICKS;
+		m_next += (due - MAXCATCHUPTICKS) * m_tick;
+		due = MAXCATCHUPTICKS;
+	}
+	m_next += due * m_tick;
+	return due;
+}
+
+void TickClock::ticked(TimePoint start)
+{
+	chrono::steady_clock::duration elapsed = chrono::steady_clock::now() - start;
+	m_stats.tickMicros.add(chrono::duration<double, micro>(elapsed).count());
+	m_stats.ticks++;
+	if(elapsed > m_tick) m_stats.overBudget++;
+}
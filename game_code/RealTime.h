@@ -0,0 +1,81 @@
+// RealTime.h
+
+#ifndef REALTIME_INCLUDED
+#define REALTIME_INCLUDED
+
+#include <cstdint>
+#include <chrono>
+
+#include "Actor.h"
+#include "Pipeline.h"
+#include "OutcomeStats.h"
+
+const int TICKMICROSECONDS = 25000; // 40 ticks a second
+const int TICKSPERTURN = ACTIONENERGY / NORMALSPEED; // A turn at normal speed
+const int MAXCATCHUPTICKS = 4; // Late ticks run back to back, any more are dropped
+const int MESSAGETICKS = 80; // Ticks a message stays shown (2 seconds) unless replaced
+
+////////////////////////////////////////////////////////////////////
+// Real-Time Games
+//
+// The world goes on without waiting for the player: it advances one
+// tick (Game::tick) every TICKMICROSECONDS, whether a key was pressed
+// or not. Every tick each actor gains its speed (from the
+// definitions) in energy and acts once it has ACTIONENERGY, so a
+// quick snakewoman gets more moves than a lumbering bogeyman, and a
+// player who stands around thinking gets attacked. Every
+// TICKSPERTURN ticks a turn goes by, with the player's chance of
+// healing.
+//
+// Keys are read on a thread of their own and looked at without
+// waiting (InputReader::poll). A key is held until the player has
+// the energy to act on it; keys pressed while the player sleeps are
+// lost, as they are in turn by turn play.
+//
+// The clock is fixed-timestep: ticks are due at fixed times, and a
+// tick that starts late doesn't move the ones after it. When ticks
+// run over budget and fall behind, up to MAXCATCHUPTICKS are run
+// back to back to catch up and any further ones are dropped, so a
+// stall slows the game down for a moment instead of making it jump.
+// Every tick's run time is recorded, along with the ticks over
+// budget and dropped (TickStats).
+////////////////////////////////////////////////////////////////////
+
+// How a real-time clock kept up
+struct TickStats
+{
+	TickStats() : ticks(0), overBudget(0), dropped(0) {}
+
+	QuantileSketch tickMicros; // Run time of every tick
+	uint64_t ticks;            // Ticks run
+	uint64_t overBudget;       // Ticks that took longer than a tick
+	uint64_t dropped;          // Ticks skipped after falling behind
+
+	void merge(const TickStats& other);
+};
+
+////////////////////////////////////////////////////////////////////
+// TickClock Class Declaration
+////////////////////////////////////////////////////////////////////
+
+class TickClock
+{
+  public:
+	TickClock(int tickMicroseconds = TICKMICROSECONDS);
+
+	// Wait until the next tick is due and return how many ticks to
+	// run now (1 to MAXCATCHUPTICKS), dropping any beyond that
+	int waitForTicks();
+	// Record the run time of a tick started at start
+	void ticked(TimePoint start);
+
+	const TickStats& stats() const {return m_stats;}
+
+  private:
+	std::chrono::steady_clock::duration m_tick;
+	TimePoint m_next;  // When the next tick is due
+	bool m_started;
+	TickStats m_stats;
+};
+
+#endif // REALTIME_INCLUDED
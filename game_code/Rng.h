@@ -0,0 +1,110 @@
+// Rng.h
+
+#ifndef RNG_INCLUDED
+#define RNG_INCLUDED
+
+#include <cstdint>
+
+////////////////////////////////////////////////////////////////////
+// Rng Class Declaration
+//
+// Small seedable random number generator (PCG32). Its whole state
+// is one 64 bit integer, so it can be copied, saved and restored
+// along with the rest of a game.
+////////////////////////////////////////////////////////////////////
+
+class Rng
+{
+  public:
+	/////////////////////////////////////////////////////////////////
+	// Constructor
+	explicit Rng(uint64_t seed = 0) {setSeed(seed);}
+
+	/////////////////////////////////////////////////////////////////
+	// State
+	void setSeed(uint64_t seed);
+	uint64_t state() const {return m_state;}
+	void setState(uint64_t state) {m_state = state;}
+
+	/////////////////////////////////////////////////////////////////
+	// Random numbers (same meaning as the ones in utilities.h)
+
+	uint32_t next();                       // random 32 bit integer
+	uint64_t next64();                     // random 64 bit integer
+	int randInt(int lowest, int highest);  // random int from lowest to highest
+	int randInt(int limit);                // random int from 0 to limit-1
+	bool trueWithProbability(double p);    // return true with probability p
+
+  private:
+	/////////////////////////////////////////////////////////////////
+
+	uint64_t m_state;
+
+	/////////////////////////////////////////////////////////////////
+};
+
+// Derive an independent seed from a base seed and an index
+// (used to give every level of a batch its own stream)
+uint64_t mixSeed(uint64_t seed, uint64_t index);
+
+/////////////////////////////////////////////////////////////////////
+// Inline Implementations
+
+inline
+uint64_t mixSeed(uint64_t seed, uint64_t index)
+	// SplitMix64 finalizer over seed and index
+{
+	uint64_t z = seed + (index + 1) * 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+inline
+void Rng::setSeed(uint64_t seed)
+{
+	m_state = mixSeed(seed, 0);
+}
+
+inline
+uint32_t Rng::next()
+{
+	uint64_t old = m_state;
+	m_state = old * 6364136223846793005ULL + 1442695040888963407ULL;
+	uint32_t xorshifted = uint32_t(((old >> 18) ^ old) >> 27);
+	uint32_t rot = uint32_t(old >> 59);
+	return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+inline
+uint64_t Rng::next64()
+{
+	uint64_t high = next(); // Drawing the high half first
+	return high << 32 | next();
+}
+
+inline
+int Rng::randInt(int lowest, int highest)
+{
+	if(highest < lowest)
+	{
+		int temp = highest; highest = lowest; lowest = temp;
+	}
+	// Scale a 32 bit draw to the range (multiply and shift)
+	uint64_t range = uint64_t(int64_t(highest) - lowest + 1);
+	return int(lowest + int64_t((uint64_t(next()) * range) >> 32));
+}
+
+inline
+int Rng::randInt(int limit)
+{
+	return randInt(0, limit-1);
+}
+
+inline
+bool Rng::trueWithProbability(double p)
+{
+	return next() * (1.0/4294967296.0) < p;
+}
+
+#endif // RNG_INCLUDED
@@ -0,0 +1,186 @@
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include "RoomGraph.h"
+
+using namespace std;
+
+static const int DR[4] = {-1, 1, 0, 0};
+static const int DC[4] = {0, 0, -1, 1};
+
+void RoomGraph::build(const Dungeon& dungeon)
+{
+	int rows = dungeon.rows(), cols = dungeon.cols();
+
+	// Room cells: open cells in some open 2 x 2 block
+	bool room[MAXROWS][MAXCOLS] = {};
+	for(int i = 0; i + 1 < rows; i++)
+		for(int j = 0; j + 1 < cols; j++)
+			if(!dungeon.isWall(i, j) && !dungeon.isWall(i + 1, j)
+				&& !dungeon.isWall(i, j + 1) && !dungeon.isWall(i + 1, j + 1))
+				room[i][j] = room[i + 1][j] = room[i][j + 1] = room[i + 1][j + 1] = true;
+
+	// Regions: connected stretches of room cells or of corridor cells
+	memset(m_region, -1, sizeof(m_region));
+	m_isRoom.clear();
+	short queue[MAXROWS * MAXCOLS][2];
+	for(int i = 0; i < rows; i++)
+		for(int j = 0; j < cols; j++)
+		{
+			if(dungeon.isWall(i, j) || m_region[i][j] != -1) continue;
+			int id = m_isRoom.size();
+			m_isRoom.push_back(room[i][j]);
+			int head = 0, tail = 0;
+			m_region[i][j] = id;
+			queue[tail][0] = i;
+			queue[tail++][1] = j;
+			while(head < tail)
+			{
+				int r0 = queue[head][0], c0 = queue[head++][1];
+				for(int d = 0; d < 4; d++)
+				{
+					int r = r0 + DR[d], c = c0 + DC[d];
+					if(dungeon.isWall(r, c) || m_region[r][c] != -1
+						|| room[r][c] != room[i][j])
+						continue;
+					m_region[r][c] = id;
+					queue[tail][0] = r;
+					queue[tail++][1] = c;
+				}
+			}
+		}
+	int numRegions = m_isRoom.size();
+
+	// Portals, numbered region by region
+	bool portal[MAXROWS][MAXCOLS] = {};
+	m_portalStart.assign(numRegions + 1, 0);
+	for(int i = 0; i < rows; i++)
+		for(int j = 0; j < cols; j++)
+			for(int d = 0; d < 4 && m_region[i][j] != -1; d++)
+			{
+				int r = i + DR[d], c = j + DC[d];
+				if(!dungeon.isWall(r, c) && m_region[r][c] != m_region[i][j])
+				{
+					portal[i][j] = true;
+					m_portalStart[m_region[i][j] + 1]++;
+					break;
+				}
+			}
+	for(int k = 0; k < numRegions; k++)
+		m_portalStart[k + 1] += m_portalStart[k];
+	int numPortals = m_portalStart[numRegions];
+	m_portalRow.assign(numPortals, 0);
+	m_portalCol.assign(numPortals, 0);
+	vector<int> next(m_portalStart.begin(), m_portalStart.end() - 1);
+	short portalAt[MAXROWS][MAXCOLS];
+	for(int i = 0; i < rows; i++)
+		for(int j = 0; j < cols; j++)
+			if(portal[i][j])
+			{
+				int p = next[m_region[i][j]]++;
+				m_portalRow[p] = i;
+				m_portalCol[p] = j;
+				portalAt[i][j] = p;
+			}
+
+	// Room for the steps from every cell to the portals of its region
+	int size = 0;
+	for(int i = 0; i < rows; i++)
+		for(int j = 0; j < cols; j++)
+		{
+			m_first[i][j] = size;
+			if(m_region[i][j] != -1)
+				size += m_portalStart[m_region[i][j] + 1] - m_portalStart[m_region[i][j]];
+		}
+	m_toPortal.assign(size, NOPATH);
+
+	// Searching from every portal within its region, for its steps to
+	// the cells of the region
+	short steps[MAXROWS][MAXCOLS];
+	for(int i = 0; i < MAXROWS; i++)
+		for(int j = 0; j < MAXCOLS; j++)
+			steps[i][j] = NOPATH;
+	for(int p = 0; p < numPortals; p++)
+	{
+		int id = m_region[m_portalRow[p]][m_portalCol[p]];
+		int k = p - m_portalStart[id];
+		int head = 0, tail = 0;
+		steps[m_portalRow[p]][m_portalCol[p]] = 0;
+		queue[tail][0] = m_portalRow[p];
+		queue[tail++][1] = m_portalCol[p];
+		while(head < tail)
+		{
+			int r0 = queue[head][0], c0 = queue[head++][1];
+			m_toPortal[m_first[r0][c0] + k] = steps[r0][c0];
+			for(int d = 0; d < 4; d++)
+			{
+				int r = r0 + DR[d], c = c0 + DC[d];
+				if(dungeon.isWall(r, c) || m_region[r][c] != id || steps[r][c] != NOPATH)
+					continue;
+				steps[r][c] = steps[r0][c0] + 1;
+				queue[tail][0] = r;
+				queue[tail++][1] = c;
+			}
+		}
+		// Leaving the cells searched ready for the next search
+		for(int q = 0; q < tail; q++)
+			steps[queue[q][0]][queue[q][1]] = NOPATH;
+	}
+
+	// Steps between portals: across a region as just found, or a step
+	// from a portal to the next region, then the shortest ways over
+	// those (Floyd-Warshall)
+	m_between.assign(numPortals * numPortals, NOPATH);
+	for(int p = 0; p < numPortals; p++)
+	{
+		int row = m_portalRow[p], col = m_portalCol[p];
+		int id = m_region[row][col];
+		short* between = &m_between[p * numPortals];
+		for(int q = m_portalStart[id]; q < m_portalStart[id + 1]; q++)
+			between[q] = m_toPortal[m_first[m_portalRow[q]][m_portalCol[q]] + p - m_portalStart[id]];
+		for(int d = 0; d < 4; d++)
+		{
+			int r = row + DR[d], c = col + DC[d];
+			if(!dungeon.isWall(r, c) && m_region[r][c] != id)
+				between[portalAt[r][c]] = 1;
+		}
+	}
+	for(int k = 0; k < numPortals; k++)
+	{
+		const short* viaK = &m_between[k * numPortals];
+		for(int p = 0; p < numPortals; p++)
+		{
+			short* between = &m_between[p * numPortals];
+			short toK = between[k];
+			if(toK == NOPATH) continue;
+			// (sums with NOPATH stay above it, and fit in a short)
+			for(int q = 0; q < numPortals; q++)
+				between[q] = min(between[q], short(toK + viaK[q]));
+		}
+	}
+}
+
+int RoomGraph::minSteps(int r1, int c1, int r2, int c2) const
+	// Any way from one region to another leaves the first by one of
+	// its portals and last enters the other by one of its portals
+{
+	int from = m_region[r1][c1], to = m_region[r2][c2];
+	if(from == -1 || to == -1) return NOPATH;
+	if(from == to) return abs(r1 - r2) + abs(c1 - c2);
+
+	int numPortals = m_portalRow.size();
+	const short* out = m_toPortal.data() + m_first[r1][c1] - m_portalStart[from];
+	const short* in = m_toPortal.data() + m_first[r2][c2] - m_portalStart[to];
+	int best = NOPATH;
+	for(int p = m_portalStart[from]; p < m_portalStart[from + 1]; p++)
+	{
+		if(out[p] >= best) continue;
+		const short* between = &m_between[p * numPortals];
+		for(int q = m_portalStart[to]; q < m_portalStart[to + 1]; q++)
+			if(between[q] != NOPATH && out[p] + between[q] + in[q] < best)
+				best = out[p] + between[q] + in[q];
+	}
+	return best;
+}
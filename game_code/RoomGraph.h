@@ -0,0 +1,67 @@
+// RoomGraph.h
+
+#ifndef ROOMGRAPH_INCLUDED
+#define ROOMGRAPH_INCLUDED
+
+#include <vector>
+
+#include "Dungeon.h"
+
+const int NOPATH = 9999; // Steps between cells with no way between them
+
+////////////////////////////////////////////////////////////////////
+// Room Graph
+//
+// The rooms of a level and the corridors joining them, for planning
+// long walks room by room instead of cell by cell. The open cells are
+// split into regions: rooms (cells in some open 2 x 2 block, which
+// picks out the rooms the generators carve and the wide parts of
+// caves) and corridors (the one cell wide passages left), each
+// connected stretch of either kind being one region. Portals are the
+// cells of a region next to a cell of another region.
+//
+// When the graph is built, every portal is given its steps to every
+// other portal (around walls only: monsters move out of each other's
+// way) and to every cell of its own region. Steps between cells of
+// different regions are then the best way out of the one region and
+// into the other over the portals, some products of a few portals
+// per room instead of a search over the cells of the level.
+//
+// Terrain never changes on a level, so the graph is built once with
+// the Dungeon, from its terrain alone (levels rebuilt from a game
+// state get the same graph as when they were generated).
+////////////////////////////////////////////////////////////////////
+
+class RoomGraph
+{
+  public:
+	// Work the graph out from the terrain of dungeon
+	void build(const Dungeon& dungeon);
+
+	int numRegions() const {return m_portalStart.size() - 1;}
+	int numPortals() const {return m_portalRow.size();}
+	// Region of (row, col), -1 for walls
+	int region(int row, int col) const {return m_region[row][col];}
+	bool isRoom(int region) const {return m_isRoom[region];}
+
+	// Fewest steps from (r1, c1) to (r2, c2) around walls, NOPATH if
+	// there is no way: exact for cells of different regions, and the
+	// straight (Manhattan) distance within a region, so never more
+	// than the true number of steps
+	int minSteps(int r1, int c1, int r2, int c2) const;
+
+  private:
+	short m_region[MAXROWS][MAXCOLS];
+	// Where the steps from a cell to the portals of its region start
+	// in m_toPortal
+	int m_first[MAXROWS][MAXCOLS];
+
+	std::vector<bool> m_isRoom;         // By region
+	std::vector<int> m_portalStart;     // Portals of region i are
+	                                    // m_portalStart[i] up to i+1
+	std::vector<short> m_portalRow, m_portalCol;
+	std::vector<short> m_toPortal;      // Cell to a portal of its region
+	std::vector<short> m_between;       // Portal p to q at p*numPortals()+q
+};
+
+#endif // ROOMGRAPH_INCLUDED
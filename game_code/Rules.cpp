@@ -0,0 +1,67 @@
+#include "Rules.h"
+#include "Combat.h"
+#include "Definitions.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////
+// Rules Implementation
+////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////
+// Combat
+
+int addAttack(CombatBatch& batch, const ActorState& attacker, const ActorState& defender)
+{
+	return batch.add(attacker.dexterity + attacker.weapon.dexterityBns(),
+		defender.dexterity + defender.armor,
+		attacker.strength + attacker.weapon.damageAmt());
+}
+
+bool landHit(const ActorState& attacker, ActorState& defender, int damage, Rng& rng)
+{
+	if(damage >= 0)
+		defender.hit -= damage;
+	if(defender.hit <= 0)
+		return false; // Final blow
+
+	// Magic fangs of sleep
+	if(attacker.weapon.kind != SLEEPFANGS || !rng.trueWithProbability(1.0/5.0))
+		return false;
+	int newSleepTime = rng.randInt(2, 6);
+	if(newSleepTime <= defender.sleep)
+		return false; // Asleep longer already
+	defender.sleep = newSleepTime;
+	return true;
+}
+
+bool rollDeathDrop(int kind, bool cellFree, Rng& rng, Item& item)
+{
+	if(!rollDropChance(kind, rng) || !cellFree)
+		return false;
+	item = rollDrop(kind, rng);
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////
+// Monsters
+
+MonsterAction planMonster(int sleep, int stepsToTarget, bool moves)
+{
+	if(sleep > 0)
+		return SLEEPING;
+	if(stepsToTarget < 0)
+		return RESTING; // Nobody left to go after
+	if(stepsToTarget == 1)
+		return ATTACKING;
+	return moves ? MOVING : RESTING;
+}
+
+/////////////////////////////////////////////////////////////////
+// Items
+
+int itemSubscript(const Inventory& inventory, char key)
+{
+	int sub = key - 'a';
+	return (sub >= 0 && sub < inventory.size()) ? sub : -1;
+}
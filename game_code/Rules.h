@@ -0,0 +1,234 @@
+// Rules.h
+
+#ifndef RULES_INCLUDED
+#define RULES_INCLUDED
+
+#include <cstdlib>
+#include <algorithm>
+
+#include "GameState.h"
+#include "Actor.h"
+#include "Item.h"
+#include "Inventory.h"
+#include "Rng.h"
+
+class CombatBatch;
+
+////////////////////////////////////////////////////////////////////
+// Rules
+//
+// The rules of play, as free functions over the flat records of
+// GameState.h and plain values, called by both engines: the Game
+// (Dungeon, actors and items) and the GameState it forks. Keeping
+// each rule in one place keeps the two playing alike, random numbers
+// drawn in the same order included. The Game copies an actor to a
+// record, applies the rule and sets back what changed (updateActor).
+//
+// Rules that look at the level take what they need of it as a
+// function: open(row, col), true of a cell the actor can step on.
+////////////////////////////////////////////////////////////////////
+
+// The four steps, tried in this order: UP, DOWN, LEFT, RIGHT
+const int NUMSTEPS = 4;
+const int STEPROW[NUMSTEPS] = {-1, 1, 0, 0};
+const int STEPCOL[NUMSTEPS] = {0, 0, -1, 1};
+
+/////////////////////////////////////////////////////////////////
+// Combat
+
+// Queue an attack by attacker on defender in batch (see Combat.h),
+// returning its index
+int addAttack(CombatBatch& batch, const ActorState& attacker, const ActorState& defender);
+
+// A hit of damage by attacker landing on defender: the damage is
+// dealt and, unless it was the final blow, the weapon's special
+// move follows (magic fangs of sleep put the defender to sleep 1
+// time in 5). Returns whether the defender was put to sleep.
+bool landHit(const ActorState& attacker, ActorState& defender, int damage, Rng& rng);
+
+// A monster of kind dying, on a cell free of objects, the idol and
+// stairs or not: the chance of a drop is drawn either way, then the
+// item if the cell is free. Returns whether it drops item.
+bool rollDeathDrop(int kind, bool cellFree, Rng& rng, Item& item);
+
+/////////////////////////////////////////////////////////////////
+// Monsters
+
+// What a monster does in a turn
+enum MonsterAction {RESTING, SLEEPING, ATTACKING, MOVING};
+
+// A monster with sleep, stepsToTarget (ignoring walls, -1 if nobody
+// is left to go after) from its target, and of a kind that moves or
+// not: sleeps a turn off, attacks the target next to it, moves after
+// it or rests
+MonsterAction planMonster(int sleep, int stepsToTarget, bool moves);
+
+// Smell move: a monster at (row, col) within smellDist steps of the
+// target (ignoring walls) but not next to it steps closer, across
+// if it can, else up or down. Returns whether it moved.
+template<typename Open>
+bool smellStep(int& row, int& col, int targetRow, int targetCol, int smellDist,
+	const Open& open);
+
+// Path lengths of a goblin's search, from the target out
+const int UNREACHED = -1; // Open, not reached (yet)
+const int BLOCKED = -2;   // Wall, monster or other player
+
+// Breadth first search out of the target's cell over dist (cells
+// BLOCKED or UNREACHED), leaving the path length from the target of
+// every cell reached within maxSteps. A cell is only reached if its
+// steps plus the steps from it to the goblin (straight, then around
+// walls as far as stepsToGoblin(row, col), a lower bound, tells) are
+// at most maxSteps + 1: every cell on a shortest path to a step the
+// goblin can take is, so those path lengths are exact.
+template<typename Bound>
+void searchFromTarget(int dist[MAXROWS][MAXCOLS], int rows, int cols,
+	int targetRow, int targetCol, int goblinRow, int goblinCol, int maxSteps,
+	const Bound& stepsToGoblin);
+
+// The step (into STEPROW and STEPCOL) a goblin at (row, col) takes:
+// of those open and closer than smellDist to the target ignoring
+// walls, the first with the shortest path length in dist (searched
+// from the target), -1 if none reaches it
+template<typename Open>
+int goblinStep(const int dist[MAXROWS][MAXCOLS], int row, int col,
+	int targetRow, int targetCol, int smellDist, const Open& open);
+
+/////////////////////////////////////////////////////////////////
+// Items
+
+// Subscript of the item of inventory key picks ('a' the first), -1
+// if none
+int itemSubscript(const Inventory& inventory, char key);
+
+// A random cell (row, col) of a level of rows x cols that is open
+template<typename Open>
+void randomOpenCell(int rows, int cols, const Open& open, Rng& rng, int& row, int& col);
+
+// The effect of a scroll of kind on reader, whose maximum hit points
+// are maxHit: teleportation to a random open cell, or raising a stat
+// up to its maximum
+template<typename Open>
+void readScroll(int kind, ActorState& reader, int& maxHit, int rows, int cols,
+	const Open& open, Rng& rng);
+
+/////////////////////////////////////////////////////////////////////
+// Inline Implementations
+
+template<typename Open>
+bool smellStep(int& row, int& col, int targetRow, int targetCol, int smellDist,
+	const Open& open)
+{
+	int idealDist = abs(targetRow - row) + abs(targetCol - col);
+	if(idealDist > smellDist || idealDist <= 1)
+		return false; // Out of range, or attacking instead
+
+	int colDiff = targetCol - col;
+	int change = (colDiff < 0) ? -1 : (colDiff > 0) ? 1 : 0;
+	if(change != 0 && open(row, col + change))
+	{
+		col += change;
+		return true;
+	}
+
+	int rowDiff = targetRow - row;
+	change = (rowDiff < 0) ? -1 : (rowDiff > 0) ? 1 : 0;
+	if(change != 0 && open(row + change, col))
+	{
+		row += change;
+		return true;
+	}
+	return false;
+}
+
+template<typename Bound>
+void searchFromTarget(int dist[MAXROWS][MAXCOLS], int rows, int cols,
+	int targetRow, int targetCol, int goblinRow, int goblinCol, int maxSteps,
+	const Bound& stepsToGoblin)
+{
+	unsigned char queueRow[MAXROWS * MAXCOLS], queueCol[MAXROWS * MAXCOLS];
+	int head = 0, tail = 0;
+	dist[targetRow][targetCol] = 0;
+	queueRow[tail] = targetRow; queueCol[tail++] = targetCol;
+	while(head < tail)
+	{
+		int r = queueRow[head], c = queueCol[head++];
+		int steps = dist[r][c] + 1; // To the cells next to (r, c)
+		if(steps > maxSteps) continue;
+		for(int dir = 0; dir < NUMSTEPS; dir++)
+		{
+			int nr = r + STEPROW[dir], nc = c + STEPCOL[dir];
+			if(nr < 0 || nr >= rows || nc < 0 || nc >= cols || dist[nr][nc] != UNREACHED)
+				continue;
+			// Off the way to the goblin (straight distance first, as
+			// it is cheaper than the steps around walls)
+			if(steps + abs(nr - goblinRow) + abs(nc - goblinCol) > maxSteps + 1
+				|| steps + stepsToGoblin(nr, nc) > maxSteps + 1)
+				continue;
+			dist[nr][nc] = steps;
+			queueRow[tail] = nr; queueCol[tail++] = nc;
+		}
+	}
+}
+
+template<typename Open>
+int goblinStep(const int dist[MAXROWS][MAXCOLS], int row, int col,
+	int targetRow, int targetCol, int smellDist, const Open& open)
+{
+	int bestDir = -1, shortestPath = 9999;
+	for(int dir = 0; dir < NUMSTEPS; dir++)
+	{
+		int r = row + STEPROW[dir], c = col + STEPCOL[dir];
+		if(!open(r, c) || abs(r - targetRow) + abs(c - targetCol) >= smellDist)
+			continue;
+		if(dist[r][c] > 0 && dist[r][c] < shortestPath)
+		{
+			shortestPath = dist[r][c];
+			bestDir = dir;
+		}
+	}
+	return bestDir;
+}
+
+template<typename Open>
+void randomOpenCell(int rows, int cols, const Open& open, Rng& rng, int& row, int& col)
+{
+	int newRow, newCol;
+	do{
+		newRow = rng.randInt(rows);
+		newCol = rng.randInt(cols);
+	}while(!open(newRow, newCol));
+	row = newRow;
+	col = newCol;
+}
+
+template<typename Open>
+void readScroll(int kind, ActorState& reader, int& maxHit, int rows, int cols,
+	const Open& open, Rng& rng)
+{
+	switch(kind)
+	{
+		case TELEPORTSCROLL:
+		{
+			int newRow, newCol;
+			randomOpenCell(rows, cols, open, rng, newRow, newCol);
+			reader.row = newRow;
+			reader.col = newCol;
+			break;
+		}
+		case ARMORSCROLL:     // Up by 1 to 3
+			reader.armor = std::min(reader.armor + rng.randInt(1, 3), MAXARMOR);
+			break;
+		case STRENGTHSCROLL:  // Up by 1 to 3
+			reader.strength = std::min(reader.strength + rng.randInt(1, 3), MAXSTRENGTH);
+			break;
+		case HEALTHSCROLL:    // Maximum up by 3 to 8, hit points as they are
+			maxHit = std::min(maxHit + rng.randInt(3, 8), MAXHIT);
+			break;
+		case DEXTERITYSCROLL: // Up by 1
+			reader.dexterity = std::min(reader.dexterity + 1, MAXDEXTERITY);
+			break;
+	}
+}
+
+#endif // RULES_INCLUDED
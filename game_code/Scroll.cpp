@@ -4,63 +4,50 @@
 
 #include "GameObject.h"
 #include "Scroll.h"
+#include "Item.h"
 #include "Dungeon.h"
 #include "Player.h"
+#include "Definitions.h"
+#include "GameState.h"
+#include "Rules.h"
 #include "utilities.h"
 
 using namespace std;
 
 ////////////////////////////////////////////////////////////////////
-// Derived Scroll Classes Implementations
+// Scroll Record Implementations
 ////////////////////////////////////////////////////////////////////
 
-void TeleportationScroll::haveEffect(Player* user)
-	// The player is randomly moved to another place in the 
-	// level that is not occupied by a wall or a monster.
+ScrollItem makeScroll(ScrollKind kind)
 {
-	// Produce new open position on the dungeon
-	int newRow, newCol;
-	dungeon()->produceOpenPos(newRow, newCol);
-	// Move user to new position
-	user->setPos(newRow, newCol);
+	ScrollItem scroll;
+	scroll.kind = kind;
+	return scroll;
 }
 
-void ArmorScroll::haveEffect(Player* user)
-	// The player's armor points are increased by a 
-	// random integer from 1 to 3.
+string ScrollItem::name() const
 {
-	int newArmor = (user->armorPts() + randInt(1, 3));
-	// Increasing only to max armor pts if new armor pts is greater
-	if(newArmor > MAXARMOR) newArmor = MAXARMOR;
-	user->setArmorPts(newArmor);
+	return definitions().scrolls[kind].name;
 }
 
-void StrengthScroll::haveEffect(Player* user)
-	// The player's strength points are increased by a 
-	// random integer from 1 to 3.
+string ScrollItem::effect() const
 {
-	int newStrength = (user->strengthPts() + randInt(1, 3));
-	// Increasing only to max strength pts if new strength pts is greater
-	if(newStrength > MAXSTRENGTH) newStrength = MAXSTRENGTH;
-	user->setStrengthPts(newStrength);	
+	return definitions().scrolls[kind].effect;
 }
 
-void HealthScroll::haveEffect(Player* user)
-	// The player's maximum hit point value is increased by a 
-	// random integer from 3 to 8. This scroll does not affect 
-	// the player's current number of hit points.
+void ScrollItem::haveEffect(Player* user) const
+	// The effect of the kind (Rules.h): teleportation to a place on
+	// the level free of walls and monsters, or a stat raised
 {
-	int newMaxHit = (user->maxHitPts() + randInt(3, 8));
-	// Increasing only to max hit pts if new max hit pts is greater
-	if(newMaxHit > MAXHIT) newMaxHit = MAXHIT;
-	user->setMaxHitPts(newMaxHit);	
+	Dungeon* dungeon = user->dungeon();
+	ActorState before, after;
+	captureActor(*user, before);
+	after = before;
+	int maxHit = user->maxHitPts();
+	readScroll(kind, after, maxHit, dungeon->rows(), dungeon->cols(),
+		[dungeon](int row, int col) {return dungeon->canPlayerOccupy(row, col);},
+		dungeon->rng());
+	updateActor(before, after, *user);
+	if(maxHit != user->maxHitPts())
+		user->setMaxHitPts(maxHit);
 }
-
-void DexterityScroll::haveEffect(Player* user)
-	// The player's dexterity is increased by 1.
-{
-	int newDex = (user->dexterityPts() + 1);
-	// Increasing only to max dex pts if new dex pts is greater
-	if(newDex > MAXDEXTERITY) newDex = MAXDEXTERITY;
-	user->setDexterityPts(newDex);	
-}
\ No newline at end of file
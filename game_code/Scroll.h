@@ -6,14 +6,15 @@
 #include <string>
 
 #include "GameObject.h"
+#include "Item.h"
 
 class Dungeon;
-class Player;
-
-const char SCROLL = '?';
 
 ////////////////////////////////////////////////////////////////////
-// Base Scroll Class Declaration
+// Scroll Class Declaration
+//
+// A scroll lying in the dungeon. The scroll itself is the
+// ScrollItem record, which is what the player carries and reads.
 ////////////////////////////////////////////////////////////////////
 
 class Scroll : public GameObject
@@ -21,111 +22,27 @@ class Scroll : public GameObject
   public:
   	/////////////////////////////////////////////////////////////////
 	// Constructor and Destructor
-	Scroll(int row, int col, Dungeon* dungeon)
-		: GameObject(row, col, dungeon)
+	Scroll(int row, int col, Dungeon* dungeon, ScrollKind kind)
+		: GameObject(row, col, dungeon),
+		  m_scroll(makeScroll(kind))
 	{}
 
 	virtual ~Scroll() {}
 
-	// Symbol
-	virtual char symbol() const {return SCROLL;}
+	// Name, symbol and item record
+	virtual std::string name() const {return m_scroll.name();}
+	virtual char symbol() const      {return SCROLL;}
+	virtual Item item() const        {return makeItem(m_scroll);}
+
 	// Effect string
-	virtual std::string effect() const = 0;
+	std::string effect() const {return m_scroll.effect();}
 
+  private:
 	/////////////////////////////////////////////////////////////////
-	// Game Functions
-
-	// Each scroll has a unique effect on its user
-	virtual void haveEffect(Player* user) = 0;
-};
-
-////////////////////////////////////////////////////////////////////
-// Derived Scroll Classes Declarations
-////////////////////////////////////////////////////////////////////
-
-class TeleportationScroll : public Scroll
-{
-  public:
-	TeleportationScroll(int row, int col, Dungeon* dungeon)
-		: Scroll(row, col, dungeon)
-	{}
-
-	// Name and effect
-	virtual std::string name() const 
-		{return "scroll of teleportation";}
-	virtual std::string effect() const 
-		{return "You feel your body wrenched in space and time.";}
-	
-	// Effect of reading scroll
-	virtual void haveEffect(Player* user);
-};
-
-class ArmorScroll : public Scroll
-{
-  public:
-	ArmorScroll(int row, int col, Dungeon* dungeon)
-		: Scroll(row, col, dungeon)
-	{}
 
-	// Name and effect
-	virtual std::string name() const 
-		{return "scroll of improve armor";}
-	virtual std::string effect() const 
-		{return "Your armor glows blue.";}
-	
-	// Effect of reading scroll
-	virtual void haveEffect(Player* user);
-};
-
-class StrengthScroll : public Scroll
-{
-  public:
-	StrengthScroll(int row, int col, Dungeon* dungeon)
-		: Scroll(row, col, dungeon)
-	{}
+	ScrollItem m_scroll;
 
-	// Name and effect
-	virtual std::string name() const 
-		{return "scroll of raise strength";}
-	virtual std::string effect() const 
-		{return "Your muscles bulge.";}
-	
-	// Effect of reading scroll
-	virtual void haveEffect(Player* user);
-};
-
-class HealthScroll : public Scroll
-{
-  public:
-	HealthScroll(int row, int col, Dungeon* dungeon)
-		: Scroll(row, col, dungeon)
-	{}
-	
-	// Name and effect
-	virtual std::string name() const 
-		{return "scroll of enhance health";}
-	virtual std::string effect() const 
-		{return "You feel your heart beating stronger.";}
-	
-	// Effect of reading scroll
-	virtual void haveEffect(Player* user);
-};
-
-class DexterityScroll : public Scroll
-{
-  public:
-	DexterityScroll(int row, int col, Dungeon* dungeon)
-		: Scroll(row, col, dungeon)
-	{}
-
-	// Name and effect
-	virtual std::string name() const 
-		{return "scroll of enhance dexterity";}
-	virtual std::string effect() const 
-		{return "You feel like less of a klutz.";}
-	
-	// Effect of reading scroll
-	virtual void haveEffect(Player* user);
+	/////////////////////////////////////////////////////////////////
 };
 
-#endif // SCROLL_INCLUDED
\ No newline at end of file
+#endif // SCROLL_INCLUDED
@@ -0,0 +1,180 @@
+// SlotMap.h
+
+#ifndef SLOTMAP_INCLUDED
+#define SLOTMAP_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+// Handle to a value in a SlotMap: its slot, and the generation of the
+// slot when the value was put in it. The default handle is never
+// valid.
+struct SlotHandle
+{
+	uint32_t slot;
+	uint32_t generation; // 0 for no value
+
+	SlotHandle() : slot(0), generation(0) {}
+	SlotHandle(uint32_t slot, uint32_t generation) : slot(slot), generation(generation) {}
+
+	bool operator==(const SlotHandle& other) const
+		{return slot == other.slot && generation == other.generation;}
+	bool operator!=(const SlotHandle& other) const {return !(*this == other);}
+};
+
+////////////////////////////////////////////////////////////////////
+// Slot Map
+//
+// Values kept densely in the order they were put in, each reachable
+// through a handle that stays valid while the value is in the map and
+// goes stale once it is erased: the slot it names has its generation
+// bumped, so a stale handle finds nothing rather than whatever took
+// the slot over. Handles are plain numbers, so they hold across the
+// values being moved about, copies of the map and saved games.
+//
+// Putting in, looking up and checking a handle take constant time.
+// Erasing finds the value in constant time too, then moves the
+// values after it down one place so the rest keep their order (the
+// order monsters move in, for a Dungeon): a few dozen pointers at
+// most on a level.
+////////////////////////////////////////////////////////////////////
+
+template<typename T>
+class SlotMap
+{
+  public:
+	SlotMap() : m_free(NOSLOT) {}
+
+	// Put value in at the end, returns its handle
+	SlotHandle insert(const T& value);
+	// Take the value of handle out (false if the handle is stale)
+	bool erase(SlotHandle handle);
+	void clear();
+
+	// Undo logs (see UndoLog.h): take back the newest insert, or put
+	// back the value of the newest erase where it was and under its
+	// handle, leaving the map as it was before either
+	void undoInsert(SlotHandle handle);
+	void undoErase(SlotHandle handle, size_t index, const T& value);
+
+	bool contains(SlotHandle handle) const
+	{
+		return handle.slot < m_slots.size()
+			&& m_slots[handle.slot].generation == handle.generation;
+	}
+	// Value of handle, nullptr if the handle is stale
+	T* get(SlotHandle handle)
+		{return contains(handle) ? &m_values[m_slots[handle.slot].index] : nullptr;}
+	const T* get(SlotHandle handle) const
+		{return contains(handle) ? &m_values[m_slots[handle.slot].index] : nullptr;}
+
+	// The values in order, and the handle of the i-th
+	size_t size() const {return m_values.size();}
+	bool empty() const {return m_values.empty();}
+	T& operator[](size_t i) {return m_values[i];}
+	const T& operator[](size_t i) const {return m_values[i];}
+	const std::vector<T>& values() const {return m_values;}
+	SlotHandle handleAt(size_t i) const
+		{return SlotHandle(m_slotOf[i], m_slots[m_slotOf[i]].generation);}
+	// Place of the value of a handle in the order (which must hold)
+	size_t indexOf(SlotHandle handle) const {return m_slots[handle.slot].index;}
+
+  private:
+	static const uint32_t NOSLOT = 0xFFFFFFFF;
+
+	struct Slot
+	{
+		uint32_t index;      // Of the value, or the next free slot
+		uint32_t generation; // Odd while the slot holds a value
+	};
+
+	std::vector<Slot> m_slots;
+	std::vector<T> m_values;
+	std::vector<uint32_t> m_slotOf; // Slot of each value
+	uint32_t m_free;                // First free slot
+};
+
+/////////////////////////////////////////////////////////////////////
+// Template Implementations
+
+template<typename T>
+SlotHandle SlotMap<T>::insert(const T& value)
+{
+	uint32_t slot = m_free;
+	if(slot == NOSLOT)
+	{
+		slot = m_slots.size();
+		Slot fresh = {0, 0};
+		m_slots.push_back(fresh);
+	}
+	else
+		m_free = m_slots[slot].index;
+
+	m_slots[slot].index = m_values.size();
+	m_slots[slot].generation++; // Even to odd: in use
+	m_values.push_back(value);
+	m_slotOf.push_back(slot);
+	return SlotHandle(slot, m_slots[slot].generation);
+}
+
+template<typename T>
+bool SlotMap<T>::erase(SlotHandle handle)
+{
+	if(!contains(handle)) return false;
+
+	// Closing the gap, keeping the order
+	uint32_t index = m_slots[handle.slot].index;
+	for(size_t i = index; i + 1 < m_values.size(); i++)
+	{
+		m_values[i] = m_values[i + 1];
+		m_slotOf[i] = m_slotOf[i + 1];
+		m_slots[m_slotOf[i]].index = i;
+	}
+	m_values.pop_back();
+	m_slotOf.pop_back();
+
+	// Freeing the slot
+	m_slots[handle.slot].generation++; // Odd to even: free
+	m_slots[handle.slot].index = m_free;
+	m_free = handle.slot;
+	return true;
+}
+
+template<typename T>
+void SlotMap<T>::undoInsert(SlotHandle handle)
+{
+	// The newest value is the last one
+	m_values.pop_back();
+	m_slotOf.pop_back();
+
+	if(handle.generation == 1) // A fresh slot, the last one
+		m_slots.pop_back();
+	else // Back on the free list, where it was taken from
+	{
+		m_slots[handle.slot].generation--;
+		m_slots[handle.slot].index = m_free;
+		m_free = handle.slot;
+	}
+}
+
+template<typename T>
+void SlotMap<T>::undoErase(SlotHandle handle, size_t index, const T& value)
+{
+	// The slot freed last is first on the free list
+	m_free = m_slots[handle.slot].index;
+	m_slots[handle.slot].generation--;
+
+	m_values.insert(m_values.begin() + index, value);
+	m_slotOf.insert(m_slotOf.begin() + index, handle.slot);
+	for(size_t i = index; i < m_values.size(); i++)
+		m_slots[m_slotOf[i]].index = i;
+}
+
+template<typename T>
+void SlotMap<T>::clear()
+{
+	while(!m_values.empty())
+		erase(handleAt(m_values.size() - 1));
+}
+
+#endif // SLOTMAP_INCLUDED
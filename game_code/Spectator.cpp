@@ -0,0 +1,181 @@
+#include <cstdio>
+#include <string>
+
+#include "Spectator.h"
+#include "utilities.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////
+// Frame Output
+////////////////////////////////////////////////////////////////////
+
+void printFrame(ostream& out, const Frame& frame)
+{
+	// Printing the grid
+	for(int i = 0; i < frame.rows; i++)
+	{
+		out.write(frame.grid[i], frame.cols);
+		out << '\n';
+	}
+	// Outputting the stats
+	out << "Dungeon Level: " << frame.level        << ", "
+		<< "Hit Points: "    << frame.hitPts       << ", "
+		<< "Armor: "         << frame.armorPts     << ", "
+		<< "Strength: "      << frame.strengthPts  << ", "
+		<< "Dexterity: "     << frame.dexterityPts << '\n';
+
+	out << '\n';
+
+	// Outputting the result of the previous move
+	out << frame.result << endl;
+}
+
+static void writeJsonString(ostream& out, const char* text, int length)
+	// Write text as a quoted JSON string
+{
+	out << '"';
+	for(int i = 0; i < length && text[i] != '\0'; i++)
+	{
+		char c = text[i];
+		if(c == '"' || c == '\\')
+			out << '\\' << c;
+		else if(c == '\n')
+			out << "\\n";
+		else if((unsigned char)c < 0x20)
+		{
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+			out << escaped;
+		}
+		else
+			out << c;
+	}
+	out << '"';
+}
+
+void writeFrameJson(ostream& out, const Frame& frame)
+{
+	out << "{\"turn\":" << frame.turn
+		<< ",\"level\":" << frame.level
+		<< ",\"hit\":" << frame.hitPts
+		<< ",\"armor\":" << frame.armorPts
+		<< ",\"strength\":" << frame.strengthPts
+		<< ",\"dexterity\":" << frame.dexterityPts
+		<< ",\"grid\":[";
+	for(int i = 0; i < frame.rows; i++)
+	{
+		if(i > 0) out << ',';
+		writeJsonString(out, frame.grid[i], frame.cols);
+	}
+	out << "],\"result\":";
+	writeJsonString(out, frame.result, MAXRESULTLEN);
+	out << "}\n";
+	out.flush();
+}
+
+void printInventory(ostream& out, const Inventory& inventory)
+{
+	char key = 'a';
+	for(int i = 0; i < inventory.size(); i++, key++)
+	{
+		string print = "";
+		if(inventory[i].isScroll()) // If object is scroll
+			print = "A scroll called "; // Add prefix
+		out << key << ". " << print + inventory[i].name() << '\n';
+	}
+	out << flush;
+}
+
+void TtyFrameSink::write(const Frame& frame)
+{
+	clearScreen();
+	printFrame(cout, frame);
+}
+
+void TtyFrameSink::writeInventory(const Inventory& inventory)
+{
+	clearScreen();
+	printInventory(cout, inventory);
+}
+
+void JsonFrameSink::write(const Frame& frame)
+{
+	writeFrameJson(m_out, frame);
+}
+
+void JsonFrameSink::writeInventory(const Inventory& inventory)
+{
+	m_out << "{\"inventory\":[";
+	for(int i = 0; i < inventory.size(); i++)
+	{
+		string name = inventory[i].name();
+		if(i > 0) m_out << ',';
+		writeJsonString(m_out, name.c_str(), int(name.size()));
+	}
+	m_out << "]}\n";
+	m_out.flush();
+}
+
+////////////////////////////////////////////////////////////////////
+// Spectator Class Implementation
+////////////////////////////////////////////////////////////////////
+
+Spectator::Spectator(FrameSink* sink, double maxFramesPerSecond)
+	: m_sink(sink), m_hasPending(false), m_stopping(false),
+	  m_wantsFrame(true), m_submitted(0), m_shown(0)
+{
+	if(maxFramesPerSecond <= 0) maxFramesPerSecond = 30;
+	m_interval = chrono::duration_cast<chrono::steady_clock::duration>(
+		chrono::duration<double>(1 / maxFramesPerSecond));
+	m_renderer = thread(&Spectator::renderLoop, this);
+}
+
+Spectator::~Spectator()
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_frameReady.notify_one();
+	m_renderer.join();
+}
+
+void Spectator::submit(const Frame& frame)
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_pending = frame;
+		m_hasPending = true;
+		m_wantsFrame.store(false, memory_order_relaxed);
+	}
+	m_submitted++;
+	m_frameReady.notify_one();
+}
+
+void Spectator::renderLoop()
+{
+	Frame frame;
+	unique_lock<mutex> lock(m_mutex);
+	for(;;)
+	{
+		// Waiting for a frame (or the end)
+		m_frameReady.wait(lock, [this] {return m_hasPending || m_stopping;});
+		if(!m_hasPending)
+			return;
+
+		// Showing it outside the lock so the game never waits on the sink
+		frame = m_pending;
+		m_hasPending = false;
+		lock.unlock();
+		chrono::steady_clock::time_point next = chrono::steady_clock::now() + m_interval;
+		m_sink->write(frame);
+		m_shown++;
+
+		// Holding off until the next frame is due (unless stopping,
+		// when only the last frame is still to be shown)
+		lock.lock();
+		m_frameReady.wait_until(lock, next, [this] {return m_stopping;});
+		m_wantsFrame.store(true, memory_order_relaxed);
+	}
+}
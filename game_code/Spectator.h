@@ -0,0 +1,153 @@
+// Spectator.h
+
+#ifndef SPECTATOR_INCLUDED
+#define SPECTATOR_INCLUDED
+
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+#include "Dungeon.h"
+#include "Inventory.h"
+
+const int MAXRESULTLEN = 255; // Longer result messages are cut short
+
+////////////////////////////////////////////////////////////////////
+// Frame
+//
+// Snapshot of what Dungeon::display shows at the end of a turn:
+// the level as the player sees it, the player's stats and the
+// result message. Plain bytes, so it can be copied around freely.
+////////////////////////////////////////////////////////////////////
+
+struct Frame
+{
+	int turn;
+	int level;
+	int rows, cols;
+	int hitPts, armorPts, strengthPts, dexterityPts;
+	char grid[MAXROWS][MAXCOLS];
+	char result[MAXRESULTLEN + 1]; // Null terminated
+};
+
+// Print a frame the way Dungeon::display does (without clearing
+// the screen)
+void printFrame(std::ostream& out, const Frame& frame);
+
+// Write a frame as one line of JSON (the grid as an array of rows)
+void writeFrameJson(std::ostream& out, const Frame& frame);
+
+// Print an inventory the way Player::displayInventory does, one
+// item a line with its key (without clearing the screen)
+void printInventory(std::ostream& out, const Inventory& inventory);
+
+////////////////////////////////////////////////////////////////////
+// Frame Sinks: where a Spectator sends the frames it shows
+////////////////////////////////////////////////////////////////////
+
+class FrameSink
+{
+  public:
+	virtual ~FrameSink() {}
+	virtual void write(const Frame& frame) = 0;
+	// The player looking at their inventory (ignored by default)
+	virtual void writeInventory(const Inventory&) {}
+};
+
+// Clears the terminal and prints the frame
+class TtyFrameSink : public FrameSink
+{
+  public:
+	virtual void write(const Frame& frame);
+	virtual void writeInventory(const Inventory& inventory);
+};
+
+// Throws frames away (for timing runs)
+class NullFrameSink : public FrameSink
+{
+  public:
+	virtual void write(const Frame&) {}
+};
+
+// One JSON object per line, for tooling
+class JsonFrameSink : public FrameSink
+{
+  public:
+	JsonFrameSink(std::ostream& out) : m_out(out) {}
+	virtual void write(const Frame& frame);
+	virtual void writeInventory(const Inventory& inventory);
+
+  private:
+	std::ostream& m_out;
+};
+
+////////////////////////////////////////////////////////////////////
+// Spectator Class Declaration
+//
+// Shows a game without slowing it down. The game submits frames
+// whenever it likes; a render thread of the spectator writes the
+// latest one to the sink at most maxFramesPerSecond times a second,
+// and frames submitted in between are dropped. Submitting a frame
+// only copies it.
+//
+// Building a frame costs a little too, so a fast game can ask
+// wantsFrame() first and only snapshot turns that would be shown.
+// The last frame submitted is always shown before the spectator
+// is destroyed.
+////////////////////////////////////////////////////////////////////
+
+class Spectator
+{
+  public:
+	/////////////////////////////////////////////////////////////////
+	// Constructor and Destructor
+
+	// Frames go to sink (owned by the caller, written to only by the
+	// render thread)
+	Spectator(FrameSink* sink, double maxFramesPerSecond = 30);
+	~Spectator();
+
+	/////////////////////////////////////////////////////////////////
+	// Game Side
+
+	// The render thread is ready for a new frame
+	bool wantsFrame() const {return m_wantsFrame.load(std::memory_order_relaxed);}
+
+	// Hand over the newest frame (replacing one not shown yet)
+	void submit(const Frame& frame);
+
+	/////////////////////////////////////////////////////////////////
+	// Accessors
+	int framesSubmitted() const {return m_submitted.load();}
+	int framesShown() const {return m_shown.load();}
+	int framesDropped() const {return framesSubmitted() - framesShown();}
+
+  private:
+	/////////////////////////////////////////////////////////////////
+
+	FrameSink* m_sink;
+	std::chrono::steady_clock::duration m_interval; // Between two frames shown
+
+	Frame m_pending;       // Newest frame submitted
+	bool m_hasPending;     // m_pending not shown yet
+	bool m_stopping;
+	std::atomic<bool> m_wantsFrame;
+	std::atomic<int> m_submitted;
+	std::atomic<int> m_shown;
+
+	std::mutex m_mutex;
+	std::condition_variable m_frameReady;
+	std::thread m_renderer;
+
+	/////////////////////////////////////////////////////////////////
+	// Private Helper Functions
+
+	void renderLoop();
+
+	/////////////////////////////////////////////////////////////////
+};
+
+#endif // SPECTATOR_INCLUDED
@@ -0,0 +1,42 @@
+#include <cstring>
+
+#include "TargetField.h"
+#include "Player.h"
+
+using namespace std;
+
+void TargetField::compute(const Dungeon& dungeon, const vector<Player*>& players)
+{
+	static const int DR[4] = {-1, 1, 0, 0};
+	static const int DC[4] = {0, 0, -1, 1};
+
+	memset(m_owner, -1, sizeof(m_owner));
+	memset(m_dist, -1, sizeof(m_dist));
+
+	// Starting from every living player
+	short queue[MAXROWS * MAXCOLS][2];
+	int head = 0, tail = 0;
+	for(size_t p = 0; p < players.size(); p++)
+	{
+		int row = players[p]->row(), col = players[p]->col();
+		if(players[p]->isDead() || m_owner[row][col] != -1) continue;
+		m_owner[row][col] = p;
+		m_dist[row][col] = 0;
+		queue[tail][0] = row;
+		queue[tail++][1] = col;
+	}
+
+	while(head < tail)
+	{
+		int row = queue[head][0], col = queue[head++][1];
+		for(int d = 0; d < 4; d++)
+		{
+			int r = row + DR[d], c = col + DC[d];
+			if(dungeon.isWall(r, c) || m_owner[r][c] != -1) continue;
+			m_owner[r][c] = m_owner[row][col];
+			m_dist[r][c] = m_dist[row][col] + 1;
+			queue[tail][0] = r;
+			queue[tail++][1] = c;
+		}
+	}
+}
@@ -0,0 +1,47 @@
+// TargetField.h
+
+#ifndef TARGETFIELD_INCLUDED
+#define TARGETFIELD_INCLUDED
+
+#include <vector>
+
+#include "Dungeon.h"
+
+class Player;
+
+////////////////////////////////////////////////////////////////////
+// Target Field
+//
+// Which player every cell of a level is nearest to, for the monsters
+// of a level shared by several players. One breadth first search
+// starts from every living player at once (in player order) and
+// spreads through the cells that aren't walls, so each cell is
+// reached first from its nearest player, ties going to the player
+// that comes first. Monsters don't block the search, since they move
+// out of each other's way.
+//
+// The field is worked out once a turn, before the monsters move
+// (players stand still while they do), and every monster then reads
+// its target off the cell it stands on: a search per turn whatever
+// the number of monsters, and covering every player in one pass.
+////////////////////////////////////////////////////////////////////
+
+class TargetField
+{
+  public:
+	// Work the field out for dungeon and its players (dead ones left
+	// out)
+	void compute(const Dungeon& dungeon, const std::vector<Player*>& players);
+
+	// Index of the player nearest to (row, col), -1 if none can be
+	// reached from there
+	int nearest(int row, int col) const {return m_owner[row][col];}
+	// Steps from (row, col) to that player
+	int distance(int row, int col) const {return m_dist[row][col];}
+
+  private:
+	short m_dist[MAXROWS][MAXCOLS];
+	signed char m_owner[MAXROWS][MAXCOLS];
+};
+
+#endif // TARGETFIELD_INCLUDED
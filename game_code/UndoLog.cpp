@@ -0,0 +1,181 @@
+#include "UndoLog.h"
+#include "Actor.h"
+#include "Player.h"
+#include "Monster.h"
+#include "GameObject.h"
+#include "Dungeon.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////
+// Undo Log Implementation
+////////////////////////////////////////////////////////////////////
+
+UndoLog::~UndoLog()
+{
+	clear();
+}
+
+void UndoLog::clear()
+{
+	for(size_t i = 0; i < m_levels.size(); i++)
+		delete m_levels[i];
+	m_levels.clear();
+	m_records.clear();
+	m_marks.clear();
+	m_weapons.clear();
+	m_items.clear();
+	m_monsters.clear();
+	m_objects.clear();
+	m_turns = 0;
+}
+
+void UndoLog::push(UndoRecord::Op op, Actor* actor, SlotHandle handle,
+	int index, int a, int b, int stat)
+	// Players are kept by pointer, monsters by handle: a monster
+	// killed and put back by an undo is a new one
+{
+	UndoRecord record;
+	record.op = op;
+	record.stat = stat;
+	record.index = index;
+	record.a = a;
+	record.b = b;
+	record.player = nullptr;
+	record.handle = handle;
+	if(actor)
+	{
+		record.handle = actor->handle();
+		if(record.handle == SlotHandle())
+			record.player = actor;
+	}
+	m_records.push_back(record);
+}
+
+/////////////////////////////////////////////////////////////////
+// Recording
+
+void UndoLog::turnStarted(const TurnMark& mark)
+{
+	m_marks.push_back(mark);
+	push(UndoRecord::TURN, nullptr, SlotHandle());
+	m_turns++;
+}
+
+void UndoLog::moved(Actor* actor, int row, int col)
+{
+	push(UndoRecord::MOVE, actor, SlotHandle(), 0, row, col);
+}
+
+void UndoLog::statChanged(Actor* actor, ActorStat stat, int value)
+{
+	push(UndoRecord::STAT, actor, SlotHandle(), 0, value, 0, stat);
+}
+
+void UndoLog::weaponChanged(Actor* actor, const WeaponItem& weapon)
+{
+	m_weapons.push_back(weapon);
+	push(UndoRecord::WEAPON, actor, SlotHandle());
+}
+
+void UndoLog::itemPushed(Player* player)
+{
+	push(UndoRecord::ITEMPUSHED, player, SlotHandle());
+}
+
+void UndoLog::itemErased(Player* player, int sub, const Item& item)
+{
+	m_items.push_back(item);
+	push(UndoRecord::ITEMERASED, player, SlotHandle(), sub);
+}
+
+void UndoLog::monsterKilled(const Monster& monster, int index)
+{
+	ActorState killed;
+	captureActor(monster, killed);
+	killed.kind = monster.kind();
+	killed.maxHit = monster.maxHitPts();
+	m_monsters.push_back(killed);
+	push(UndoRecord::MONSTERKILLED, nullptr, monster.handle(), index, monster.energy());
+}
+
+void UndoLog::objectAdded(const GameObject& object)
+{
+	push(UndoRecord::OBJECTADDED, nullptr, object.handle());
+}
+
+void UndoLog::objectRemoved(const GameObject& object, int index)
+{
+	ObjectState removed;
+	removed.row = object.row();
+	removed.col = object.col();
+	removed.item = object.item();
+	m_objects.push_back(removed);
+	push(UndoRecord::OBJECTREMOVED, nullptr, object.handle(), index);
+}
+
+void UndoLog::cellSeen(int row, int col)
+{
+	push(UndoRecord::CELLSEEN, nullptr, SlotHandle(), 0, row, col);
+}
+
+
+void UndoLog::levelLeft(Dungeon* level, int row, int col)
+{
+	m_levels.push_back(level);
+	push(UndoRecord::LEVELLEFT, nullptr, SlotHandle(), 0, row, col);
+}
+
+/////////////////////////////////////////////////////////////////
+// Undoing
+
+bool UndoLog::pop(UndoRecord& record)
+{
+	if(m_records.empty()) return false;
+	record = m_records.back();
+	m_records.pop_back();
+	if(record.op == UndoRecord::TURN) m_turns--;
+	return true;
+}
+
+TurnMark UndoLog::popTurn()
+{
+	TurnMark mark = m_marks.back();
+	m_marks.pop_back();
+	return mark;
+}
+
+WeaponItem UndoLog::popWeapon()
+{
+	WeaponItem weapon = m_weapons.back();
+	m_weapons.pop_back();
+	return weapon;
+}
+
+Item UndoLog::popItem()
+{
+	Item item = m_items.back();
+	m_items.pop_back();
+	return item;
+}
+
+ActorState UndoLog::popMonster()
+{
+	ActorState killed = m_monsters.back();
+	m_monsters.pop_back();
+	return killed;
+}
+
+ObjectState UndoLog::popObject()
+{
+	ObjectState removed = m_objects.back();
+	m_objects.pop_back();
+	return removed;
+}
+
+Dungeon* UndoLog::popLevel()
+{
+	Dungeon* level = m_levels.back();
+	m_levels.pop_back();
+	return level;
+}
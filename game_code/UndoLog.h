@@ -0,0 +1,134 @@
+// UndoLog.h
+
+#ifndef UNDOLOG_INCLUDED
+#define UNDOLOG_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+#include "Item.h"
+#include "SlotMap.h"
+#include "Actor.h"
+#include "GameState.h"
+
+class Player;
+class Monster;
+class GameObject;
+class Dungeon;
+
+// One change, as the operation that takes it back
+struct UndoRecord
+{
+	enum Op
+	{
+		TURN,          // A turn started (the game's counters are kept)
+		MOVE,          // Actor moved from (a, b)
+		STAT,          // Stat of actor was a
+		WEAPON,        // Actor wielded the weapon kept
+		ITEMPUSHED,    // Item added to the end of a player's inventory
+		ITEMERASED,    // Item kept was at subscript index of inventory
+		MONSTERKILLED, // Monster kept was index-th, with a energy
+		OBJECTADDED,   // Object put on the level
+		OBJECTREMOVED, // Object kept was index-th
+		CELLSEEN,      // Cell (a, b) seen for the first time
+		LEVELLEFT      // Player left the level kept from (a, b)
+	};
+
+	unsigned char op;
+	unsigned char stat; // ActorStat changed
+	short index;
+	short a, b;
+	Actor* player;      // Player changed (nullptr for monsters)
+	SlotHandle handle;  // Monster or object changed
+};
+
+// What a turn can change of the game itself
+struct TurnMark
+{
+	uint64_t rng;      // State of the game's random number generator
+	int turns, ticks;
+	bool hasWon;
+	int damageDealt[NUMWEAPONKINDS];
+	int itemsCollected;
+};
+
+////////////////////////////////////////////////////////////////////
+// Undo Log
+//
+// Every change the turns of a game make, recorded as it is made as
+// the small operation that takes it back: where an actor stood, a
+// stat it had, an item it held, a monster killed or object picked
+// up (kept whole so it can be put back, under the same handle and
+// in the same place of the order), a cell first seen, and at the
+// start of every turn the game's counters and the state of its
+// random number generator, which stands for every number the turn
+// draws. A level left behind is kept whole too.
+//
+// Undoing a turn carries out its operations newest first, back to
+// the turn's start, which leaves the game exactly as it was: any
+// number of turns can be taken back, each for the cost of the
+// changes it made rather than of playing the game again up to it.
+//
+// Records are small and fixed size; monsters, objects, items and
+// levels go on stacks of their own, taken back in the same order.
+////////////////////////////////////////////////////////////////////
+
+class UndoLog
+{
+  public:
+	UndoLog() : m_turns(0) {}
+	~UndoLog(); // Deletes the levels kept
+
+	// Turns recorded, and records kept
+	int turns() const {return m_turns;}
+	size_t size() const {return m_records.size();}
+	// Forget everything recorded
+	void clear();
+
+	/////////////////////////////////////////////////////////////////
+	// Recording, before each change is made
+
+	void turnStarted(const TurnMark& mark);
+	void moved(Actor* actor, int row, int col);
+	void statChanged(Actor* actor, ActorStat stat, int value);
+	void weaponChanged(Actor* actor, const WeaponItem& weapon);
+	void itemPushed(Player* player);
+	void itemErased(Player* player, int sub, const Item& item);
+	void monsterKilled(const Monster& monster, int index);
+	void objectAdded(const GameObject& object);
+	void objectRemoved(const GameObject& object, int index);
+	void cellSeen(int row, int col);
+	// The log takes the level over
+	void levelLeft(Dungeon* level, int row, int col);
+
+	/////////////////////////////////////////////////////////////////
+	// Undoing: the newest record (false if there is none), and what
+	// it kept
+
+	bool pop(UndoRecord& record);
+	TurnMark popTurn();
+	WeaponItem popWeapon();
+	Item popItem();
+	ActorState popMonster();
+	ObjectState popObject();
+	Dungeon* popLevel(); // The caller takes the level over
+
+  private:
+	// Logs own the levels kept, so they are not copied
+	UndoLog(const UndoLog&);
+	UndoLog& operator=(const UndoLog&);
+
+	void push(UndoRecord::Op op, Actor* actor, SlotHandle handle,
+		int index = 0, int a = 0, int b = 0, int stat = 0);
+
+	int m_turns;
+	std::vector<UndoRecord> m_records;
+	std::vector<TurnMark> m_marks;
+	std::vector<WeaponItem> m_weapons;
+	std::vector<Item> m_items;
+	std::vector<ActorState> m_monsters;
+	std::vector<ObjectState> m_objects;
+	std::vector<Dungeon*> m_levels;
+};
+
+#endif // UNDOLOG_INCLUDED
@@ -0,0 +1,231 @@
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+#include "VecEnv.h"
+#include "Game.h"
+#include "Player.h"
+#include "Monster.h"
+#include "Dungeon.h"
+#include "GameObject.h"
+#include "utilities.h"
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////
+// Player command for every action (wield and read handled apart)
+static const char ACTIONCOMMAND[WIELDACTIONS] =
+{
+	ARROW_UP, ARROW_DOWN, ARROW_LEFT, ARROW_RIGHT, 'g', '>', 's'
+};
+
+////////////////////////////////////////////////////////////////////
+// VecEnv Class Implementation
+////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////
+// Constructor and Destructor
+
+VecEnv::VecEnv(int numEnvs, int goblinSmellDist, int maxTurns, int numThreads)
+	: m_numEnvs(numEnvs), m_maxTurns(maxTurns), m_seed(0),
+	  m_episodes(numEnvs, 0), m_actions(nullptr), m_observations(nullptr),
+	  m_rewards(nullptr), m_dones(nullptr), m_generation(0), m_pending(0),
+	  m_stopping(false)
+{
+	if(numEnvs < 1 || numThreads < 1 || maxTurns < 1)
+	{
+		cerr << "Error: Invalid sizes passed to VecEnv Contructor" << endl;
+		exit(1);
+	}
+	for(int i = 0; i < numEnvs; i++)
+		m_games.push_back(new Game(goblinSmellDist, mixSeed(0, i)));
+
+	// The caller's thread plays the first part of the games
+	if(numThreads > numEnvs) numThreads = numEnvs;
+	for(int t = 1; t < numThreads; t++)
+		m_workers.push_back(thread(&VecEnv::workerLoop, this, t));
+}
+
+VecEnv::~VecEnv()
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_start.notify_all();
+	for(size_t t = 0; t < m_workers.size(); t++)
+		m_workers[t].join();
+
+	for(int i = 0; i < m_numEnvs; i++)
+		delete m_games[i];
+}
+
+/////////////////////////////////////////////////////////////////
+// Environment Functions
+
+void VecEnv::reset(uint64_t seed, unsigned char* observations)
+{
+	m_seed = seed;
+	for(int i = 0; i < m_numEnvs; i++)
+	{
+		m_episodes[i] = 0;
+		m_games[i]->reset(episodeSeed(i));
+		observe(*m_games[i], observations + size_t(i) * OBSBYTES);
+	}
+}
+
+void VecEnv::step(const int* actions, unsigned char* observations,
+	float* rewards, unsigned char* dones)
+{
+	m_actions = actions;
+	m_observations = observations;
+	m_rewards = rewards;
+	m_dones = dones;
+
+	if(m_workers.empty())
+	{
+		stepRange(0, m_numEnvs);
+		return;
+	}
+
+	// Waking the workers for their parts
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_pending = m_workers.size();
+		m_generation++;
+	}
+	m_start.notify_all();
+
+	stepRange(0, rangeStart(1));
+
+	// Waiting for every part to be played
+	unique_lock<mutex> lock(m_mutex);
+	m_finish.wait(lock, [this]{return m_pending == 0;});
+}
+
+/////////////////////////////////////////////////////////////////
+// Observation Functions
+
+void VecEnv::observe(const Game& game, unsigned char* obs)
+{
+	const Dungeon* dungeon = game.dungeon();
+	const Player* player = game.player();
+	memset(obs, 0, OBSPLANEBYTES);
+
+	// Terrain
+	unsigned char* walls = obs + WALLPLANE * MAXROWS * MAXCOLS;
+	unsigned char* stairs = obs + STAIRPLANE * MAXROWS * MAXCOLS;
+	unsigned char* idols = obs + IDOLPLANE * MAXROWS * MAXCOLS;
+	for(int i = 0; i < MAXROWS; i++)
+		for(int j = 0; j < MAXCOLS; j++)
+		{
+			int cell = i * MAXCOLS + j;
+			walls[cell] = dungeon->isWall(i, j);
+			stairs[cell] = dungeon->isStair(i, j);
+			idols[cell] = dungeon->isIdol(i, j);
+		}
+
+	// Monsters, objects and player
+	const vector<Monster*>& monsters = dungeon->monsters();
+	for(size_t m = 0; m < monsters.size(); m++)
+		obs[(MONSTERPLANES + monsters[m]->kind()) * MAXROWS * MAXCOLS
+			+ monsters[m]->row() * MAXCOLS + monsters[m]->col()] = 1;
+
+	const vector<GameObject*>& objects = dungeon->objects();
+	for(size_t o = 0; o < objects.size(); o++)
+		obs[OBJECTPLANE * MAXROWS * MAXCOLS
+			+ objects[o]->row() * MAXCOLS + objects[o]->col()] = 1;
+
+	obs[PLAYERPLANE * MAXROWS * MAXCOLS
+		+ player->row() * MAXCOLS + player->col()] = 1;
+
+	// Stats
+	int32_t stats[NUMOBSSTATS];
+	stats[HITSTAT] = player->hitPts();
+	stats[ARMORSTAT] = player->armorPts();
+	stats[STRENGTHSTAT] = player->strengthPts();
+	stats[DEXTERITYSTAT] = player->dexterityPts();
+	stats[LEVELSTAT] = dungeon->level();
+	memcpy(obs + OBSPLANEBYTES, stats, sizeof(stats));
+}
+
+/////////////////////////////////////////////////////////////////
+// Private Helper Functions
+
+void VecEnv::stepRange(int first, int end)
+	// Play the current step in games first to end-1
+{
+	for(int i = first; i < end; i++)
+	{
+		Game& game = *m_games[i];
+		int action = m_actions[i];
+		int depth = game.dungeon()->level();
+
+		// Playing the turn
+		if(action >= WIELDACTIONS && action < READACTIONS)
+			game.step('w', 'a' + action - WIELDACTIONS);
+		else if(action >= READACTIONS && action < NUMACTIONS)
+			game.step('r', 'a' + action - READACTIONS);
+		else if(action >= 0 && action < WIELDACTIONS)
+			game.step(ACTIONCOMMAND[action]);
+		else
+			game.step('s'); // Unknown actions do nothing
+
+		// Rewarding the turn
+		GameOutcome outcome = game.outcome();
+		float reward = 0;
+		if(outcome.depth > depth) reward += DESCENDREWARD;
+		if(outcome.won) reward += WINREWARD;
+		if(outcome.dead) reward += DEATHREWARD;
+		m_rewards[i] = reward;
+
+		unsigned char done = 0;
+		if(game.isOver()) done = DONETERMINATED;
+		else if(outcome.turns >= m_maxTurns) done = DONETRUNCATED;
+		m_dones[i] = done;
+
+		// Starting the next game of a finished one
+		if(done)
+		{
+			m_episodes[i]++;
+			game.reset(episodeSeed(i));
+		}
+		observe(game, m_observations + size_t(i) * OBSBYTES);
+	}
+}
+
+void VecEnv::workerLoop(int worker)
+	// Play part worker of every step until stopped
+{
+	uint64_t played = 0;
+	for(;;)
+	{
+		{
+			unique_lock<mutex> lock(m_mutex);
+			m_start.wait(lock, [&]{return m_stopping || m_generation != played;});
+			if(m_stopping) return;
+			played = m_generation;
+		}
+
+		stepRange(rangeStart(worker), rangeStart(worker + 1));
+
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_pending--;
+		}
+		m_finish.notify_one();
+	}
+}
+
+int VecEnv::rangeStart(int part) const
+	// First game of part (parts are as even as possible)
+{
+	int numParts = m_workers.size() + 1;
+	return int(int64_t(m_numEnvs) * part / numParts);
+}
+
+uint64_t VecEnv::episodeSeed(int env) const
+	// Seed of the current game of env
+{
+	return mixSeed(mixSeed(m_seed, env), m_episodes[env]);
+}
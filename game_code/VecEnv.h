@@ -0,0 +1,156 @@
+// VecEnv.h
+
+#ifndef VECENV_INCLUDED
+#define VECENV_INCLUDED
+
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "Dungeon.h"
+#include "Monster.h"
+#include "Inventory.h"
+#include "Game.h"
+
+////////////////////////////////////////////////////////////////////
+// Vectorized Environment
+//
+// Plays N independent games in lockstep for reinforcement learning.
+// Observations, rewards and done flags are written into buffers
+// owned by the caller, so a step allocates nothing of its own.
+//
+// Observation of one game (OBSBYTES bytes):
+//   NUMOBSPLANES planes of MAXROWS x MAXCOLS uint8 cells (1 where
+//   the plane's thing is, 0 elsewhere), then NUMOBSSTATS int32
+//   player stats.
+////////////////////////////////////////////////////////////////////
+
+// Planes of an observation
+enum ObsPlane
+{
+	WALLPLANE,                                  // Walls (and outside the level)
+	MONSTERPLANES,                              // One plane per MonsterKind
+	OBJECTPLANE = MONSTERPLANES + NUMMONSTERKINDS, // Weapons and scrolls
+	PLAYERPLANE,
+	STAIRPLANE,
+	IDOLPLANE,
+	NUMOBSPLANES
+};
+
+// Player stats following the planes
+enum ObsStat
+{
+	HITSTAT, ARMORSTAT, STRENGTHSTAT, DEXTERITYSTAT, LEVELSTAT,
+	NUMOBSSTATS
+};
+
+const int OBSPLANEBYTES = NUMOBSPLANES * MAXROWS * MAXCOLS;
+const int OBSBYTES = OBSPLANEBYTES + NUMOBSSTATS * sizeof(int32_t);
+
+// Actions of the player
+enum Action
+{
+	MOVEUP, MOVEDOWN, MOVELEFT, MOVERIGHT,
+	PICKUP,   // Pick up object or idol
+	DESCEND,  // Go down the stairs
+	WAIT,     // Do nothing
+	WIELDACTIONS,                        // Wield inventory item a, b, ...
+	READACTIONS = WIELDACTIONS + MAXINVENTORY, // Read inventory item a, b, ...
+	NUMACTIONS = READACTIONS + MAXINVENTORY
+};
+
+// Rewards
+const float WINREWARD = 1.0f;      // Golden idol picked up
+const float DEATHREWARD = -1.0f;   // Player killed
+const float DESCENDREWARD = 0.1f;  // New level reached
+
+// Done flags
+const unsigned char DONETERMINATED = 1; // Game won or lost
+const unsigned char DONETRUNCATED = 2;  // Game stopped at the turn limit
+
+////////////////////////////////////////////////////////////////////
+// VecEnv Class Declaration
+////////////////////////////////////////////////////////////////////
+
+class VecEnv
+{
+  public:
+	/////////////////////////////////////////////////////////////////
+	// Constructor and Destructor
+
+	// Games are stepped by numThreads threads (the caller's thread
+	// being one of them). Games longer than maxTurns are truncated.
+	VecEnv(int numEnvs, int goblinSmellDist = 15, int maxTurns = 5000,
+		int numThreads = 1);
+	~VecEnv();
+
+	/////////////////////////////////////////////////////////////////
+	// Accessors
+
+	int numEnvs() const {return m_numEnvs;}
+	const Game& game(int i) const {return *m_games[i];}
+
+	/////////////////////////////////////////////////////////////////
+	// Environment Functions
+
+	// Start every game over, each from its own seed derived from
+	// seed, and write their observations to observations
+	// (numEnvs * OBSBYTES bytes)
+	void reset(uint64_t seed, unsigned char* observations);
+
+	// Play actions[i] in game i, write the new observations, the
+	// rewards and done flags (numEnvs entries each). A finished game
+	// is reset with its next seed, and its observation is then the
+	// first one of the new game.
+	void step(const int* actions, unsigned char* observations,
+		float* rewards, unsigned char* dones);
+
+	/////////////////////////////////////////////////////////////////
+	// Observation Functions
+
+	// Write the observation of game into obs (OBSBYTES bytes)
+	static void observe(const Game& game, unsigned char* obs);
+
+  private:
+	/////////////////////////////////////////////////////////////////
+
+	int m_numEnvs;
+	int m_maxTurns;
+	uint64_t m_seed;
+
+	std::vector<Game*> m_games;
+	std::vector<uint64_t> m_episodes; // Games played by each env
+
+	// Buffers of the step being played
+	const int* m_actions;
+	unsigned char* m_observations;
+	float* m_rewards;
+	unsigned char* m_dones;
+
+	// Worker threads, woken once per step
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_start;
+	std::condition_variable m_finish;
+	uint64_t m_generation; // Steps started
+	int m_pending;         // Workers still on the current step
+	bool m_stopping;
+
+	/////////////////////////////////////////////////////////////////
+	// Private Helper Functions
+
+	void stepRange(int first, int end);
+	void workerLoop(int worker);
+	int rangeStart(int part) const;
+	uint64_t episodeSeed(int env) const;
+
+	// Environments own games and threads, so they are not copied
+	VecEnv(const VecEnv&);
+	VecEnv& operator=(const VecEnv&);
+
+	/////////////////////////////////////////////////////////////////
+};
+
+#endif // VECENV_INCLUDED
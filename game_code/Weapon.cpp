@@ -3,28 +3,33 @@
 #include <cstdlib>
 
 #include "Weapon.h"
+#include "Item.h"
 #include "Actor.h"
+#include "Dungeon.h"
+#include "Definitions.h"
 #include "utilities.h"
 
 using namespace std;
 
 ////////////////////////////////////////////////////////////////////
-// Weapon Class Implementations
+// Weapon Record Implementations
 ////////////////////////////////////////////////////////////////////
 
-string SleepFangs::specialMove(Actor* attacker, Actor* defender)
-	// Put the defender to sleep with a 1 in 5 chance
+WeaponItem makeWeapon(WeaponKind kind)
 {
-	if(trueWithProbability(1.0/5.0))
-	{
-		int newSleepTime = randInt(2, 6);
-		// If the new sleep time is greater than the old one
-		if(newSleepTime > defender->sleepPts())
-		{
-			// Put defender to sleep for the longer time
-			defender->setSleepPts(newSleepTime);
-			return ", putting " + defender->name() + " to sleep.";
-		}
-	}
-	return "."; // Indicating nothing else happened
-}
\ No newline at end of file
+	WeaponItem weapon;
+	weapon.kind = kind;
+	weapon.dmg = definitions().weapons[kind].damage;
+	weapon.dexBns = definitions().weapons[kind].dexterityBonus;
+	return weapon;
+}
+
+string WeaponItem::name() const
+{
+	return definitions().weapons[kind].name;
+}
+
+string WeaponItem::action() const
+{
+	return definitions().weapons[kind].action;
+}
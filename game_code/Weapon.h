@@ -5,13 +5,13 @@
 
 #include <string>
 #include "GameObject.h"
-
-class Actor;
-
-const char WEAPON = ')';
+#include "Item.h"
 
 ////////////////////////////////////////////////////////////////////
-// Base Weapon Class Declarations
+// Weapon Class Declaration
+//
+// A weapon lying in the dungeon. The weapon itself is the
+// WeaponItem record, which is what actors wield and carry.
 ////////////////////////////////////////////////////////////////////
 
 class Weapon : public GameObject
@@ -19,115 +19,30 @@ class Weapon : public GameObject
   public:
   	/////////////////////////////////////////////////////////////////
 	// Constructor and Destructor
-	Weapon(int row, int col, Dungeon* dungeon, int dmg, int dexBns)
+	Weapon(int row, int col, Dungeon* dungeon, WeaponKind kind)
 		: GameObject(row, col, dungeon),
-		  m_dmg(dmg), m_dexBns(dexBns)
+		  m_weapon(makeWeapon(kind))
 	{}
 
 	virtual ~Weapon() {}
 
-	// Symbol
-	virtual char symbol() const {return WEAPON;}
+	// Name, symbol and item record
+	virtual std::string name() const {return m_weapon.name();}
+	virtual char symbol() const      {return WEAPON;}
+	virtual Item item() const        {return makeItem(m_weapon);}
 
 	/////////////////////////////////////////////////////////////////
 	// Accessors
-	int damageAmt() const {return m_dmg;}
-	int dexterityBns() const {return m_dexBns;}
-	
-	/////////////////////////////////////////////////////////////////
-	// Game Functions
-	
-	// Every weapon has a unique action
-	virtual std::string action() const = 0;
-	
-	// Most weapons don't have a special move,
-	// so indicating nothing happens
-	virtual std::string specialMove(Actor* attacker, Actor* defender) {return ".";}
- 
+	int damageAmt() const    {return m_weapon.damageAmt();}
+	int dexterityBns() const {return m_weapon.dexterityBns();}
+	std::string action() const {return m_weapon.action();}
+
   private:
 	/////////////////////////////////////////////////////////////////
 
-	int m_dmg;
-	int m_dexBns;
+	WeaponItem m_weapon;
 
 	/////////////////////////////////////////////////////////////////
 };
 
-////////////////////////////////////////////////////////////////////
-// Derived Weapon Classes
-////////////////////////////////////////////////////////////////////
-
-class ShortSword : public Weapon
-{
-  public:
-	ShortSword(int row, int col, Dungeon* dungeon)
-	: Weapon(row, col, dungeon, 2 /*dmg*/, 0 /*dexBns*/)
-	{}
-
-	// Name and action
-	virtual std::string name() const 
-		{return "short sword";}
-	virtual std::string action() const 
-		{return "slashes short sword at";}
-};
-
-class LongSword : public Weapon
-{
-  public:
-	LongSword(int row, int col, Dungeon* dungeon)
-	: Weapon(row, col, dungeon, 4 /*dmg*/, 2 /*dexBns*/)
-	{}
-
-	// Name and action
-	virtual std::string name() const 
-		{return "long sword";}
-	virtual std::string action() const 
-		{return "swings long sword at";}
-};
-
-class Mace : public Weapon
-{
-  public:
-	Mace(int row, int col, Dungeon* dungeon)
-	: Weapon(row, col, dungeon, 2 /*dmg*/, 0 /*dexBns*/)
-	{}
-
-	// Name and action
-	virtual std::string name() const 
-		{return "mace";}
-	virtual std::string action() const 
-		{return "swings mace";}
-};
-
-class MagicAxe : public Weapon
-{
-  public:
-	MagicAxe(int row, int col, Dungeon* dungeon)
-	: Weapon(row, col, dungeon, 5 /*dmg*/, 5 /*dexBns*/)
-	{}
-
-	// Name and action
-	virtual std::string name() const 
-		{return "magic axe";}
-	virtual std::string action() const 
-		{return "chops magic axe at";}	
-};
-
-class SleepFangs : public Weapon
-{
-  public:
-	SleepFangs(int row, int col, Dungeon* dungeon)
-	: Weapon(row, col, dungeon, 3 /*dmg*/, 3 /*dexBns*/)
-	{}
-
-	// Name and action
-	virtual std::string name() const 
-		{return "magic fangs of sleep";}
-	virtual std::string action() const 
-		{return "strikes magic fangs at";}
-
-	// SleepFangs have special effects
-	virtual std::string specialMove(Actor* attacker, Actor* defender);
-};
-
-#endif // WEAPON_INCLUDED
\ No newline at end of file
+#endif // WEAPON_INCLUDED
@@ -0,0 +1,163 @@
+// archive_dump.cpp
+//
+// Prints the contents of a level archive: record counts, a summary
+// of the levels and outcomes, and any level picked by index.
+// With -verify, regenerates every level from its seed and checks
+// that the archive holds the same terrain and spawns, and checks that
+// every outcome is sound and reads back the same after writing it to
+// a scratch archive.
+//
+// Usage: archive_dump <archive> [level index ... | -verify]
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <string>
+
+#include "LevelGenerator.h"
+#include "LevelArchive.h"
+#include "Monster.h"
+
+using namespace std;
+
+const char* STYLENAMES[NUMLEVELSTYLES] = {"room row", "bsp rooms", "caves"};
+
+bool sameLevel(const Level& a, const Level& b)
+	// Compare everything that an archive stores
+{
+	if(a.seed != b.seed || a.style != b.style || a.depth != b.depth
+		|| a.rows != b.rows || a.cols != b.cols
+		|| a.stairRow != b.stairRow || a.stairCol != b.stairCol
+		|| a.playerRow != b.playerRow || a.playerCol != b.playerCol
+		|| a.numSpawns != b.numSpawns
+		|| memcmp(a.spawns, b.spawns, a.numSpawns*sizeof(Spawn)) != 0)
+		return false;
+	for(int i = 0; i < a.rows; i++)
+		if(memcmp(a.grid[i], b.grid[i], a.cols) != 0)
+			return false;
+	return true;
+}
+
+bool sameOutcome(const GameOutcome& a, const GameOutcome& b)
+	// Compare everything that an archive stores
+{
+	return a.won == b.won && a.dead == b.dead && a.killedBy == b.killedBy
+		&& a.depth == b.depth && a.turns == b.turns;
+}
+
+bool soundOutcome(const GameOutcome& outcome)
+{
+	return !(outcome.won && outcome.dead) && outcome.depth >= 0 && outcome.turns >= 0
+		&& outcome.killedBy >= -1 && outcome.killedBy < NUMMONSTERKINDS
+		&& (outcome.killedBy < 0 || outcome.dead);
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc < 2)
+	{
+		cerr << "Usage: archive_dump <archive> [level index ... | -verify]" << endl;
+		return 1;
+	}
+	ArchiveReader reader(argv[1]);
+
+	// Summarising all records
+	long long styles[NUMLEVELSTYLES] = {};
+	long long spawns = 0;
+	for(size_t i = 0; i < reader.numLevels(); i++)
+	{
+		LevelView view = reader.level(i);
+		if(view.style() >= 0 && view.style() < NUMLEVELSTYLES)
+			styles[view.style()]++;
+		spawns += view.numSpawns();
+	}
+	long long won = 0, dead = 0, turns = 0;
+	for(size_t i = 0; i < reader.numOutcomes(); i++)
+	{
+		GameOutcome outcome = reader.outcome(i);
+		won += outcome.won;
+		dead += outcome.dead;
+		turns += outcome.turns;
+	}
+
+	cout << reader.numLevels() << " levels";
+	for(int s = 0; s < NUMLEVELSTYLES; s++)
+		cout << ", " << styles[s] << " " << STYLENAMES[s];
+	if(reader.numLevels() > 0)
+		cout << ", " << double(spawns) / reader.numLevels() << " spawns per level";
+	cout << endl;
+	cout << reader.numOutcomes() << " outcomes, " << won << " won, "
+		 << dead << " dead";
+	if(reader.numOutcomes() > 0)
+		cout << ", " << double(turns) / reader.numOutcomes() << " turns per game";
+	cout << endl;
+
+	for(int a = 2; a < argc; a++)
+	{
+		if(string(argv[a]) == "-verify")
+		{
+			// Regenerating every level from its seed
+			Level stored, fresh;
+			size_t mismatches = 0;
+			for(size_t i = 0; i < reader.numLevels(); i++)
+			{
+				LevelView view = reader.level(i);
+				view.toLevel(stored);
+				levelGenerator(view.style()).generate(view.seed(), view.depth(),
+					fresh, view.rows(), view.cols());
+				if(!sameLevel(stored, fresh))
+					mismatches++;
+			}
+			cout << "verify: " << mismatches << " of " << reader.numLevels()
+				 << " levels differ from their seed" << endl;
+
+			// Writing the outcomes to a scratch archive and reading them back
+			size_t unsound = 0, changed = 0;
+			string scratch = string(argv[1]) + ".verify";
+			remove(scratch.c_str());
+			{
+				ArchiveWriter writer(scratch, 1000);
+				for(size_t i = 0; i < reader.numOutcomes(); i++)
+					writer.addOutcome(reader.outcome(i));
+				if(!writer.flush())
+				{
+					cerr << "Error: Can't write scratch archive " << scratch << endl;
+					return 1;
+				}
+			}
+			{
+				ArchiveReader copy(scratch);
+				if(copy.numOutcomes() != reader.numOutcomes())
+					changed = reader.numOutcomes();
+				else
+					for(size_t i = 0; i < reader.numOutcomes(); i++)
+					{
+						GameOutcome outcome = reader.outcome(i);
+						unsound += !soundOutcome(outcome);
+						changed += !sameOutcome(outcome, copy.outcome(i));
+					}
+			}
+			remove(scratch.c_str());
+			cout << "verify: " << unsound << " of " << reader.numOutcomes()
+				 << " outcomes unsound, " << changed << " changed by a round trip" << endl;
+			if(mismatches > 0 || unsound > 0 || changed > 0) return 1;
+			continue;
+		}
+
+		size_t index = strtoull(argv[a], nullptr, 10);
+		if(index >= reader.numLevels())
+		{
+			cerr << "Error: No level " << index << endl;
+			return 1;
+		}
+		Level level;
+		reader.level(index).toLevel(level);
+		cout << "level " << index << ": seed " << level.seed << ", "
+			 << STYLENAMES[level.style] << ", depth " << level.depth
+			 << ", " << level.numSpawns << " spawns" << endl;
+		for(int i = 0; i < level.rows; i++)
+			cout << string(level.grid[i], level.cols) << endl;
+	}
+	return 0;
+}
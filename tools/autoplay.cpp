@@ -0,0 +1,120 @@
+// autoplay.cpp
+//
+// Plays games with the Monte Carlo tree search player (MctsPlayer.h)
+// and reports how they went and how long decisions took.
+// With -show the games are watched on the terminal, with -json they
+// are streamed as JSON lines on standard output (the report then goes
+// to standard error). Either way a Spectator (Spectator.h) shows at
+// most -fps frames a second, so watching doesn't slow the games down.
+// With -broadcast every turn is published into shared memory for any
+// number of spectate processes to watch (Broadcast.h).
+//
+// Usage: autoplay [games] [threads] [rollouts] [milliseconds] [seed]
+//                 [-show | -json] [-fps frames] [-broadcast name]
+
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+#include "Game.h"
+#include "GameState.h"
+#include "Dungeon.h"
+#include "MctsPlayer.h"
+#include "Spectator.h"
+#include "Broadcast.h"
+
+using namespace std;
+
+const int MAXTURNS = 3000; // Games still going are stopped here
+
+int main(int argc, char* argv[])
+{
+	bool show = false, json = false;
+	double fps = 30;
+	string broadcastName;
+	vector<string> args;
+	for(int a = 1; a < argc; a++)
+	{
+		string arg = argv[a];
+		if(arg == "-show") show = true;
+		else if(arg == "-json") json = true;
+		else if(arg == "-fps" && a + 1 < argc) fps = atof(argv[++a]);
+		else if(arg == "-broadcast" && a + 1 < argc) broadcastName = argv[++a];
+		else args.push_back(arg);
+	}
+	int numGames = (args.size() > 0) ? atoi(args[0].c_str()) : 10;
+	MctsOptions options;
+	if(args.size() > 1) options.numThreads = atoi(args[1].c_str());
+	if(args.size() > 2) options.maxRollouts = atoi(args[2].c_str());
+	if(args.size() > 3) options.maxSeconds = atof(args[3].c_str()) / 1000;
+	uint64_t seed = (args.size() > 4) ? strtoull(args[4].c_str(), nullptr, 10) : 1;
+
+	ostream& report = json ? cerr : cout;
+	TtyFrameSink ttySink;
+	JsonFrameSink jsonSink(cout);
+	Spectator* spectator = nullptr;
+	if(show || json)
+		spectator = new Spectator(json ? (FrameSink*)&jsonSink : &ttySink, fps);
+	Broadcaster* broadcaster = nullptr;
+	if(!broadcastName.empty())
+		broadcaster = new Broadcaster(broadcastName);
+	Frame frame;
+
+	MctsPlayer bot(options, seed);
+	int won = 0, dead = 0, levels = 0;
+	long long rollouts = 0;
+	vector<double> latencies;
+
+	for(int g = 0; g < numGames; g++)
+	{
+		Game game(15, mixSeed(seed, g));
+		string result;
+		while(!game.isOver() && game.outcome().turns < MAXTURNS)
+		{
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			PlayerCommand command = bot.decide(game.fork());
+			latencies.push_back(chrono::duration<double>(
+				chrono::steady_clock::now() - start).count());
+			rollouts += bot.lastRollouts();
+
+			result = game.step(command.command, command.choice);
+			if(broadcaster)
+			{
+				game.snapshot(frame, result);
+				broadcaster->publish(frame);
+			}
+			if(spectator && (spectator->wantsFrame() || game.isOver()))
+			{
+				if(!broadcaster) game.snapshot(frame, result);
+				spectator->submit(frame);
+			}
+		}
+
+		GameOutcome outcome = game.outcome();
+		won += outcome.won;
+		dead += outcome.dead;
+		levels += outcome.depth;
+		report << "game " << g << ": " << (outcome.won ? "won" : outcome.dead ? "died" : "stopped")
+			 << " on level " << outcome.depth << " after " << outcome.turns << " turns" << endl;
+	}
+
+	sort(latencies.begin(), latencies.end());
+	size_t n = latencies.size();
+	report << won << " won, " << dead << " died out of " << numGames << ", average level "
+		 << double(levels) / numGames << endl;
+	if(n > 0)
+		report << n << " decisions, " << rollouts / n << " rollouts each, latency p50 "
+			 << latencies[n / 2] * 1000 << " ms, p99 " << latencies[n * 99 / 100] * 1000
+			 << " ms, max " << latencies[n - 1] * 1000 << " ms" << endl;
+	delete broadcaster;
+	if(spectator)
+	{
+		int submitted = spectator->framesSubmitted();
+		delete spectator; // Shows the last frame
+		report << submitted << " frames submitted for " << n << " turns" << endl;
+	}
+	return 0;
+}
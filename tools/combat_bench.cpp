@@ -0,0 +1,80 @@
+// combat_bench.cpp
+//
+// Times resolving the attacks of a mass battle: batches of attacks
+// between actors with random stats, resolved one at a time with a
+// draw per roll (as attacks were before Combat.h), then together in
+// a CombatBatch. Reports attacks resolved per second each way and
+// checks that both give the same share of hits and damage.
+//
+// Usage: combat_bench [attacks per batch] [batches] [seed]
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <vector>
+#include <chrono>
+
+#include "Combat.h"
+#include "Rng.h"
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+	int batchSize = (argc > 1) ? atoi(argv[1]) : 64;
+	int numBatches = (argc > 2) ? atoi(argv[2]) : 200000;
+	uint64_t seed = (argc > 3) ? strtoull(argv[3], nullptr, 10) : 1;
+	if(batchSize < 1 || batchSize > MAXBATCHATTACKS) batchSize = MAXBATCHATTACKS;
+
+	// A battle's worth of attacks (dexterity and bonus, dexterity and
+	// armor, strength and damage of stats like the definitions')
+	Rng stats(seed);
+	vector<int> attackPts(batchSize), defensePts(batchSize), damageRange(batchSize);
+	for(int i = 0; i < batchSize; i++)
+	{
+		attackPts[i] = stats.randInt(1, 9);
+		defensePts[i] = stats.randInt(2, 8);
+		damageRange[i] = stats.randInt(2, 9);
+	}
+
+	// One at a time
+	Rng rng(seed);
+	uint64_t hits = 0, damage = 0;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for(int b = 0; b < numBatches; b++)
+		for(int i = 0; i < batchSize; i++)
+			if(rng.randInt(1, attackPts[i]) >= rng.randInt(1, defensePts[i]))
+			{
+				hits++;
+				damage += rng.randInt(0, damageRange[i] - 1);
+			}
+	double oneSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	// Batched
+	CombatBatch batch;
+	uint64_t batchHits = 0, batchDamage = 0;
+	start = chrono::steady_clock::now();
+	for(int b = 0; b < numBatches; b++)
+	{
+		batch.clear();
+		for(int i = 0; i < batchSize; i++)
+			batch.add(attackPts[i], defensePts[i], damageRange[i]);
+		batch.resolve(rng);
+		for(int i = 0; i < batchSize; i++)
+		{
+			batchHits += batch.hit(i);
+			batchDamage += batch.damage(i);
+		}
+	}
+	double batchSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	double attacks = double(batchSize) * numBatches;
+	cout << numBatches << " batches of " << batchSize << " attacks\n\n"
+		 << "resolution     attacks/s    hit %   damage/hit\n" << fixed << setprecision(3)
+		 << "one at a time" << setw(12) << attacks / oneSeconds / 1e6 << "M"
+		 << setw(9) << 100 * hits / attacks << setw(13) << double(damage) / hits << '\n'
+		 << "batched      " << setw(12) << attacks / batchSeconds / 1e6 << "M"
+		 << setw(9) << 100 * batchHits / attacks << setw(13) << double(batchDamage) / batchHits
+		 << endl;
+	return 0;
+}
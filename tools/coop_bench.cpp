@@ -0,0 +1,74 @@
+// coop_bench.cpp
+//
+// Plays co-op games (Game.h) with 1, 2, 4, ... up to the given number
+// of players sharing the levels, every player pressing random moves
+// (cheating back to health when low, so the party lasts), and
+// reports how long a turn took for each party size. The monsters go
+// after the nearest player through one search a turn (TargetField.h),
+// so a turn should cost little more with 64 players than with one.
+//
+// Usage: coop_bench [most players] [turns] [seed]
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <vector>
+#include <chrono>
+
+#include "Game.h"
+#include "Player.h"
+#include "Dungeon.h"
+#include "OutcomeStats.h"
+#include "utilities.h"
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+	static const char MOVES[] = {ARROW_UP, ARROW_DOWN, ARROW_LEFT, ARROW_RIGHT};
+
+	int mostPlayers = (argc > 1) ? atoi(argv[1]) : MAXPLAYERS;
+	int numTurns = (argc > 2) ? atoi(argv[2]) : 20000;
+	uint64_t seed = (argc > 3) ? strtoull(argv[3], nullptr, 10) : 1;
+	if(mostPlayers < 1 || mostPlayers > MAXPLAYERS) mostPlayers = MAXPLAYERS;
+
+	cout << "players    turns   games  us/turn   p50 us   p99 us  us/player\n"
+		 << fixed << setprecision(2);
+	for(int numPlayers = 1; ; numPlayers *= 2)
+	{
+		if(numPlayers > mostPlayers) numPlayers = mostPlayers;
+
+		Rng rng(mixSeed(~seed, numPlayers)); // The players' own dice
+		QuantileSketch micros;
+		double seconds = 0;
+		int games = 0;
+		Game* game = nullptr;
+		vector<char> commands(numPlayers);
+		for(int turn = 0; turn < numTurns; turn++)
+		{
+			if(!game || game->isOver())
+			{
+				delete game;
+				game = new Game(15, mixSeed(seed, games++));
+				while(game->numPlayers() < numPlayers && game->addPlayer() != -1)
+					;
+			}
+			for(int p = 0; p < game->numPlayers(); p++)
+				commands[p] = (game->player(p)->hitPts() < 10) ? 'c' : MOVES[rng.randInt(4)];
+
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			game->step(commands.data());
+			double elapsed = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+			micros.add(elapsed);
+			seconds += elapsed / 1e6;
+		}
+		delete game;
+
+		double perTurn = 1e6 * seconds / numTurns;
+		cout << setw(7) << numPlayers << setw(9) << numTurns << setw(8) << games
+			 << setw(9) << perTurn << setw(9) << micros.quantile(0.5)
+			 << setw(9) << micros.quantile(0.99) << setw(11) << perTurn / numPlayers << endl;
+		if(numPlayers == mostPlayers) break;
+	}
+	return 0;
+}
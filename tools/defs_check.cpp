@@ -0,0 +1,21 @@
+// defs_check.cpp
+//
+// Checks a definitions file (Definitions.h) and prints the tables it
+// gives, in the same format. With no file, prints the built-in
+// tables, which makes a starting point for a new file.
+//
+// Usage: defs_check [file]
+
+#include <iostream>
+
+#include "Definitions.h"
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+	if(argc > 1 && !loadDefinitions(argv[1]))
+		return 1;
+	writeDefinitions(cout);
+	return 0;
+}
@@ -0,0 +1,186 @@
+// endless.cpp
+//
+// Plays an endless game (Game.h): with -play on the terminal, by
+// hand, otherwise with a scripted player that walks to a stair and
+// takes it, down or (less often) back up, for the given number of
+// level changes. So that a long run isn't cut short, its monsters
+// are tamed (no strength, short swords) unless -fight is given; they
+// still live on every level and move about as usual. The scripted
+// run reports how long taking the stairs
+// took for levels kept live, packed in memory, read back from the
+// cache file or generated afresh (levels taken back include catching
+// up with the turns they lay dormant), and shows the levels kept in
+// each tier of the LevelCache and the memory used as the game goes
+// deeper.
+//
+// Usage: endless [level changes] [seed] [-hot n] [-warm n]
+//                [-down chance] [-cache file] [-fight] [-play]
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "Game.h"
+#include "Dungeon.h"
+#include "Player.h"
+#include "LevelCache.h"
+#include "Definitions.h"
+#include "utilities.h"
+
+using namespace std;
+
+const int MAXWALK = 2000; // Turns allowed to reach a stair
+
+static long residentKB()
+	// Memory the process has in use (0 where /proc is missing)
+{
+	ifstream statm("/proc/self/statm");
+	long pages = 0, resident = 0;
+	statm >> pages >> resident;
+	return resident * 4;
+}
+
+static char stepToward(const Dungeon& dungeon, int fromRow, int fromCol, char target)
+	// Move command of the first step of a shortest path to a target
+	// cell (monsters on the way are attacked), 0 if there is none
+{
+	static const int DR[4] = {-1, 1, 0, 0};
+	static const int DC[4] = {0, 0, -1, 1};
+	static const char MOVES[4] = {ARROW_UP, ARROW_DOWN, ARROW_LEFT, ARROW_RIGHT};
+
+	// Searching back from the targets, so each cell knows its way
+	int dist[MAXROWS][MAXCOLS];
+	vector<int> queue;
+	for(int i = 0; i < dungeon.rows(); i++)
+		for(int j = 0; j < dungeon.cols(); j++)
+		{
+			bool isTarget = (target == STAIR) ? dungeon.isStair(i, j) : dungeon.isUpStair(i, j);
+			dist[i][j] = isTarget ? 0 : -1;
+			if(isTarget) queue.push_back(MAXCOLS*i + j);
+		}
+	for(size_t q = 0; q < queue.size(); q++)
+	{
+		int row = queue[q] / MAXCOLS, col = queue[q] % MAXCOLS;
+		for(int d = 0; d < 4; d++)
+		{
+			int r = row + DR[d], c = col + DC[d];
+			if(!dungeon.isWall(r, c) && dist[r][c] == -1)
+			{
+				dist[r][c] = dist[row][col] + 1;
+				queue.push_back(MAXCOLS*r + c);
+			}
+		}
+	}
+
+	for(int d = 0; d < 4; d++)
+	{
+		int r = fromRow + DR[d], c = fromCol + DC[d];
+		if(!dungeon.isWall(r, c) && dist[r][c] == dist[fromRow][fromCol] - 1)
+			return MOVES[d];
+	}
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	vector<string> args;
+	int hotLevels = HOTLEVELS, warmLevels = WARMLEVELS;
+	double downChance = 0.55;
+	string cachePath = "endless_levels.tmp";
+	bool play = false, fight = false;
+	for(int a = 1; a < argc; a++)
+	{
+		string arg = argv[a];
+		if(arg == "-hot" && a + 1 < argc) hotLevels = atoi(argv[++a]);
+		else if(arg == "-warm" && a + 1 < argc) warmLevels = atoi(argv[++a]);
+		else if(arg == "-down" && a + 1 < argc) downChance = atof(argv[++a]);
+		else if(arg == "-cache" && a + 1 < argc) cachePath = argv[++a];
+		else if(arg == "-play") play = true;
+		else if(arg == "-fight") fight = true;
+		else args.push_back(arg);
+	}
+	int numChanges = (args.size() > 0) ? atoi(args[0].c_str()) : 2000;
+	uint64_t seed = (args.size() > 1) ? strtoull(args[1].c_str(), nullptr, 10) : 1;
+
+	if(play)
+	{
+		Game game(15, seed, cachePath, hotLevels, warmLevels);
+		game.play();
+		return 0;
+	}
+
+	if(!fight)
+	{
+		Definitions tame = definitions();
+		for(int k = 0; k < NUMMONSTERKINDS; k++)
+		{
+			tame.monsters[k].minStrength = tame.monsters[k].maxStrength = 0;
+			tame.monsters[k].weapon = SHORTSWORD;
+		}
+		setDefinitions(tame);
+	}
+	Game game(15, seed, cachePath, hotLevels, warmLevels);
+
+	// Time taken by the stairs, by where the level came from
+	const char* const SOURCES[] = {"live", "packed", "from file", "generated"};
+	double seconds[4] = {0, 0, 0, 0};
+	int counts[4] = {0, 0, 0, 0};
+
+	Rng rng(mixSeed(~seed, 0)); // The player's own dice
+	long startKB = residentKB();
+	int deepest = 0;
+	cout << "changes  depth  deepest   hot  warm  cold  packed KB  file KB  resident KB\n";
+	for(int change = 1; change <= numChanges && !game.isOver(); change++)
+	{
+		int depth = game.dungeon()->level();
+		bool down = depth == 0 || rng.trueWithProbability(downChance);
+		char target = down ? STAIR : UPSTAIR;
+
+		// Walking to the stair, cheating to stay alive
+		for(int turn = 0; turn < MAXWALK && !game.isOver(); turn++)
+		{
+			const Player* player = game.player();
+			char command = stepToward(*game.dungeon(), player->row(), player->col(), target);
+			if(command == 0) break; // On the stair
+			if(player->hitPts() < 20) command = 'c';
+			game.step(command);
+		}
+		if(game.isOver()) break;
+
+		// Taking it
+		const LevelCache* levels = game.levels();
+		uint64_t before[3] = {levels->hotHits(), levels->warmHits(), levels->coldHits()};
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		game.step(down ? '>' : '<');
+		double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		uint64_t after[3] = {levels->hotHits(), levels->warmHits(), levels->coldHits()};
+		int source = 3;
+		for(int s = 0; s < 3; s++)
+			if(after[s] != before[s]) source = s;
+		seconds[source] += elapsed;
+		counts[source]++;
+
+		if(game.dungeon()->level() > deepest) deepest = game.dungeon()->level();
+		if(change % (numChanges / 10 > 0 ? numChanges / 10 : 1) == 0)
+			cout << setw(7) << change << setw(7) << game.dungeon()->level() << setw(9) << deepest
+				 << setw(6) << levels->numHot() << setw(6) << levels->numWarm()
+				 << setw(6) << levels->numCold() << setw(11) << levels->warmBytes() / 1024
+				 << setw(9) << levels->fileBytes() / 1024 << setw(13) << residentKB() << endl;
+	}
+	if(game.isOver())
+		cout << "The player died on level " << game.dungeon()->level() << endl;
+
+	cout << "\nlevel      changes  mean us\n" << fixed << setprecision(1);
+	for(int s = 0; s < 4; s++)
+		cout << left << setw(10) << SOURCES[s] << right << setw(9) << counts[s]
+			 << setw(9) << (counts[s] ? 1e6 * seconds[s] / counts[s] : 0) << '\n';
+	cout << game.levels()->dormantTurns() << " dormant turns caught up on "
+		 << game.levels()->hotHits() + game.levels()->warmHits() + game.levels()->coldHits()
+		 << " levels taken back\n";
+	cout << "resident memory went from " << startKB << " KB to " << residentKB() << " KB" << endl;
+	return 0;
+}
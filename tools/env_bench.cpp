@@ -0,0 +1,74 @@
+// env_bench.cpp
+//
+// Measures environment steps per second of VecEnv with random
+// actions, and checks that the same seed and actions replay the
+// same observations.
+//
+// Usage: env_bench [envs] [steps] [threads] [seed]
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "VecEnv.h"
+#include "Rng.h"
+
+using namespace std;
+
+// Play steps random steps, returning the number of finished games
+// and leaving the last observations in obs
+long long run(VecEnv& env, uint64_t seed, int steps, vector<unsigned char>& obs)
+{
+	int n = env.numEnvs();
+	vector<int> actions(n);
+	vector<float> rewards(n);
+	vector<unsigned char> dones(n);
+	Rng rng(seed);
+	long long finished = 0;
+
+	env.reset(seed, obs.data());
+	for(int s = 0; s < steps; s++)
+	{
+		// Mostly moves, sometimes any action
+		for(int i = 0; i < n; i++)
+			actions[i] = rng.trueWithProbability(0.9) ? rng.randInt(WIELDACTIONS)
+													  : rng.randInt(NUMACTIONS);
+		env.step(actions.data(), obs.data(), rewards.data(), dones.data());
+		for(int i = 0; i < n; i++)
+			finished += (dones[i] != 0);
+	}
+	return finished;
+}
+
+int main(int argc, char* argv[])
+{
+	int numEnvs = (argc > 1) ? atoi(argv[1]) : 64;
+	int steps = (argc > 2) ? atoi(argv[2]) : 2000;
+	int numThreads = (argc > 3) ? atoi(argv[3]) : thread::hardware_concurrency();
+	uint64_t seed = (argc > 4) ? strtoull(argv[4], nullptr, 10) : 1;
+	if(numEnvs < 1) numEnvs = 1;
+	if(numThreads < 1) numThreads = 1;
+
+	VecEnv env(numEnvs, 15, 1000, numThreads);
+	vector<unsigned char> obs(size_t(numEnvs) * OBSBYTES);
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	long long finished = run(env, seed, steps, obs);
+	chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+	cout << numEnvs << " envs x " << steps << " steps on " << numThreads
+		 << " thread(s) in " << elapsed.count() << " s, "
+		 << (long long)(double(numEnvs) * steps / elapsed.count())
+		 << " env steps/s, " << finished << " games finished" << endl;
+
+	// Replaying on one thread must give the same observations
+	VecEnv replay(numEnvs, 15, 1000, 1);
+	vector<unsigned char> replayObs(obs.size());
+	run(replay, seed, steps, replayObs);
+	bool same = (memcmp(obs.data(), replayObs.data(), obs.size()) == 0);
+	cout << "replay: " << (same ? "same observations" : "OBSERVATIONS DIFFER") << endl;
+	return same ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+// export_levels.cpp
+//
+// Generates levels in batches and appends them to a level archive
+// (see LevelArchive.h). Level i of a run is generated from
+// mixSeed(seed, i), so runs can be split and resumed with first.
+//
+// Usage: export_levels <archive> [levels] [style] [depth] [seed] [first] [threads]
+
+#include <iostream>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "LevelGenerator.h"
+#include "LevelArchive.h"
+
+using namespace std;
+
+const int BATCHLEVELS = 8192; // Levels generated between writes
+
+int main(int argc, char* argv[])
+{
+	if(argc < 2)
+	{
+		cerr << "Usage: export_levels <archive> [levels] [style] [depth] "
+			 << "[seed] [first] [threads]" << endl;
+		return 1;
+	}
+	long long numLevels = (argc > 2) ? atoll(argv[2]) : 1000000;
+	int style = (argc > 3) ? atoi(argv[3]) : ROOMROW;
+	int depth = (argc > 4) ? atoi(argv[4]) : 0;
+	uint64_t seed = (argc > 5) ? strtoull(argv[5], nullptr, 10) : 1;
+	uint64_t first = (argc > 6) ? strtoull(argv[6], nullptr, 10) : 0;
+	int numThreads = (argc > 7) ? atoi(argv[7]) : thread::hardware_concurrency();
+	if(numThreads < 1) numThreads = 1;
+	if(style < 0 || style >= NUMLEVELSTYLES)
+	{
+		cerr << "Error: Level style must be from 0 to " << NUMLEVELSTYLES-1 << endl;
+		return 1;
+	}
+
+	ArchiveWriter writer(argv[1]);
+	vector<Level> levels(BATCHLEVELS);
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for(long long done = 0; done < numLevels; done += BATCHLEVELS)
+	{
+		int count = (int)min<long long>(BATCHLEVELS, numLevels - done);
+		generateLevels(LevelStyle(style), depth, seed, first + done,
+			levels.data(), count, numThreads);
+		for(int i = 0; i < count; i++)
+			writer.addLevel(levels[i]);
+	}
+	if(!writer.flush())
+	{
+		cerr << "Error: Can't write level archive " << argv[1] << endl;
+		return 1;
+	}
+	chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+	cout << numLevels << " levels written to " << argv[1] << " in "
+		 << elapsed.count() << " s, " << (long long)(numLevels / elapsed.count())
+		 << " levels/s" << endl;
+	return 0;
+}
@@ -0,0 +1,127 @@
+// fork_check.cpp
+//
+// Checks that a GameState forked from a Game plays exactly like the
+// Game under random commands, that a Game restored from a state
+// forks back to the same state, and that the hashes a Game and a
+// state keep up to date as they play match each other and the one
+// worked out from every field of a fork, and measures the cost of
+// forking and hashing.
+// With -endless the games are endless ones (going down only, as a
+// state can't go back up).
+//
+// Usage: fork_check [games] [turns per game] [seed] [-endless]
+
+#include <iostream>
+#include <cstdlib>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "Game.h"
+#include "GameState.h"
+#include "Rng.h"
+
+using namespace std;
+
+// Commands tried at random (mostly moves)
+const char COMMANDS[] = "hjklhjklhjklhjklgg>wrc";
+
+int main(int argc, char* argv[])
+{
+	vector<string> args;
+	bool endless = false;
+	for(int a = 1; a < argc; a++)
+	{
+		if(string(argv[a]) == "-endless") endless = true;
+		else args.push_back(argv[a]);
+	}
+	int numGames = (args.size() > 0) ? atoi(args[0].c_str()) : 200;
+	int numTurns = (args.size() > 1) ? atoi(args[1].c_str()) : 500;
+	uint64_t seed = (args.size() > 2) ? strtoull(args[2].c_str(), nullptr, 10) : 1;
+
+	Rng rng(seed);
+	long long turns = 0, mismatches = 0, restoreMismatches = 0, hashMismatches = 0;
+
+	for(int g = 0; g < numGames; g++)
+	{
+		Game* made = endless ? new Game(15, mixSeed(seed, g), "fork_check_levels.tmp")
+			: new Game(15, mixSeed(seed, g));
+		Game& game = *made;
+		GameState state = game.fork();
+
+		for(int t = 0; t < numTurns && !game.isOver(); t++, turns++)
+		{
+			char command = COMMANDS[rng.randInt(sizeof(COMMANDS) - 1)];
+			if(command == 'c' && rng.randInt(20) != 0) command = 's'; // Cheat rarely
+			char choice = 'a' + rng.randInt(4);
+
+			game.step(command, choice);
+			state.step(command, choice);
+			GameState forked = game.fork();
+			if(forked != state)
+			{
+				mismatches++;
+				state = forked; // Carrying on from the game
+				continue;
+			}
+			forked.rehash();
+			if(game.hash() != state.hash() || forked.hash() != state.hash())
+				hashMismatches++;
+		}
+
+		// Restoring a game from its state
+		Game restored(state);
+		if(restored.fork() != state)
+			restoreMismatches++;
+		delete made;
+	}
+
+	cout << numGames << " games, " << turns << " turns: " << mismatches
+		 << " turns where the forked state differs, " << restoreMismatches
+		 << " restored games that differ, " << hashMismatches
+		 << " turns where the hash differs" << endl;
+
+	// Cost of forking
+	Game game(15, seed);
+	const int COPIES = 1000000;
+	vector<GameState> copies(16);
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	GameState state = game.fork();
+	for(int i = 0; i < COPIES; i++)
+	{
+		copies[i & 15] = state;
+		state.turns += copies[(i + 7) & 15].turns & 1; // Keep copies alive
+	}
+	chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+	cout << "GameState is " << sizeof(GameState) << " bytes, copied in "
+		 << elapsed.count() / COPIES * 1e9 << " ns" << endl;
+
+	// Cost of hashing: reading the hash a Game and a state keep, and
+	// working it out from every field
+	const int HASHES = 100000;
+	uint64_t sum = 0;
+	start = chrono::steady_clock::now();
+	for(int i = 0; i < HASHES; i++)
+		sum += game.hash();
+	chrono::duration<double> gameRead = chrono::steady_clock::now() - start;
+	start = chrono::steady_clock::now();
+	for(int i = 0; i < HASHES; i++)
+	{
+		copies[i & 15].turns += sum & 1; // Reading a state in memory
+		sum += copies[i & 15].hash();
+	}
+	chrono::duration<double> read = chrono::steady_clock::now() - start;
+	start = chrono::steady_clock::now();
+	for(int i = 0; i < HASHES; i++)
+	{
+		state.rehash();
+		sum += state.hash();
+	}
+	chrono::duration<double> rehashed = chrono::steady_clock::now() - start;
+	state.turns += sum & 1; // Keep the hashes alive
+	cout << "Hash read from a game in " << gameRead.count() / HASHES * 1e9
+		 << " ns, from a state in " << read.count() / HASHES * 1e9
+		 << " ns, worked out in " << rehashed.count() / HASHES * 1e9 << " ns" << endl;
+
+	return (mismatches == 0 && restoreMismatches == 0 && hashMismatches == 0) ? 0 : 1;
+}
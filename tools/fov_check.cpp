@@ -0,0 +1,120 @@
+// fov_check.cpp
+//
+// Checks that the field of view (FieldOfView.h) is symmetric on
+// generated levels of every style: from every open cell of a level,
+// every open cell seen must see the viewer back, and the viewer must
+// see its own cell. Then times working out a field of view against
+// the time a whole turn of a game takes, the field of view being
+// worked out once a turn.
+//
+// Usage: fov_check [levels per style] [seed] [radius]
+
+#include <iostream>
+#include <cstdlib>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "FieldOfView.h"
+#include "LevelGenerator.h"
+#include "Game.h"
+#include "Player.h"
+#include "Rng.h"
+
+using namespace std;
+
+const char* STYLENAMES[NUMLEVELSTYLES] = {"room row", "bsp rooms", "caves"};
+
+// Commands tried at random for the timing games (mostly moves)
+const char COMMANDS[] = "hjklhjklhjklhjklgg>wr";
+
+const int TIMEDGAMES = 100;
+const int TIMEDTURNS = 500;
+
+typedef bool Visible[MAXROWS][MAXCOLS];
+
+int main(int argc, char* argv[])
+{
+	int numLevels = (argc > 1) ? atoi(argv[1]) : 300;
+	uint64_t seed = (argc > 2) ? strtoull(argv[2], nullptr, 10) : 1;
+	int radius = (argc > 3) ? atoi(argv[3]) : FOVRADIUS;
+	if(radius < 1 || radius > MAXFOVRADIUS)
+	{
+		cerr << "Error: Radius must be from 1 to " << MAXFOVRADIUS << endl;
+		return 1;
+	}
+
+	// Symmetry, from every open cell of every level
+	long long totalPairs = 0, totalAsymmetric = 0;
+	Level level;
+	vector<Visible> seen(MAXROWS * MAXCOLS);
+	for(int s = 0; s < NUMLEVELSTYLES; s++)
+	{
+		long long pairs = 0, asymmetric = 0;
+		for(int l = 0; l < numLevels; l++)
+		{
+			levelGenerator(LevelStyle(s)).generate(mixSeed(seed, l), l % 8, level);
+			int rows = level.rows, cols = level.cols;
+			for(int i = 0; i < rows; i++)
+				for(int j = 0; j < cols; j++)
+					if(level.grid[i][j] != WALL)
+						computeFieldOfView(level.grid, rows, cols, i, j, radius,
+							seen[i * MAXCOLS + j]);
+
+			for(int i = 0; i < rows; i++)
+				for(int j = 0; j < cols; j++)
+				{
+					if(level.grid[i][j] == WALL) continue;
+					const Visible& from = seen[i * MAXCOLS + j];
+					if(!from[i][j]) asymmetric++;
+					for(int r = max(0, i - radius); r <= min(rows - 1, i + radius); r++)
+						for(int c = max(0, j - radius); c <= min(cols - 1, j + radius); c++)
+							if(level.grid[r][c] != WALL && from[r][c])
+							{
+								pairs++;
+								if(!seen[r * MAXCOLS + c][i][j])
+									asymmetric++;
+							}
+				}
+		}
+		cout << STYLENAMES[s] << ": " << numLevels << " levels, " << pairs
+			 << " cells seen, " << asymmetric << " not seeing the viewer back" << endl;
+		totalPairs += pairs;
+		totalAsymmetric += asymmetric;
+	}
+
+	// Time a field of view takes against the time a turn takes
+	Rng rng(seed);
+	double turnSecs = 0, fovSecs = 0;
+	long long turns = 0;
+	Visible visible;
+	for(int g = 0; g < TIMEDGAMES; g++)
+	{
+		Game game(15, mixSeed(~seed, g));
+		for(int t = 0; t < TIMEDTURNS && !game.isOver(); t++, turns++)
+		{
+			char command = COMMANDS[rng.randInt(sizeof(COMMANDS) - 1)];
+			char choice = 'a' + rng.randInt(4);
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			game.step(command, choice);
+			turnSecs += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+			const Dungeon& dungeon = *game.dungeon();
+			const Player* player = game.player(0);
+			char grid[MAXROWS][MAXCOLS];
+			for(int i = 0; i < dungeon.rows(); i++)
+				for(int j = 0; j < dungeon.cols(); j++)
+					grid[i][j] = dungeon.isWall(i, j) ? WALL : ' ';
+			start = chrono::steady_clock::now();
+			computeFieldOfView(grid, dungeon.rows(), dungeon.cols(),
+				player->row(), player->col(), radius, visible);
+			fovSecs += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		}
+	}
+	if(turns > 0)
+		cout << "Field of view: " << fovSecs / turns * 1e6 << " us, a turn "
+			 << turnSecs / turns * 1e6 << " us (" << 100 * fovSecs / turnSecs
+			 << "% of it)" << endl;
+
+	return (totalAsymmetric == 0) ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+// input_latency.cpp
+//
+// Plays a game with keys pressed on a fixed schedule (random moves,
+// picking up and the odd look at the inventory) against a screen
+// that takes a while to draw each frame, once with reading, playing
+// and drawing all on one thread, the way the game was first played,
+// and once split over three threads (Pipeline.h). Reports the time
+// from each key being pressed to its frame being on the screen, and
+// the frames drawn and skipped.
+//
+// Usage: input_latency [keys] [seed] [-every ms] [-draw ms]
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+
+#include "Game.h"
+#include "Pipeline.h"
+#include "Spectator.h"
+#include "OutcomeStats.h"
+#include "utilities.h"
+
+using namespace std;
+
+// Presses a key every interval from the first read on, then 'q'.
+// Keys are stamped with when they were due, so keys waiting behind
+// a slow turn count the wait.
+class ScheduledKeys : public KeySource
+{
+  public:
+	ScheduledKeys(int numKeys, uint64_t seed, chrono::microseconds interval)
+		: m_rng(seed), m_numKeys(numKeys), m_pressed(0), m_interval(interval)
+	{}
+
+	virtual char read(TimePoint& pressed)
+	{
+		static const char KEYS[] = {ARROW_UP, ARROW_DOWN, ARROW_LEFT, ARROW_RIGHT,
+			ARROW_UP, ARROW_DOWN, ARROW_LEFT, ARROW_RIGHT, 'g', 'i'};
+
+		if(m_pressed == 0) m_start = chrono::steady_clock::now();
+		pressed = m_start + m_pressed * m_interval;
+		this_thread::sleep_until(pressed);
+		if(m_pressed++ >= m_numKeys) return 'q';
+		return KEYS[m_rng.randInt(sizeof(KEYS))];
+	}
+
+  private:
+	Rng m_rng;
+	int m_numKeys;
+	int m_pressed;
+	chrono::microseconds m_interval;
+	TimePoint m_start;
+};
+
+// Throws frames away after taking drawTime to draw each
+class SlowFrameSink : public FrameSink
+{
+  public:
+	SlowFrameSink(chrono::microseconds drawTime) : m_drawTime(drawTime), m_drawn(0) {}
+	virtual void write(const Frame& frame) {draw();}
+	virtual void writeInventory(const Inventory& inventory) {draw();}
+	int drawn() const {return m_drawn;}
+
+  private:
+	chrono::microseconds m_drawTime;
+	int m_drawn;
+
+	void draw() {this_thread::sleep_for(m_drawTime); m_drawn++;}
+};
+
+int main(int argc, char* argv[])
+{
+	vector<string> args;
+	double everyMs = 20, drawMs = 30;
+	for(int a = 1; a < argc; a++)
+	{
+		string arg = argv[a];
+		if(arg == "-every" && a + 1 < argc) everyMs = atof(argv[++a]);
+		else if(arg == "-draw" && a + 1 < argc) drawMs = atof(argv[++a]);
+		else args.push_back(arg);
+	}
+	int numKeys = (args.size() > 0) ? atoi(args[0].c_str()) : 300;
+	uint64_t seed = (args.size() > 1) ? strtoull(args[1].c_str(), nullptr, 10) : 1;
+	chrono::microseconds every(long(everyMs * 1000)), draw(long(drawMs * 1000));
+
+	cout << numKeys << " keys every " << everyMs << " ms, " << drawMs
+		 << " ms to draw a frame\n\n";
+	cout << "pipeline      p50 ms   p99 ms   max ms   drawn  seconds\n"
+		 << fixed << setprecision(2);
+	for(int threaded = 0; threaded < 2; threaded++)
+	{
+		Game game(15, seed);
+		ScheduledKeys keys(numKeys, seed, every);
+		SlowFrameSink sink(draw);
+		QuantileSketch latency;
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		game.play(keys, sink, &latency, threaded);
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		cout << left << setw(12) << (threaded ? "threaded" : "sequential") << right
+			 << setw(8) << latency.quantile(0.5) / 1000 << setw(9) << latency.quantile(0.99) / 1000
+			 << setw(9) << latency.quantile(1) / 1000 << setw(8) << sink.drawn()
+			 << setw(9) << seconds << endl;
+	}
+	return 0;
+}
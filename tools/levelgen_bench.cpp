@@ -0,0 +1,55 @@
+// levelgen_bench.cpp
+//
+// Measures how many levels per second the level generators produce
+// in batches, for every level style, and compares the rate of each
+// thread with TARGETLEVELSPERSEC.
+//
+// Usage: levelgen_bench [levels per style] [threads] [seed]
+
+#include <iostream>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "LevelGenerator.h"
+
+using namespace std;
+
+const char* STYLENAMES[NUMLEVELSTYLES] = {"room row", "bsp rooms", "caves"};
+
+int main(int argc, char* argv[])
+{
+	int numLevels = (argc > 1) ? atoi(argv[1]) : 200000;
+	int numThreads = (argc > 2) ? atoi(argv[2]) : thread::hardware_concurrency();
+	uint64_t seed = (argc > 3) ? strtoull(argv[3], nullptr, 10) : 1;
+	if(numThreads < 1) numThreads = 1;
+
+	vector<Level> levels(numLevels);
+	bool allMet = true;
+
+	for(int style = 0; style < NUMLEVELSTYLES; style++)
+	{
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		generateLevels(LevelStyle(style), 0, seed, 0, levels.data(),
+			numLevels, numThreads);
+		chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+		double rate = numLevels / elapsed.count();
+		bool met = rate / numThreads >= TARGETLEVELSPERSEC;
+		allMet = allMet && met;
+
+		cout << STYLENAMES[style] << ": " << numLevels << " levels in "
+			 << elapsed.count() << " s on " << numThreads << " thread(s), "
+			 << (long long)rate << " levels/s (target "
+			 << TARGETLEVELSPERSEC << " per thread) "
+			 << (met ? "ok" : "BELOW TARGET")
+			 << endl;
+
+		// Printing the first level of the batch as a sample
+		const Level& sample = levels[0];
+		for(int i = 0; i < sample.rows; i++)
+			cout << string(sample.grid[i], sample.cols) << endl;
+	}
+	return allMet ? 0 : 1;
+}
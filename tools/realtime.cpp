@@ -0,0 +1,168 @@
+// realtime.cpp
+//
+// Runs many real-time games (RealTime.h) at once, the way an arcade
+// tournament server would: the games are shared out between the
+// threads, and every thread ticks all of its games on one fixed-
+// timestep clock for the given number of seconds. Each game has a
+// scripted player pressing a random key on a tick with the given
+// chance; games that end start over. Reports how long a game's tick
+// took, how long each thread's ticks took against the tick budget,
+// and the ticks that ran over budget or were dropped. With -play, a
+// real-time game is played by hand on the terminal instead.
+//
+// Usage: realtime [games] [seconds] [seed] [-threads n] [-tick us]
+//                 [-keys chance] [-play]
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+
+#include "Game.h"
+#include "RealTime.h"
+#include "Spectator.h"
+#include "Definitions.h"
+#include "utilities.h"
+
+using namespace std;
+
+// What one thread saw
+struct ThreadReport
+{
+	TickStats clock;           // The thread's ticks (all its games)
+	QuantileSketch gameMicros; // One game's tick
+	uint64_t turns;            // Turns played, games started over
+	uint64_t restarts;
+};
+
+static void runGames(int first, int count, uint64_t seed, int tickMicros,
+	double keyChance, double seconds, ThreadReport& report)
+{
+	static const char KEYS[] = {ARROW_UP, ARROW_DOWN, ARROW_LEFT, ARROW_RIGHT, 'g'};
+
+	vector<Game*> games;
+	vector<char> held(count, 0); // Key each player is waiting to play
+	for(int g = 0; g < count; g++)
+		games.push_back(new Game(15, mixSeed(seed, first + g)));
+	Rng rng(mixSeed(~seed, first)); // The players' own dice
+	uint64_t restarts = 0;
+	report.turns = 0;
+
+	TickClock clock(tickMicros);
+	chrono::steady_clock::time_point end = chrono::steady_clock::now() +
+		chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds));
+	while(chrono::steady_clock::now() < end)
+	{
+		int due = clock.waitForTicks();
+		for(int t = 0; t < due; t++)
+		{
+			TimePoint start = chrono::steady_clock::now();
+			for(int g = 0; g < count; g++)
+			{
+				TimePoint gameStart = chrono::steady_clock::now();
+				Game& game = *games[g];
+				if(!held[g] && rng.trueWithProbability(keyChance))
+					held[g] = KEYS[rng.randInt(sizeof(KEYS))];
+				char command = 0;
+				if(held[g] && game.playerReady())
+				{
+					command = held[g];
+					held[g] = 0;
+				}
+				game.tick(command);
+				if(game.isOver())
+				{
+					report.turns += game.outcome().turns;
+					game.reset(mixSeed(seed, first + g + count * ++restarts));
+				}
+				report.gameMicros.add(chrono::duration<double, micro>(
+					chrono::steady_clock::now() - gameStart).count());
+			}
+			clock.ticked(start);
+		}
+	}
+
+	for(int g = 0; g < count; g++)
+	{
+		report.turns += games[g]->outcome().turns;
+		delete games[g];
+	}
+	report.restarts = restarts;
+	report.clock = clock.stats();
+}
+
+int main(int argc, char* argv[])
+{
+	vector<string> args;
+	int numThreads = thread::hardware_concurrency() ? thread::hardware_concurrency() : 1;
+	int tickMicros = TICKMICROSECONDS;
+	double keyChance = 0.2;
+	bool play = false;
+	for(int a = 1; a < argc; a++)
+	{
+		string arg = argv[a];
+		if(arg == "-threads" && a + 1 < argc) numThreads = atoi(argv[++a]);
+		else if(arg == "-tick" && a + 1 < argc) tickMicros = atoi(argv[++a]);
+		else if(arg == "-keys" && a + 1 < argc) keyChance = atof(argv[++a]);
+		else if(arg == "-play") play = true;
+		else args.push_back(arg);
+	}
+	int numGames = (args.size() > 0) ? atoi(args[0].c_str()) : 1000;
+	double seconds = (args.size() > 1) ? atof(args[1].c_str()) : 5;
+	uint64_t seed = (args.size() > 2) ? strtoull(args[2].c_str(), nullptr, 10) : 1;
+	if(numThreads < 1) numThreads = 1;
+	if(numThreads > numGames) numThreads = numGames > 0 ? numGames : 1;
+	if(tickMicros < 1) tickMicros = TICKMICROSECONDS;
+
+	if(play)
+	{
+		static TerminalKeySource keyboard; // Outlives a reader left waiting on it
+		TtyFrameSink screen;
+		TickStats stats;
+		Game game(15, seed);
+		game.playRealTime(keyboard, screen, &stats);
+		cout << stats.ticks << " ticks, " << stats.overBudget << " over budget, "
+			 << stats.dropped << " dropped" << endl;
+		return 0;
+	}
+
+	cout << numGames << " games on " << numThreads << " threads for " << seconds
+		 << " s, a tick every " << tickMicros << " us\n";
+	vector<ThreadReport> reports(numThreads);
+	vector<thread> threads;
+	for(int t = 0; t < numThreads; t++)
+	{
+		int first = numGames * t / numThreads;
+		int count = numGames * (t + 1) / numThreads - first;
+		threads.push_back(thread(runGames, first, count, seed, tickMicros, keyChance,
+			seconds, ref(reports[t])));
+	}
+	for(size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	TickStats clock;
+	QuantileSketch gameMicros;
+	uint64_t turns = 0, restarts = 0;
+	for(int t = 0; t < numThreads; t++)
+	{
+		clock.merge(reports[t].clock);
+		gameMicros.merge(reports[t].gameMicros);
+		turns += reports[t].turns;
+		restarts += reports[t].restarts;
+	}
+
+	cout << fixed << setprecision(1)
+		 << "\n              p50 us   p99 us   max us\n"
+		 << "game tick  " << setw(9) << gameMicros.quantile(0.5) << setw(9)
+		 << gameMicros.quantile(0.99) << setw(9) << gameMicros.max() << '\n'
+		 << "thread tick" << setw(9) << clock.tickMicros.quantile(0.5) << setw(9)
+		 << clock.tickMicros.quantile(0.99) << setw(9) << clock.tickMicros.max() << "\n\n"
+		 << clock.ticks << " thread ticks, " << clock.overBudget << " over budget ("
+		 << setprecision(3) << (clock.ticks ? 100.0 * clock.overBudget / clock.ticks : 0)
+		 << "%), " << clock.dropped << " dropped\n"
+		 << turns << " turns played, " << restarts << " games started over" << endl;
+	return 0;
+}
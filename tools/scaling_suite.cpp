@@ -0,0 +1,341 @@
+// scaling_suite.cpp
+//
+// Macro benchmark: plays headless games on a catalog of generated
+// scenarios, each sweep scaling one parameter from a common base,
+// and reports turns per second and the p50 and p99 time of a turn
+// at every step, to show where the cost of a turn bends.
+//
+//   size     open level from 6 x 12 up to the largest grid
+//   monsters 1 to 32 goblins on an open level
+//   mix      16 monsters of each kind alone, then all kinds
+//   smell    goblin smell distance from 2 to 30
+//   layout   open level, the three generated level styles, and a
+//            corridor-heavy serpentine
+//   maze     adversarial: goblins shut in pens along the top and
+//            bottom of an open level, the way out of each blocked by
+//            a dragon. Around walls the player is in reach, so every
+//            goblin's search out from the player
+//            (searchFromTarget, Rules.h) fills every cell on a short
+//            enough way to it before finding the way blocked, every
+//            turn, as the smell distance grows
+//
+// Scenarios are built as game states (GameState.h) and played by a
+// Game restored from them, with a player walking at random (and
+// cheating back to health when low, so games last the turns asked).
+// A scenario stops early once it has taken -budget seconds. With
+// -tables the levels get distance tables (DistanceTable.h), built on
+// a worker thread as each game starts.
+//
+// Usage: scaling_suite [turns] [seed] [-sweep name] [-budget seconds]
+//                      [-csv file] [-tables]
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "Game.h"
+#include "GameState.h"
+#include "Player.h"
+#include "LevelGenerator.h"
+#include "Definitions.h"
+#include "OutcomeStats.h"
+#include "utilities.h"
+
+using namespace std;
+
+// Terrain of a scenario
+enum Layout
+{
+	OPENLEVEL, ROOMROWLEVEL, BSPLEVEL, CAVELEVEL, SERPENTINE, PENNED
+};
+
+const char* const LAYOUTNAMES[] = {"open", "rooms", "bsp", "caves", "serpentine", "penned"};
+
+// Pens of the penned layout: PENS columns of them along the top and
+// bottom, PENSPACING apart. A pen is a cell wide and three deep: the
+// goblin at the back, a free cell and the dragon in the way out.
+const int PENS = MAXSTATEMONSTERS / 4;
+const int PENSPACING = MAXCOLS / PENS;
+
+struct Scenario
+{
+	string sweep;
+	string label;   // Value of the parameter scaled
+	Layout layout;
+	int rows, cols;
+	int counts[NUMMONSTERKINDS]; // Monsters of each kind
+	int smell;      // Goblin smell distance
+};
+
+static void carve(Layout layout, uint64_t seed, GameState& state)
+	// Terrain and player position of a scenario
+{
+	int rows = state.rows, cols = state.cols;
+	for(int i = 0; i < rows; i++)
+		for(int j = 0; j < cols; j++)
+			state.grid[i][j] = (i == 0 || j == 0 || i == rows-1 || j == cols-1) ? WALL : ' ';
+	state.player.row = rows / 2;
+	state.player.col = cols / 2;
+
+	switch(layout)
+	{
+		case ROOMROWLEVEL: case BSPLEVEL: case CAVELEVEL:
+		{
+			static const LevelStyle STYLES[] = {ROOMROW, BSPROOMS, CAVES};
+			Level plan;
+			levelGenerator(STYLES[layout - ROOMROWLEVEL]).generate(seed, 0, plan, rows, cols);
+			state.rows = plan.rows; // At least the style's smallest level
+			state.cols = plan.cols;
+			memcpy(state.grid, plan.grid, sizeof(state.grid));
+			state.grid[plan.stairRow][plan.stairCol] = ' ';
+			state.player.row = plan.playerRow;
+			state.player.col = plan.playerCol;
+			break;
+		}
+		case SERPENTINE:
+			// Corridors a cell wide joined at alternate ends
+			for(int i = 2; i < rows-1; i += 2)
+				for(int j = 1; j < cols-1; j++)
+					if(j != ((i / 2) % 2 ? 1 : cols-2))
+						state.grid[i][j] = WALL;
+			state.player.row = 1;
+			state.player.col = 1;
+			break;
+		case PENNED:
+			for(int p = 0; p < PENS; p++)
+			{
+				int c = PENSPACING/2 + p*PENSPACING;
+				for(int i = 1; i <= 3; i++)
+				{
+					state.grid[i][c-1] = state.grid[i][c+1] = WALL;
+					state.grid[rows-1-i][c-1] = state.grid[rows-1-i][c+1] = WALL;
+				}
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+static void addMonster(GameState& state, int kind, int row, int col, Rng& rng)
+{
+	const Definitions& defs = definitions();
+	ActorState& monster = state.monsters[state.numMonsters++];
+	int hit, strength, dexterity;
+	rollMonsterStats(kind, rng, hit, strength, dexterity);
+	monster.hit = hit;
+	monster.maxHit = hit;
+	monster.row = row;
+	monster.col = col;
+	monster.armor = defs.monsters[kind].armor;
+	monster.strength = strength;
+	monster.dexterity = dexterity;
+	monster.sleep = 0;
+	monster.kind = kind;
+	monster.weapon = makeWeapon(WeaponKind(defs.monsters[kind].weapon));
+}
+
+static void build(const Scenario& scenario, uint64_t seed, GameState& state)
+{
+	state.reset(seed, scenario.smell);
+	state.rows = scenario.rows;
+	state.cols = scenario.cols;
+	memset(state.seen, 0, sizeof(state.seen));
+	state.numObjects = 0;
+	carve(scenario.layout, seed, state);
+	Rng rng(mixSeed(seed, 1));
+	state.numMonsters = 0;
+
+	// Penned: a goblin at the back of every pen, a dragon in its way out
+	if(scenario.layout == PENNED)
+	{
+		for(int p = 0; p < PENS; p++)
+		{
+			int c = PENSPACING/2 + p*PENSPACING;
+			addMonster(state, GOBLIN, 1, c, rng);
+			addMonster(state, DRAGON, 3, c, rng);
+			addMonster(state, GOBLIN, state.rows - 2, c, rng);
+			addMonster(state, DRAGON, state.rows - 4, c, rng);
+		}
+		return;
+	}
+
+	// Monsters on free cells at random
+	for(int kind = 0; kind < NUMMONSTERKINDS; kind++)
+		for(int m = 0; m < scenario.counts[kind] && state.numMonsters < MAXSTATEMONSTERS; m++)
+		{
+			int row, col;
+			do{
+				row = rng.randInt(state.rows);
+				col = rng.randInt(state.cols);
+			}while(state.isWall(row, col) || state.monsterAt(row, col) != -1
+				|| (row == state.player.row && col == state.player.col));
+			addMonster(state, kind, row, col, rng);
+		}
+}
+
+static vector<Scenario> catalog()
+{
+	vector<Scenario> scenarios;
+	Scenario base;
+	base.layout = OPENLEVEL;
+	base.rows = MAXROWS;
+	base.cols = MAXCOLS;
+	for(int k = 0; k < NUMMONSTERKINDS; k++)
+		base.counts[k] = 2;
+	base.smell = 15;
+
+	static const int SIZES[][2] = {{6, 12}, {9, 24}, {12, 36}, {15, 52}, {MAXROWS, MAXCOLS}};
+	for(int s = 0; s < 5; s++)
+	{
+		Scenario scenario = base;
+		scenario.sweep = "size";
+		scenario.rows = SIZES[s][0];
+		scenario.cols = SIZES[s][1];
+		scenario.label = to_string(scenario.rows) + "x" + to_string(scenario.cols);
+		scenarios.push_back(scenario);
+	}
+
+	for(int n = 1; n <= MAXSTATEMONSTERS; n *= 2)
+	{
+		Scenario scenario = base;
+		scenario.sweep = "monsters";
+		memset(scenario.counts, 0, sizeof(scenario.counts));
+		scenario.counts[GOBLIN] = n;
+		scenario.label = to_string(n) + " goblins";
+		scenarios.push_back(scenario);
+	}
+
+	for(int kind = 0; kind <= NUMMONSTERKINDS; kind++)
+	{
+		Scenario scenario = base;
+		scenario.sweep = "mix";
+		for(int k = 0; k < NUMMONSTERKINDS; k++)
+			scenario.counts[k] = (kind == NUMMONSTERKINDS) ? 4 : (k == kind) ? 16 : 0;
+		scenario.label = (kind == NUMMONSTERKINDS) ? string("all kinds")
+			: string(definitions().monsters[kind].name);
+		scenarios.push_back(scenario);
+	}
+
+	static const int SMELLS[] = {2, 5, 10, 15, 20, 30};
+	for(int s = 0; s < 6; s++)
+	{
+		Scenario scenario = base;
+		scenario.sweep = "smell";
+		memset(scenario.counts, 0, sizeof(scenario.counts));
+		scenario.counts[GOBLIN] = 8;
+		scenario.smell = SMELLS[s];
+		scenario.label = "smell " + to_string(SMELLS[s]);
+		scenarios.push_back(scenario);
+	}
+
+	for(int layout = OPENLEVEL; layout <= SERPENTINE; layout++)
+	{
+		Scenario scenario = base;
+		scenario.sweep = "layout";
+		scenario.layout = Layout(layout);
+		scenario.label = LAYOUTNAMES[layout];
+		scenarios.push_back(scenario);
+	}
+
+	for(int smell = 4; smell <= 14; smell += 2)
+	{
+		Scenario scenario = base;
+		scenario.sweep = "maze";
+		scenario.layout = PENNED; // Monsters placed by the layout
+		scenario.smell = smell;
+		scenario.label = "smell " + to_string(smell);
+		scenarios.push_back(scenario);
+	}
+	return scenarios;
+}
+
+int main(int argc, char* argv[])
+{
+	static const char MOVES[] = {ARROW_UP, ARROW_DOWN, ARROW_LEFT, ARROW_RIGHT};
+
+	vector<string> args;
+	string only, csvPath;
+	double budget = 2;
+	bool tables = false;
+	for(int a = 1; a < argc; a++)
+	{
+		string arg = argv[a];
+		if(arg == "-sweep" && a + 1 < argc) only = argv[++a];
+		else if(arg == "-budget" && a + 1 < argc) budget = atof(argv[++a]);
+		else if(arg == "-csv" && a + 1 < argc) csvPath = argv[++a];
+		else if(arg == "-tables") tables = true;
+		else args.push_back(arg);
+	}
+	int numTurns = (args.size() > 0) ? atoi(args[0].c_str()) : 2000;
+	uint64_t seed = (args.size() > 1) ? strtoull(args[1].c_str(), nullptr, 10) : 1;
+
+	ofstream csv;
+	if(!csvPath.empty())
+	{
+		csv.open(csvPath.c_str());
+		if(!csv)
+		{
+			cerr << "Error: can't write " << csvPath << endl;
+			return 1;
+		}
+		csv << "sweep,scenario,turns,turns_per_sec,p50_us,p99_us,max_us\n";
+	}
+
+	vector<Scenario> scenarios = catalog();
+	string sweep;
+	cout << fixed;
+	for(size_t s = 0; s < scenarios.size(); s++)
+	{
+		const Scenario& scenario = scenarios[s];
+		if(!only.empty() && scenario.sweep != only) continue;
+		if(scenario.sweep != sweep)
+		{
+			sweep = scenario.sweep;
+			cout << "\n" << sweep << "\n"
+				 << "scenario           turns     turns/s     p50 us     p99 us     max us\n";
+		}
+
+		// Playing the turns, starting over whenever a game ends
+		Rng rng(mixSeed(~seed, s)); // The player's own dice
+		QuantileSketch micros;
+		double seconds = 0;
+		int turns = 0, games = 0;
+		Game* game = nullptr;
+		for(; turns < numTurns && seconds < budget; turns++)
+		{
+			if(!game || game->isOver())
+			{
+				GameState state;
+				build(scenario, mixSeed(seed, games++), state);
+				delete game;
+				game = new Game(state);
+				game->useDistanceTables(tables);
+			}
+			char command = (game->player()->hitPts() < 10) ? 'c' : MOVES[rng.randInt(4)];
+
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			game->step(command);
+			double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+			micros.add(elapsed * 1e6);
+			seconds += elapsed;
+		}
+		delete game;
+
+		cout << left << setw(16) << scenario.label << right << setw(8) << turns
+			 << (turns < numTurns ? "*" : " ") << setprecision(0) << setw(11)
+			 << turns / seconds << setprecision(1) << setw(11) << micros.quantile(0.5)
+			 << setw(11) << micros.quantile(0.99) << setw(11) << micros.max() << endl;
+		if(csv.is_open())
+			csv << scenario.sweep << ',' << scenario.label << ',' << turns << ','
+				<< turns / seconds << ',' << micros.quantile(0.5) << ','
+				<< micros.quantile(0.99) << ',' << micros.max() << '\n';
+	}
+	cout << "\n* stopped after " << budget << " s" << endl;
+	return 0;
+}
@@ -0,0 +1,147 @@
+// sim_stats.cpp
+//
+// Plays many headless games with the scripted seeker player
+// (MctsPlayer.h) on every thread and collects their outcomes into
+// mergeable statistics (OutcomeStats.h), printing the totals so far
+// every second while the run goes on. Statistics can be saved with
+// -save, and saved files from other runs added in with -merge.
+// -defs plays with the monsters and items of a definitions file.
+// -archive appends the outcome of every game, in game order, to a
+// level archive (LevelArchive.h).
+//
+// Usage: sim_stats [games] [threads] [seed] [-defs file] [-save file]
+//                  [-merge file ...] [-archive file]
+
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include "GameState.h"
+#include "MctsPlayer.h"
+#include "OutcomeStats.h"
+#include "Definitions.h"
+#include "LevelArchive.h"
+
+using namespace std;
+
+const int MAXTURNS = 5000;  // Games still going are stopped here
+const int MERGEGAMES = 64;  // Games a thread plays between merges
+
+static void playGames(uint64_t seed, int numGames, atomic<int>* nextGame,
+	LiveStats* live, vector<GameOutcome>* outcomes)
+	// Play games until there are none left, merging their outcomes
+	// into live every MERGEGAMES games (and keeping each game's in
+	// outcomes, if given)
+{
+	OutcomeStats stats;
+	GameState state;
+	for(;;)
+	{
+		int g = (*nextGame)++;
+		if(g >= numGames) break;
+
+		state.reset(mixSeed(seed, g), 15);
+		Rng rng(mixSeed(~seed, g)); // The player's own dice
+		while(!state.isOver() && state.turns < MAXTURNS)
+		{
+			PlayerCommand command = seekerCommand(state, rng);
+			state.step(command.command, command.choice);
+		}
+		stats.add(state.outcome());
+		if(outcomes) (*outcomes)[g] = state.outcome();
+
+		if(stats.games == MERGEGAMES)
+		{
+			live->merge(stats);
+			stats = OutcomeStats();
+		}
+	}
+	live->merge(stats);
+}
+
+int main(int argc, char* argv[])
+{
+	vector<string> args, mergePaths;
+	string savePath, archivePath;
+	for(int a = 1; a < argc; a++)
+	{
+		string arg = argv[a];
+		if(arg == "-save" && a + 1 < argc) savePath = argv[++a];
+		else if(arg == "-archive" && a + 1 < argc) archivePath = argv[++a];
+		else if(arg == "-defs" && a + 1 < argc)
+		{
+			if(!loadDefinitions(argv[++a])) return 1;
+		}
+		else if(arg == "-merge")
+			while(a + 1 < argc && argv[a + 1][0] != '-')
+				mergePaths.push_back(argv[++a]);
+		else args.push_back(arg);
+	}
+	int numGames = (args.size() > 0) ? atoi(args[0].c_str()) : 10000;
+	int numThreads = (args.size() > 1) ? atoi(args[1].c_str()) : thread::hardware_concurrency();
+	uint64_t seed = (args.size() > 2) ? strtoull(args[2].c_str(), nullptr, 10) : 1;
+	if(numThreads < 1) numThreads = 1;
+
+	LiveStats live;
+	for(size_t f = 0; f < mergePaths.size(); f++)
+	{
+		OutcomeStats saved;
+		if(!saved.load(mergePaths[f]))
+		{
+			cerr << "Error: Can't read statistics from " << mergePaths[f] << endl;
+			return 1;
+		}
+		live.merge(saved);
+	}
+
+	// Playing, with a look at the totals every second
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	atomic<int> nextGame(0);
+	vector<GameOutcome> outcomes(archivePath.empty() ? 0 : numGames);
+	vector<thread> workers;
+	for(int t = 0; t < numThreads; t++)
+		workers.push_back(thread(playGames, seed, numGames, &nextGame, &live,
+			archivePath.empty() ? nullptr : &outcomes));
+	chrono::steady_clock::time_point nextReport = start + chrono::seconds(1);
+	while(nextGame.load() < numGames)
+	{
+		this_thread::sleep_for(chrono::milliseconds(20));
+		if(chrono::steady_clock::now() < nextReport)
+			continue;
+		nextReport += chrono::seconds(1);
+		OutcomeStats sofar = live.snapshot();
+		cout << sofar.games << " games so far, win rate " << 100 * sofar.winRate()
+			 << "%, median depth " << sofar.depthReached.quantile(0.5) << endl;
+	}
+	for(size_t t = 0; t < workers.size(); t++)
+		workers[t].join();
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	OutcomeStats total = live.snapshot();
+	total.print(cout);
+	cout << numGames << " games played in " << seconds << " s ("
+		 << numGames / seconds << " games/s), statistics take "
+		 << sizeof(OutcomeStats) << " bytes" << endl;
+
+	if(!savePath.empty() && !total.save(savePath))
+	{
+		cerr << "Error: Can't save statistics to " << savePath << endl;
+		return 1;
+	}
+	if(!archivePath.empty())
+	{
+		ArchiveWriter writer(archivePath);
+		for(size_t g = 0; g < outcomes.size(); g++)
+			writer.addOutcome(outcomes[g]);
+		if(!writer.flush())
+		{
+			cerr << "Error: Can't write outcomes to " << archivePath << endl;
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,64 @@
+// spectate.cpp
+//
+// Watches a game broadcast into shared memory (Broadcast.h), for
+// example by autoplay -broadcast. Shows the newest frame at most
+// -fps times a second on the terminal, or every frame in order as
+// JSON lines with -json. Any number of spectators can watch the
+// same game without slowing it down.
+//
+// Usage: spectate [name] [-fps frames] [-json]
+
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <chrono>
+
+#include "Broadcast.h"
+#include "Spectator.h"
+#include "utilities.h"
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+	string name = "/minirouge";
+	double fps = 30;
+	bool json = false;
+	for(int a = 1; a < argc; a++)
+	{
+		string arg = argv[a];
+		if(arg == "-json") json = true;
+		else if(arg == "-fps" && a + 1 < argc) fps = atof(argv[++a]);
+		else name = arg;
+	}
+	if(fps <= 0) fps = 30;
+
+	BroadcastViewer viewer(name);
+	Frame frame;
+	chrono::steady_clock::duration interval = chrono::duration_cast<chrono::steady_clock::duration>(
+		chrono::duration<double>(1 / fps));
+
+	for(;;)
+	{
+		// Checking for the end first, so no frame published before it is lost
+		bool closed = viewer.isClosed();
+		if(json)
+		{
+			while(viewer.readNext(frame))
+				writeFrameJson(cout, frame);
+		}
+		else if(viewer.readLatest(frame))
+		{
+			clearScreen();
+			printFrame(cout, frame);
+		}
+		if(closed)
+			break;
+		this_thread::sleep_for(interval);
+	}
+
+	(json ? cerr : cout) << viewer.framesRead() << " frames shown, "
+		<< viewer.framesMissed() << " skipped" << endl;
+	return 0;
+}
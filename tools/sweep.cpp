@@ -0,0 +1,302 @@
+// sweep.cpp
+//
+// Balance tuning without playing by hand: plays headless games with
+// the scripted seeker player (MctsPlayer.h) for every configuration
+// of a grid of tunables, or a random sample of it, and prints a table
+// of how each one plays. Each configuration is played in batches on
+// every thread and stops as soon as the 95% confidence interval of
+// its win rate is narrower than -width either side, so clear-cut
+// configurations take a few hundred games and close ones more, up to
+// -max. Every configuration plays the same seeds, so differences
+// between rows come from the tunables and not from luck.
+//
+// Tunables (comma separated lists, every combination is played):
+//   -smell 5,10,15         goblin smell distance
+//   -hitscale 0.8,1,1.2    scale of every monster's hit point range
+//   -monsters 2-6,4-8      monsters on level 0
+//   -perlevel 3,5          monsters added per level
+//   -regen 0.05,0.1        player's chance of healing a turn
+// Tunables not given keep the built-in (or -defs) value.
+//
+// Usage: sweep [tunables] [-sample n] [-width w] [-batch n] [-min n]
+//              [-max n] [-threads n] [-seed n] [-defs file] [-csv file]
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include "GameState.h"
+#include "MctsPlayer.h"
+#include "OutcomeStats.h"
+#include "Definitions.h"
+
+using namespace std;
+
+const int MAXTURNS = 5000;      // Games still going are stopped here
+const double CONFIDENCEZ = 1.96; // 95% confidence intervals
+
+struct Config
+{
+	int smell;
+	double hitScale;
+	int minMonsters, maxMonsters;
+	int monstersPerLevel;
+	double regenChance;
+};
+
+struct Result
+{
+	OutcomeStats stats;
+	double low, high;   // Win rate interval
+	const char* reason; // Why the configuration stopped
+};
+
+static bool parseList(const string& text, vector<double>& values)
+	// Comma separated numbers
+{
+	values.clear();
+	stringstream in(text);
+	string item;
+	while(getline(in, item, ','))
+	{
+		char* end;
+		double value = strtod(item.c_str(), &end);
+		if(item.empty() || *end != '\0') return false;
+		values.push_back(value);
+	}
+	return !values.empty();
+}
+
+static bool parseRanges(const string& text, vector<pair<int, int>>& ranges)
+	// Comma separated low-high ranges (or single numbers)
+{
+	ranges.clear();
+	stringstream in(text);
+	string item;
+	while(getline(in, item, ','))
+	{
+		int low, high;
+		char dash;
+		stringstream range(item);
+		if(!(range >> low)) return false;
+		if(range >> dash)
+		{
+			if(dash != '-' || !(range >> high)) return false;
+		}
+		else high = low;
+		ranges.push_back(make_pair(low, high));
+	}
+	return !ranges.empty();
+}
+
+static bool applyConfig(const Definitions& base, const Config& config)
+	// Put the tables of config in use, false if they are invalid
+{
+	Definitions defs = base;
+	for(int k = 0; k < NUMMONSTERKINDS; k++)
+	{
+		MonsterDef& def = defs.monsters[k];
+		def.minHit = short(max(1L, lround(def.minHit * config.hitScale)));
+		def.maxHit = short(max(long(def.minHit), lround(def.maxHit * config.hitScale)));
+	}
+	defs.minMonsters = config.minMonsters;
+	defs.maxMonsters = config.maxMonsters;
+	defs.monstersPerLevel = config.monstersPerLevel;
+	defs.regenChance = config.regenChance;
+	return setDefinitions(defs);
+}
+
+static void playBatch(uint64_t seed, int smell, int lastGame, atomic<int>* nextGame,
+	OutcomeStats* stats)
+	// Play games numbered up to lastGame until there are none left
+{
+	GameState state;
+	for(;;)
+	{
+		int g = (*nextGame)++;
+		if(g >= lastGame) break;
+
+		state.reset(mixSeed(seed, g), smell);
+		Rng rng(mixSeed(~seed, g)); // The player's own dice
+		while(!state.isOver() && state.turns < MAXTURNS)
+		{
+			PlayerCommand command = seekerCommand(state, rng);
+			state.step(command.command, command.choice);
+		}
+		stats->add(state.outcome());
+	}
+}
+
+static Result runConfig(const Config& config, uint64_t seed, int numThreads,
+	int batchGames, int minGames, int maxGames, double width)
+	// Play batches of games until the win rate is known well enough
+{
+	Result result;
+	for(;;)
+	{
+		int first = int(result.stats.games);
+		int last = min(first + batchGames, maxGames);
+		atomic<int> nextGame(first);
+		vector<OutcomeStats> threadStats(numThreads);
+		vector<thread> workers;
+		for(int t = 0; t < numThreads; t++)
+			workers.push_back(thread(playBatch, seed, config.smell, last, &nextGame,
+				&threadStats[t]));
+		for(int t = 0; t < numThreads; t++)
+		{
+			workers[t].join();
+			result.stats.merge(threadStats[t]);
+		}
+
+		wilsonInterval(result.stats.won, result.stats.games, CONFIDENCEZ,
+			result.low, result.high);
+		if(int(result.stats.games) >= minGames && (result.high - result.low) / 2 <= width)
+		{
+			result.reason = "converged";
+			return result;
+		}
+		if(int(result.stats.games) >= maxGames)
+		{
+			result.reason = "max games";
+			return result;
+		}
+	}
+}
+
+static string configText(const Config& config)
+{
+	ostringstream text;
+	text << config.smell << ' ' << config.hitScale << ' ' << config.minMonsters
+		 << '-' << config.maxMonsters << ' ' << config.monstersPerLevel << ' '
+		 << config.regenChance;
+	return text.str();
+}
+
+int main(int argc, char* argv[])
+{
+	vector<double> smells(1, 15), hitScales(1, 1), perLevels, regens;
+	vector<pair<int, int>> monsterRanges;
+	int sample = 0, batchGames = 200, minGames = 200, maxGames = 20000;
+	int numThreads = thread::hardware_concurrency();
+	double width = 0.01;
+	uint64_t seed = 1;
+	string csvPath;
+	bool ok = true;
+	for(int a = 1; a < argc && ok; a++)
+	{
+		string arg = argv[a];
+		if(a + 1 >= argc) ok = false;
+		else if(arg == "-smell") ok = parseList(argv[++a], smells);
+		else if(arg == "-hitscale") ok = parseList(argv[++a], hitScales);
+		else if(arg == "-monsters") ok = parseRanges(argv[++a], monsterRanges);
+		else if(arg == "-perlevel") ok = parseList(argv[++a], perLevels);
+		else if(arg == "-regen") ok = parseList(argv[++a], regens);
+		else if(arg == "-sample") sample = atoi(argv[++a]);
+		else if(arg == "-width") width = atof(argv[++a]);
+		else if(arg == "-batch") batchGames = atoi(argv[++a]);
+		else if(arg == "-min") minGames = atoi(argv[++a]);
+		else if(arg == "-max") maxGames = atoi(argv[++a]);
+		else if(arg == "-threads") numThreads = atoi(argv[++a]);
+		else if(arg == "-seed") seed = strtoull(argv[++a], nullptr, 10);
+		else if(arg == "-csv") csvPath = argv[++a];
+		else if(arg == "-defs") ok = loadDefinitions(argv[++a]);
+		else ok = false;
+	}
+	if(!ok || batchGames < 1 || maxGames < 1 || width <= 0)
+	{
+		cerr << "Usage: sweep [-smell list] [-hitscale list] [-monsters ranges] [-perlevel list]\n"
+			 << "             [-regen list] [-sample n] [-width w] [-batch n] [-min n] [-max n]\n"
+			 << "             [-threads n] [-seed n] [-defs file] [-csv file]" << endl;
+		return 1;
+	}
+	if(numThreads < 1) numThreads = 1;
+
+	// Tunables not given are the ones in use
+	const Definitions base = definitions();
+	if(monsterRanges.empty()) monsterRanges.push_back(make_pair(base.minMonsters, base.maxMonsters));
+	if(perLevels.empty()) perLevels.push_back(base.monstersPerLevel);
+	if(regens.empty()) regens.push_back(base.regenChance);
+
+	// Every combination, or a random sample of them
+	vector<Config> configs;
+	for(double smell : smells)
+		for(double hitScale : hitScales)
+			for(const pair<int, int>& range : monsterRanges)
+				for(double perLevel : perLevels)
+					for(double regen : regens)
+					{
+						Config config = {int(smell), hitScale, range.first, range.second,
+							int(perLevel), regen};
+						configs.push_back(config);
+					}
+	if(sample > 0 && sample < int(configs.size()))
+	{
+		Rng rng(mixSeed(seed, configs.size()));
+		for(int c = 0; c < sample; c++)
+			swap(configs[c], configs[c + rng.randInt(int(configs.size()) - c)]);
+		configs.resize(sample);
+	}
+
+	ofstream csv;
+	if(!csvPath.empty())
+	{
+		csv.open(csvPath.c_str());
+		if(!csv)
+		{
+			cerr << "Error: Can't write " << csvPath << endl;
+			return 1;
+		}
+		csv << "smell,hitscale,minmonsters,maxmonsters,perlevel,regen,games,won,"
+			<< "winrate,low,high,meandepth,p50turnstodeath,stopped\n";
+	}
+
+	cout << configs.size() << " configurations on " << numThreads << " threads, "
+		 << "win rate to within " << 100 * width << "%\n\n";
+	cout << "smell hitscale monsters perlevel regen        games    win%     low    high"
+		 << "   depth  p50death  stopped\n";
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	uint64_t totalGames = 0;
+	for(size_t c = 0; c < configs.size(); c++)
+	{
+		const Config& config = configs[c];
+		if(!applyConfig(base, config))
+		{
+			cout << configText(config) << "  invalid, skipped" << endl;
+			continue;
+		}
+		Result result = runConfig(config, seed, numThreads, batchGames, minGames, maxGames, width);
+		const OutcomeStats& stats = result.stats;
+		totalGames += stats.games;
+
+		cout << fixed << setprecision(2)
+			 << setw(5) << config.smell << setw(9) << config.hitScale
+			 << setw(6) << config.minMonsters << '-' << left << setw(3) << config.maxMonsters << right
+			 << setw(8) << config.monstersPerLevel << setw(7) << config.regenChance
+			 << setw(12) << stats.games << setw(8) << 100 * stats.winRate()
+			 << setw(8) << 100 * result.low << setw(8) << 100 * result.high
+			 << setw(8) << stats.depthReached.mean()
+			 << setw(10) << setprecision(0) << stats.turnsToDeath.quantile(0.5)
+			 << "  " << result.reason << endl;
+		if(csv.is_open())
+			csv << setprecision(6) << defaultfloat << config.smell << ',' << config.hitScale << ','
+				<< config.minMonsters << ',' << config.maxMonsters << ','
+				<< config.monstersPerLevel << ',' << config.regenChance << ','
+				<< stats.games << ',' << stats.won << ',' << stats.winRate() << ','
+				<< result.low << ',' << result.high << ',' << stats.depthReached.mean() << ','
+				<< stats.turnsToDeath.quantile(0.5) << ',' << result.reason << '\n';
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	cout << defaultfloat << setprecision(6) << '\n' << totalGames << " games played in "
+		 << seconds << " s (" << totalGames / seconds << " games/s)" << endl;
+
+	setDefinitions(base);
+	return 0;
+}
@@ -0,0 +1,120 @@
+// undo_check.cpp
+//
+// Checks that taking turns back with the undo log (UndoLog.h) leaves
+// a game exactly as it was before them: random games are played with
+// the log on, rewound a random number of turns now and then, compared
+// with forks taken along the way (and the hash the game keeps with
+// the one worked out again), then played forward again over the
+// same commands, which must bring the same game back. Measures how
+// long rewinding takes against the alternative of restoring the
+// nearest checkpoint (a fork every CHECKPOINT turns) and playing the
+// turns since again.
+//
+// Usage: undo_check [games] [turns per game] [seed] [-ticks]
+//   -ticks  play real-time ticks instead of turns
+
+#include <iostream>
+#include <cstdlib>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "Game.h"
+#include "GameState.h"
+#include "Rng.h"
+
+using namespace std;
+
+// Commands tried at random (mostly moves)
+const char COMMANDS[] = "hjklhjklhjklhjklgg>wrc";
+
+const int CHECKPOINT = 50; // Turns between checkpoints to replay from
+const int MAXREWIND = 100; // Turns taken back at once, at most
+
+static void play(Game& game, bool ticks, char command, char choice)
+{
+	if(ticks) game.tick(command, choice);
+	else game.step(command, choice);
+}
+
+int main(int argc, char* argv[])
+{
+	vector<string> args;
+	bool ticks = false;
+	for(int a = 1; a < argc; a++)
+	{
+		if(string(argv[a]) == "-ticks") ticks = true;
+		else args.push_back(argv[a]);
+	}
+	int numGames = (args.size() > 0) ? atoi(args[0].c_str()) : 200;
+	int numTurns = (args.size() > 1) ? atoi(args[1].c_str()) : 500;
+	uint64_t seed = (args.size() > 2) ? strtoull(args[2].c_str(), nullptr, 10) : 1;
+
+	Rng rng(seed);
+	long long turns = 0, rewinds = 0, undone = 0, mismatches = 0, replayMismatches = 0;
+	double undoSecs = 0, replaySecs = 0;
+	Game replayer(15, seed); // Rewinds the slow way
+
+	for(int g = 0; g < numGames; g++)
+	{
+		Game game(15, mixSeed(seed, g));
+		game.startUndoLog();
+		vector<GameState> before; // State before each turn
+		vector<char> commands, choices;
+
+		while(int(before.size()) < numTurns && !game.isOver())
+		{
+			char command = COMMANDS[rng.randInt(sizeof(COMMANDS) - 1)];
+			if(command == 'c' && rng.randInt(20) != 0) command = 's'; // Cheat rarely
+			char choice = 'a' + rng.randInt(4);
+
+			before.push_back(game.fork());
+			commands.push_back(command);
+			choices.push_back(choice);
+			play(game, ticks, command, choice);
+			turns++;
+
+			// Now and then (and once the game is over), rewinding
+			if(rng.randInt(20) != 0 && !game.isOver()) continue;
+			int now = before.size();
+			int back = 1 + rng.randInt(min(now, MAXREWIND));
+			int to = now - back;
+			GameState after = game.fork();
+
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			for(int k = 0; k < back; k++)
+				game.undoTurn();
+			undoSecs += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+			// The slow way: the checkpoint, then the turns since
+			start = chrono::steady_clock::now();
+			replayer.restore(before[to - to % CHECKPOINT]);
+			for(int t = to - to % CHECKPOINT; t < to; t++)
+				play(replayer, ticks, commands[t], choices[t]);
+			replaySecs += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+			rewinds++;
+			undone += back;
+			GameState rewound = game.fork();
+			rewound.rehash();
+			if(rewound != before[to] || game.hash() != rewound.hash())
+				mismatches++;
+
+			// The same commands again bring the same game back
+			for(int t = to; t < now; t++)
+				play(game, ticks, commands[t], choices[t]);
+			if(game.fork() != after)
+				replayMismatches++;
+		}
+	}
+
+	cout << numGames << " games, " << turns << (ticks ? " ticks, " : " turns, ")
+		 << rewinds << " rewinds of " << undone << " in all: " << mismatches
+		 << " rewinds that differ, " << replayMismatches
+		 << " replays that differ" << endl;
+	if(undone > 0)
+		cout << "Rewinding a turn: " << undoSecs / undone * 1e6 << " us undone, "
+			 << replaySecs / undone * 1e6 << " us by checkpoint and replay" << endl;
+
+	return (mismatches == 0 && replayMismatches == 0) ? 0 : 1;
+}